@@ -5,6 +5,38 @@
 #include "core/useful.h"
 #include "libs/libs.h"
 
+// Color the screen is cleared to, in RGB
+#define GFX_CLEAR_COLOR 0.f, 0.f, 0.f
+// Rate that window events are polled at, per second; they can't be
+// waited on directly, so this bounds how long input goes unnoticed
+#define GFX_POLL_RATE 100.f
+
+// Backends that gfx can run on
+// A window with a graphics API, through mug
+#define GFX_BACKEND_WINDOW 0
+// No window or graphics API; everything is recorded into memory (see
+// gfx_record), so rendering code runs without a display
+#define GFX_BACKEND_HEADLESS 1
+
+// Commands recorded by the headless backend
+#define GFX_COMMAND_CREATE_OBJECTS 0
+#define GFX_COMMAND_DESTROY_OBJECTS 1
+// Fills and subfills
+#define GFX_COMMAND_FILL_OBJECTS 2
+// Renders and subrenders
+#define GFX_COMMAND_RENDER_OBJECTS 3
+#define GFX_COMMAND_TEXTURE_OBJECTS 4
+#define GFX_COMMAND_SHIFT_OBJECTS 5
+#define GFX_COMMAND_CREATE_TEXTURE 6
+#define GFX_COMMAND_DESTROY_TEXTURE 7
+#define GFX_COMMAND_CLEAR 8
+#define GFX_COMMAND_PRESENT 9
+// Amount of command types
+#define GFX_COMMANDS 10
+// Most commands kept in the record's list; the ones past it are only
+// counted
+#define GFX_RECORD_MAX_COMMANDS 65536
+
 /* Boilerplate variables */
 
 	// Global mug context
@@ -27,11 +59,102 @@
 	// Window keyboard map
 	extern muBool* keyboard;
 
+/* Headless recording */
+
+	// Struct representing a texture of the headless backend
+	struct CyGfxTexture {
+		// Info and dimensions it was created with (depth is 1 if it isn't
+		// an array)
+		mugTextureInfo info;
+		uint32_m dim[3];
+		// Number that no other texture has had, so that it can be told
+		// apart from one made later at the same address
+		uint32_m id;
+		// Copy of its pixels
+		muByte* pixels;
+		// Next texture that hasn't been destroyed
+		struct CyGfxTexture* next;
+	};
+	typedef struct CyGfxTexture CyGfxTexture;
+
+	// Struct representing an object buffer of the headless backend
+	struct CyGfxObjects {
+		// Type, amount and size of the objects
+		mugObjectType type;
+		uint32_m count;
+		size_m objectSize;
+		// Copy of the objects, as they were last filled
+		muByte* objects;
+		// Texture the objects are rendered with; 0 if none
+		CyGfxTexture* texture;
+		// Next object buffer that hasn't been destroyed
+		struct CyGfxObjects* next;
+	};
+	typedef struct CyGfxObjects CyGfxObjects;
+
+	// Struct representing a recorded command
+	struct CyGfxCommand {
+		// Type of command; see GFX_COMMAND_...
+		uint8_m type;
+		// Object type it's for (shifts and object buffer commands)
+		mugObjectType objectType;
+		// Object buffer or texture it's on; 0 if none, or if it's since
+		// been destroyed
+		CyGfxObjects* objects;
+		CyGfxTexture* texture;
+		// Range of objects filled/rendered
+		uint32_m offset;
+		uint32_m count;
+		// Bytes uploaded
+		size_m bytes;
+		// Shift of the object type at the time (renders and shifts)
+		float shift[3];
+	};
+	typedef struct CyGfxCommand CyGfxCommand;
+
+	// Struct representing everything the headless backend was told to do
+	struct CyGfxRecord {
+		// Size of the imaginary window
+		uint32_m width;
+		uint32_m height;
+		// Amount of times each command was issued, bytes uploaded by
+		// fills and texture creations, and objects rendered
+		uint64_m counts[GFX_COMMANDS];
+		uint64_m uploadBytes;
+		uint64_m renderedObjects;
+		// Commands issued since the last clear, in order, up to
+		// GFX_RECORD_MAX_COMMANDS; the rest are only counted as dropped
+		CyGfxCommand* commands;
+		uint32_m numCommands;
+		uint32_m commandCapacity;
+		uint32_m droppedCommands;
+		// Shift of each object type
+		float shifts[MUG_OBJECT_LAST+1][3];
+		// Object buffers and textures that haven't been destroyed, and the
+		// amount of each
+		CyGfxObjects* objects;
+		CyGfxTexture* textures;
+		uint32_m liveObjects;
+		uint32_m liveTextures;
+		// Number of the next texture created
+		uint32_m nextTextureId;
+	};
+	typedef struct CyGfxRecord CyGfxRecord;
+
+	// Backend that gfx is running on; see GFX_BACKEND_...
+	extern uint8_m gfx_backend;
+	// Record of the headless backend
+	extern CyGfxRecord gfx_record;
+
 /* Functions */
 
 	// Initializes gfx
 	void CyGfxInit(void);
 
+	// Initializes gfx without a window, on the headless backend, as if
+	// the window were the given size
+	void CyGfxInitHeadless(uint32_m width, uint32_m height);
+
 	// Terminates gfx
 	void CyGfxTerm(void);
 
@@ -43,5 +166,56 @@
 	void CyGfxClear(void);
 
 	// Calls the general update functions for the gfx
+	// Presents the frame, then waits for and handles events
 	void CyGfxUpdate(void);
 
+	// Presents what's been rendered since the last clear
+	void CyGfxPresent(void);
+
+	// Sleeps until it's time to poll for events again, then handles them
+	// Nothing is presented, so the last frame stays up
+	void CyGfxWait(void);
+
+	// Gets the current time, in seconds
+	// Only meaningful relative to other calls; on the headless backend,
+	// it's the processor time used by the program
+	double CyGfxTime(void);
+
+	// Clears the headless backend's counters and command list; the
+	// object buffers and textures it holds stay
+	void CyGfxResetRecord(void);
+
+/* Objects */
+
+	// These go through mug on the window backend, and are recorded on the
+	// headless backend
+
+	// Creates a buffer of objects of a type, filled with the given objects
+	// Returns 0 on failure
+	mugObjects CyGfxCreateObjects(mugObjectType type, uint32_m count, void* objects);
+	// Destroys a buffer of objects
+	// Returns 0
+	mugObjects CyGfxDestroyObjects(mugObjects objects);
+
+	// Fills all objects in a buffer
+	void CyGfxFillObjects(mugObjects objects, void* data);
+	// Fills a range of objects in a buffer
+	void CyGfxSubfillObjects(mugObjects objects, uint32_m offset, uint32_m count, void* data);
+
+	// Renders all objects in a buffer
+	void CyGfxRenderObjects(mugObjects objects);
+	// Renders a range of objects in a buffer
+	void CyGfxSubrenderObjects(mugObjects objects, uint32_m offset, uint32_m count);
+
+	// Sets the texture that a buffer's objects are rendered with
+	void CyGfxTextureObjects(mugObjects objects, mugTexture texture);
+	// Sets the shift added to the position of every object of a type
+	void CyGfxShiftObjects(mugObjectType type, float shift[3]);
+
+	// Creates a texture from pixels
+	// Returns 0 on failure
+	mugTexture CyGfxCreateTexture(mugTextureInfo* info, uint32_m* dim, muByte* pixels);
+	// Destroys a texture
+	// Returns 0
+	mugTexture CyGfxDestroyTexture(mugTexture texture);
+
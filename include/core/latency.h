@@ -0,0 +1,74 @@
+// latency.h
+// Measures how long input takes to make it through each stage of a frame
+// and onto the screen
+
+#include "libs/libs.h"
+
+// Latencies are counted in buckets of this many seconds; the last bucket
+// holds everything past the others
+#define LATENCY_BUCKET_SECONDS 0.0001
+#define LATENCY_BUCKETS 1000
+
+// Stages of a frame that input goes through, each measured from when the
+// oldest input of the frame was received until it's done
+// Input applied to the file
+#define LATENCY_APPLY 0
+// Editor box laid out
+#define LATENCY_REFRESH 1
+// Changed cells uploaded to the buffers
+#define LATENCY_FILL 2
+// Editor box rendered
+#define LATENCY_RENDER 3
+// Buffers swapped; as close to the screen as can be measured
+#define LATENCY_PRESENT 4
+// Amount of stages
+#define LATENCY_STAGES 5
+
+// Struct representing a histogram of the latencies of a stage
+struct CyLatencyHistogram {
+	// Amount of latencies in each bucket
+	uint32_m buckets[LATENCY_BUCKETS];
+	// Amount of latencies in total
+	uint32_m count;
+	// Sum and maximum of the latencies, in seconds
+	double total;
+	double max;
+};
+typedef struct CyLatencyHistogram CyLatencyHistogram;
+
+// Struct representing the latencies measured so far
+struct CyLatency {
+	// Histogram of each stage
+	CyLatencyHistogram stages[LATENCY_STAGES];
+	// Whether or not a frame's input is being measured, and the time it
+	// was received at
+	muBool measuring;
+	double start;
+};
+typedef struct CyLatency CyLatency;
+
+// Gets the name of a stage
+const char* CyGetLatencyStageName(uint8_m stage);
+
+// Clears all measured latencies
+void CyResetLatency(CyLatency* latency);
+
+// Starts measuring the frame that applies input received at a given time
+void CyBeginLatency(CyLatency* latency, double inputTime);
+// Notes that a stage of the measured frame finished at a given time
+// Does nothing if no frame is being measured; the present stage ends the
+// measurement
+void CyMarkLatency(CyLatency* latency, uint8_m stage, double time);
+
+// Gets a percentile (0 to 1) of a stage's latencies, in seconds
+// Accurate to LATENCY_BUCKET_SECONDS, and never more than the maximum
+double CyGetLatencyPercentile(CyLatency* latency, uint8_m stage, double percentile);
+// Gets the average of a stage's latencies, in seconds
+double CyGetLatencyMean(CyLatency* latency, uint8_m stage);
+
+// Logs p50/p99/max of each stage
+void CyLogLatency(CyLatency* latency);
+// Writes p50/p99/max of each stage, followed by every histogram, as CSV
+// Returns false if the file couldn't be written
+muBool CyWriteLatencyCSV(CyLatency* latency, const char* filename);
+
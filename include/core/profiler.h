@@ -0,0 +1,93 @@
+// profiler.h
+// Times the phases of each frame, keeping the last few frames around for
+// rolling statistics
+// Only built in if CY_PROFILE is defined; otherwise, the macros below
+// compile to nothing, and nothing else here exists
+
+#include "libs/libs.h"
+
+#ifdef CY_PROFILE
+
+	// Amount of frames kept for statistics
+	#define PROFILE_FRAMES 120
+
+	// Phases of a frame
+	// Applying input and scrolling
+	#define PROFILE_INPUT 0
+	// Refreshing the editor box
+	#define PROFILE_REFRESH 1
+	// Updating the HUD showing these statistics
+	#define PROFILE_HUD 2
+	// Clearing the screen
+	#define PROFILE_CLEAR 3
+	// Rendering
+	#define PROFILE_RENDER 4
+	// Swapping buffers
+	#define PROFILE_PRESENT 5
+	// Waiting for and handling events
+	#define PROFILE_WAIT 6
+	// Amount of phases
+	#define PROFILE_PHASES 7
+
+	// Struct representing what a frame did
+	struct CyProfileFrame {
+		// Time spent in each phase, and in the entire frame, in seconds
+		double phases[PROFILE_PHASES];
+		double seconds;
+		// Draw calls made and bytes uploaded
+		uint32_m drawCalls;
+		uint32_m uploadBytes;
+	};
+	typedef struct CyProfileFrame CyProfileFrame;
+
+	// Struct representing a frame profiler
+	struct CyProfiler {
+		// The last frames, in a ring; frame is the one being profiled
+		CyProfileFrame frames[PROFILE_FRAMES];
+		uint32_m frame;
+		// Amount of frames profiled, up to PROFILE_FRAMES
+		uint32_m numFrames;
+		// Time the current frame started at
+		double frameStart;
+	};
+	typedef struct CyProfiler CyProfiler;
+
+	// Initializes a profiler with no frames
+	void CyInitProfiler(CyProfiler* profiler);
+
+	// Starts profiling a frame
+	void CyBeginProfileFrame(CyProfiler* profiler);
+	// Finishes profiling a frame
+	// Frames that didn't draw anything are only idling, and aren't kept
+	void CyEndProfileFrame(CyProfiler* profiler, muBool drew);
+
+	// Gets the time a phase starts at
+	double CyBeginProfilePhase(void);
+	// Adds the time since a phase started to it
+	void CyEndProfilePhase(CyProfiler* profiler, uint8_m phase, double start);
+	// Adds draw calls and uploaded bytes to the current frame
+	void CyCountProfileFrame(CyProfiler* profiler, uint32_m drawCalls, uint32_m uploadBytes);
+
+	// Gets the average and the maximum of each of the kept frames' stats
+	void CyGetProfileStats(CyProfiler* profiler, CyProfileFrame* mean, CyProfileFrame* max);
+
+	// Times the code between these in a phase; they can't be nested for
+	// the same phase in one scope
+	#define CY_PROFILE_BEGIN(profiler, phase) double cyProfile_##phase = CyBeginProfilePhase()
+	#define CY_PROFILE_END(profiler, phase) CyEndProfilePhase(profiler, phase, cyProfile_##phase)
+	// Marks the start and end of a frame
+	#define CY_PROFILE_FRAME_BEGIN(profiler) CyBeginProfileFrame(profiler)
+	#define CY_PROFILE_FRAME_END(profiler, drew) CyEndProfileFrame(profiler, drew)
+	// Counts draw calls and uploaded bytes
+	#define CY_PROFILE_COUNT(profiler, drawCalls, uploadBytes) CyCountProfileFrame(profiler, drawCalls, uploadBytes)
+
+#else
+
+	#define CY_PROFILE_BEGIN(profiler, phase)
+	#define CY_PROFILE_END(profiler, phase)
+	#define CY_PROFILE_FRAME_BEGIN(profiler)
+	#define CY_PROFILE_FRAME_END(profiler, drew)
+	#define CY_PROFILE_COUNT(profiler, drawCalls, uploadBytes)
+
+#endif
+
@@ -16,3 +16,7 @@ uint8_m CyUTF8CodepointDecode(uint32_m* codepoint, muByte* data, uint32_m len);
 // Does not print a log
 uint8_m CyCodepointUTF8Encode(uint32_m codepoint, muByte* data);
 
+// Returns whether or not a codepoint is part of a word
+// (letters, digits, underscores and the marks that attach to them)
+muBool CyIsWordCodepoint(uint32_m codepoint);
+
@@ -0,0 +1,144 @@
+// unicode.h
+// Unicode properties and text segmentation (UAX #29)
+
+#include "libs/libs.h"
+
+/* Properties */
+
+	// Grapheme cluster break values
+	// (Extended_Pictographic is folded in, as it's always Other otherwise)
+	#define GRAPHEME_BREAK_OTHER 0
+	#define GRAPHEME_BREAK_CR 1
+	#define GRAPHEME_BREAK_LF 2
+	#define GRAPHEME_BREAK_CONTROL 3
+	#define GRAPHEME_BREAK_EXTEND 4
+	#define GRAPHEME_BREAK_ZWJ 5
+	#define GRAPHEME_BREAK_REGIONAL_INDICATOR 6
+	#define GRAPHEME_BREAK_PREPEND 7
+	#define GRAPHEME_BREAK_SPACING_MARK 8
+	#define GRAPHEME_BREAK_L 9
+	#define GRAPHEME_BREAK_V 10
+	#define GRAPHEME_BREAK_T 11
+	#define GRAPHEME_BREAK_LV 12
+	#define GRAPHEME_BREAK_LVT 13
+	#define GRAPHEME_BREAK_EXTENDED_PICTOGRAPHIC 14
+
+	// Indic conjunct break values
+	#define INCB_NONE 0
+	#define INCB_CONSONANT 1
+	#define INCB_LINKER 2
+	#define INCB_EXTEND 3
+
+	// Word break values
+	#define WORD_BREAK_OTHER 0
+	#define WORD_BREAK_CR 1
+	#define WORD_BREAK_LF 2
+	#define WORD_BREAK_NEWLINE 3
+	#define WORD_BREAK_EXTEND 4
+	#define WORD_BREAK_ZWJ 5
+	#define WORD_BREAK_REGIONAL_INDICATOR 6
+	#define WORD_BREAK_FORMAT 7
+	#define WORD_BREAK_KATAKANA 8
+	#define WORD_BREAK_HEBREW_LETTER 9
+	#define WORD_BREAK_ALETTER 10
+	#define WORD_BREAK_SINGLE_QUOTE 11
+	#define WORD_BREAK_DOUBLE_QUOTE 12
+	#define WORD_BREAK_MID_NUM_LET 13
+	#define WORD_BREAK_MID_LETTER 14
+	#define WORD_BREAK_MID_NUM 15
+	#define WORD_BREAK_NUMERIC 16
+	#define WORD_BREAK_EXTEND_NUM_LET 17
+	#define WORD_BREAK_WSEG_SPACE 18
+
+	// Display width values; one cell is the default, so that codepoints
+	// without properties pack to 0
+	#define UNICODE_WIDTH_NARROW 0
+	#define UNICODE_WIDTH_WIDE 1
+	#define UNICODE_WIDTH_ZERO 2
+
+	// Packed properties are laid out as:
+	// bits 0-3: grapheme cluster break
+	// bits 4-5: Indic conjunct break
+	// bits 6-10: word break
+	// bit 11: whether or not it's alphabetic or a number
+	// bits 12-13: display width
+	#define UNICODE_GRAPHEME_BREAK(properties) ((properties) & 15)
+	#define UNICODE_INCB(properties) (((properties) >> 4) & 3)
+	#define UNICODE_WORD_BREAK(properties) (((properties) >> 6) & 31)
+	#define UNICODE_ALNUM(properties) (((properties) >> 11) & 1)
+	#define UNICODE_WIDTH(properties) (((properties) >> 12) & 3)
+	// Gets the cells taken up by a display width, by picking the width's
+	// nibble out of 0x021 rather than branching
+	#define UNICODE_WIDTH_CELLS(width) ((0x021 >> ((width) * 4)) & 15)
+
+	// Gets the packed Unicode properties of a codepoint; O(1)
+	// Defined in the generated unicodeTables.c
+	uint16_m CyGetUnicodeProperties(uint32_m codepoint);
+
+	// Gets the amount of cells a codepoint takes up when displayed; 2 for
+	// wide (East Asian Wide and Fullwidth) codepoints, 0 for marks that
+	// combine with the codepoint before them, and 1 otherwise; O(1)
+	uint32_m CyGetCodepointCells(uint32_m codepoint);
+
+/* Segmentation */
+
+	// Struct representing the state carried from codepoint to codepoint
+	// while finding grapheme breaks
+	struct CyGraphemeState {
+		// Whether or not no codepoint has been given yet
+		muBool start;
+		// Properties of the previous codepoint
+		uint16_m prev;
+		// Amount of regional indicators in a row before
+		uint32_m regionalIndicators;
+		// 1 if after Extended_Pictographic Extend*, 2 if after that and a ZWJ
+		uint8_m pictographic;
+		// 1 if after an InCB consonant followed by InCB extends/linkers,
+		// 2 if there was at least one linker among them
+		uint8_m conjunct;
+	};
+	typedef struct CyGraphemeState CyGraphemeState;
+
+	// Struct representing the state carried from codepoint to codepoint
+	// while finding word breaks
+	struct CyWordState {
+		// Whether or not no codepoint has been given yet
+		muBool start;
+		// Properties of the previous codepoint
+		uint16_m prev;
+		// Word break of the previous codepoint, and the one before it,
+		// skipping over Extend, Format and ZWJ
+		uint8_m last;
+		uint8_m beforeLast;
+		// Amount of regional indicators in a row before
+		uint32_m regionalIndicators;
+	};
+	typedef struct CyWordState CyWordState;
+
+	// Resets state to the start of text
+	void CyResetGraphemeState(CyGraphemeState* state);
+	void CyResetWordState(CyWordState* state);
+
+	// Feeds the properties of the next codepoint
+	// Returns whether or not there's a grapheme break before it
+	// (never true for the first codepoint)
+	muBool CyGraphemeBreakBefore(CyGraphemeState* state, uint16_m properties);
+
+	// Returns whether or not a word break property needs the property of the
+	// codepoint after it for CyWordBreakBefore
+	muBool CyWordBreakNeedsNext(uint8_m wordBreak);
+
+	// Feeds the properties of the next codepoint
+	// next is the word break property of the codepoint after it, skipping over
+	// Extend, Format and ZWJ; it's only looked at if CyWordBreakNeedsNext
+	// says so, and should be WORD_BREAK_OTHER at the end of text
+	// Returns whether or not there's a word break before it
+	// (never true for the first codepoint)
+	muBool CyWordBreakBefore(CyWordState* state, uint16_m properties, uint8_m next);
+
+	// Returns whether or not a break before a codepoint is certain no matter
+	// what comes before the codepoint preceding it, meaning segmenting can
+	// safely start over from there
+	muBool CyIsGraphemeSafeBreak(uint16_m prev, uint16_m properties);
+	muBool CyIsWordSafeBreak(uint16_m prev, uint16_m properties);
+
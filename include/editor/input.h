@@ -0,0 +1,72 @@
+// input.h
+// Queues up input events so that they're applied to a chunked file all at
+// once each frame, rather than one by one as they arrive
+
+#include "libs/libs.h"
+
+// Amount of events a queue can hold; a power of 2
+#define INPUT_QUEUE_SIZE 256
+
+// Types of input events; motions and backspaces are done value times, and
+// repeats of them are collapsed into one event
+// Writes/inserts value as a codepoint
+#define INPUT_WRITE 0
+#define INPUT_INSERT 1
+// Backspaces
+#define INPUT_BACKSPACE 2
+// Moves by grapheme clusters
+#define INPUT_LEFT 3
+#define INPUT_RIGHT 4
+// Moves by words
+#define INPUT_WORD_LEFT 5
+#define INPUT_WORD_RIGHT 6
+// Moves by lines
+#define INPUT_UP 7
+#define INPUT_DOWN 8
+// Moves to the start/end of the line or file; repeats are dropped
+#define INPUT_LINE_START 9
+#define INPUT_LINE_END 10
+#define INPUT_START 11
+#define INPUT_END 12
+
+// Struct representing a queued input event
+struct CyInputEvent {
+	// Type of event; see INPUT_...
+	uint8_m type;
+	// Codepoint, or amount of times to do it
+	uint32_m value;
+};
+typedef struct CyInputEvent CyInputEvent;
+
+// Struct representing a queue of input events
+// Window callbacks are called on the main thread while it's handling
+// events, so the queue is only ever pushed to and applied from one thread;
+// it's a plain ring that never locks or allocates
+struct CyInputQueue {
+	// Chunked file that events are applied to
+	struct CyChunkedFile* file;
+	// Queued events are [head, tail), wrapped around the ring
+	CyInputEvent events[INPUT_QUEUE_SIZE];
+	uint32_m head;
+	uint32_m tail;
+	// Amount of events received since the queue was last applied,
+	// before collapsing, and the time the first of them was received at
+	// (see CyGfxTime); the time is kept after applying
+	uint32_m received;
+	double receivedTime;
+};
+typedef struct CyInputQueue CyInputQueue;
+
+// Initializes an empty input queue for a chunked file
+void CyInitInputQueue(CyInputQueue* queue, struct CyChunkedFile* file);
+
+// Queues an input event, collapsing it into the last one if it repeats it
+// If the queue is full, what's queued is applied right away, so nothing
+// is ever dropped
+void CyPushInput(CyInputQueue* queue, uint8_m type, uint32_m value);
+
+// Applies every queued event to the file as one edit transaction
+// Returns the amount of events received since the last call, before
+// collapsing; 0 if nothing happened
+uint32_m CyApplyInput(CyInputQueue* queue);
+
@@ -2,9 +2,37 @@
 // Handles taking raw data and splitting it up into chunks representing a screen buffer, and the management thereof.
 
 #include "libs/libs.h"
+#include "core/unicode.h"
 
 // Amount of codepoints per chunk
 #define FILE_CHUNK_CODEPOINTS 8
+// Maximum amount of change listeners per chunked file
+#define FILE_LISTENERS 8
+// Columns between tab stops by default
+#define FILE_TAB_WIDTH 5
+
+// Struct representing statistics about a span of text
+struct CyTextStats {
+	// Amount of codepoints
+	uint32_m codepoints;
+	// Amount of newlines; the amount of lines is this plus 1
+	uint32_m newlines;
+	// Amount of words (runs of word codepoints)
+	uint32_m words;
+	// Amount of non-ASCII codepoints
+	uint32_m nonASCII;
+	// Columns taken up by the text after the last newline (or all of it if
+	// there's none), with tabs expanded to the file's tab stops, wide
+	// codepoints taking up two and marks none (see CyGetCodepointCells);
+	// since a tab's width depends on where it starts, it's kept as the
+	// columns before the first tab, and the columns after it counted from
+	// the tab stop it goes to
+	// Not kept by CyGetChunkedFileRangeStats
+	uint32_m leadColumns;
+	uint32_m tabColumns;
+	muBool tabbed;
+};
+typedef struct CyTextStats CyTextStats;
 
 // Struct representing a chunk
 typedef struct CyFileChunk CyFileChunk;
@@ -15,6 +43,21 @@ struct CyFileChunk {
 	CyFileChunk* next;
 	// Previous chunk; 0 if this is the first
 	CyFileChunk* prev;
+	// Whether or not this chunk has been touched by
+	// the current edit transaction
+	muBool touched;
+
+	// Index tree links; the chunks also form a treap ordered
+	// the same as the list, used to find chunks by offset or
+	// line in O(log n)
+	CyFileChunk* parent;
+	CyFileChunk* left;
+	CyFileChunk* right;
+	uint32_m priority;
+	// Statistics of this chunk; word counts are of words starting in it
+	CyTextStats stats;
+	// Statistics of this chunk's entire subtree
+	CyTextStats subtree;
 };
 
 // Struct representing an individual slot in a chunk
@@ -28,18 +71,89 @@ struct CyChunkSlot {
 };
 typedef struct CyChunkSlot CyChunkSlot;
 
+// Struct representing an iterator over the grapheme clusters or words
+// of a chunked file; it always sits on a boundary between two of them
+struct CySegmentIterator {
+	// Slot of the codepoint right after the boundary
+	CyChunkSlot slot;
+	// Offset of the boundary, in codepoints
+	uint32_m offset;
+	// Whether or not the boundary is the end of the file
+	muBool end;
+	// Segmentation state, up to and including the slot's codepoint
+	CyGraphemeState grapheme;
+	CyWordState word;
+};
+typedef struct CySegmentIterator CySegmentIterator;
+
+// Struct representing a single coalesced change to a chunked file;
+// the codepoints [offset, offset+removed) of the text before the change
+// were replaced with [offset, offset+inserted) of the text after it
+struct CyEditRange {
+	// Offset of the change, in codepoints
+	uint32_m offset;
+	// Amount of codepoints removed
+	uint32_m removed;
+	// Amount of codepoints inserted
+	uint32_m inserted;
+};
+typedef struct CyEditRange CyEditRange;
+
+typedef struct CyChunkedFile CyChunkedFile;
+
+// Callback for changes made to a chunked file
+// Called once per committed transaction with its coalesced change
+// Must not edit the file itself
+typedef void (*CyChunkedFileListener)(CyChunkedFile* file, CyEditRange* range, void* data);
+
 // Struct representing a chunked file
 struct CyChunkedFile {
 	// Chunks
 	CyFileChunk* chunks;
+	// Root of the chunk index tree
+	CyFileChunk* root;
+	// State for generating index tree priorities
+	uint32_m indexSeed;
 	// Cursor location in file chunk;
 	// codepoints can only be added or removed
 	// relative to the cursor.
 	// Initialized to 0
 	CyFileChunk* cursorChunk;
 	uint32_m cursorIndex;
+	// Cursor location as an offset, in codepoints
+	uint32_m cursorOffset;
+	// Columns between tab stops, which column statistics depend on
+	uint32_m tabWidth;
+	// Column kept when moving up and down, as shown with tabs and wide
+	// codepoints expanded; any other movement, edit or change of tab
+	// width invalidates it
+	uint32_m stickyColumn;
+	muBool stickyValid;
+
+	// Edit transaction depth; 0 if no transaction is open
+	uint32_m editDepth;
+	// Whether or not the current transaction has changed anything
+	muBool editPending;
+	// Coalesced change of the current transaction
+	CyEditRange edit;
+	// Coalesced change of the last committed transaction
+	CyEditRange lastEdit;
+	// Incremented every time a transaction commits a change
+	uint32_m version;
+
+	// Chunks touched by the current transaction
+	CyFileChunk** touched;
+	uint32_m numTouched;
+	uint32_m touchedCapacity;
+	// Whether or not touched chunks couldn't all be tracked;
+	// the whole file is shaken on commit if so
+	muBool touchedOverflow;
+
+	// Change listeners, and the data passed to each
+	CyChunkedFileListener listeners[FILE_LISTENERS];
+	void* listenerData[FILE_LISTENERS];
+	uint32_m numListeners;
 };
-typedef struct CyChunkedFile CyChunkedFile;
 
 // Initializes an empty chunked file
 // Returns false if failed to allocate chunks
@@ -47,6 +161,26 @@ muBool CyCreateEmptyChunkedFile(CyChunkedFile* file);
 // Destroys a chunked file
 void CyDestroyChunkedFile(CyChunkedFile* file);
 
+// Begins an edit transaction
+// Edits made within a transaction are coalesced into one change,
+// and the bookkeeping of the file is only flushed once at commit.
+// Transactions can be nested; only the outermost commit flushes.
+// Every edit function opens its own transaction if none is open.
+void CyBeginEdit(CyChunkedFile* file);
+// Commits an edit transaction
+void CyCommitEdit(CyChunkedFile* file);
+
+// Sets the columns between tab stops, recounting the statistics of every
+// chunk; O(n)
+// Widths of 0 are taken as 1
+void CySetChunkedFileTabWidth(CyChunkedFile* file, uint32_m width);
+
+// Adds a listener that gets called after every committed change
+// Returns false if there are too many listeners
+muBool CyAddChunkedFileListener(CyChunkedFile* file, CyChunkedFileListener listener, void* data);
+// Removes a listener previously added with the same data
+void CyRemoveChunkedFileListener(CyChunkedFile* file, CyChunkedFileListener listener, void* data);
+
 // Moves cursor left n times
 // Simply stops if it can't go any further left
 void CyMoveLeftInChunkedFile(CyChunkedFile* file, uint32_m n);
@@ -54,6 +188,33 @@ void CyMoveLeftInChunkedFile(CyChunkedFile* file, uint32_m n);
 // Simply stops if it can't go any further right
 void CyMoveRightInChunkedFile(CyChunkedFile* file, uint32_m n);
 
+// Moves cursor to the given offset
+// Clamps to the end of the file; O(log n)
+void CySetCursorInChunkedFile(CyChunkedFile* file, uint32_m offset);
+// Moves cursor to the start of its line (Home)
+void CyMoveToLineStartInChunkedFile(CyChunkedFile* file);
+// Moves cursor to the end of its line (End)
+void CyMoveToLineEndInChunkedFile(CyChunkedFile* file);
+// Moves cursor left by a grapheme cluster, so as to not land inside
+// combining sequences and the like
+void CyMoveGraphemeLeftInChunkedFile(CyChunkedFile* file);
+// Moves cursor right by a grapheme cluster
+void CyMoveGraphemeRightInChunkedFile(CyChunkedFile* file);
+// Moves cursor to the start of the previous word (Ctrl+Left)
+void CyMoveWordLeftInChunkedFile(CyChunkedFile* file);
+// Moves cursor to the end of the next word (Ctrl+Right)
+void CyMoveWordRightInChunkedFile(CyChunkedFile* file);
+// Moves cursor up n lines, keeping its column across vertical moves
+// (Up, or PageUp with n being the amount of visible lines)
+void CyMoveUpInChunkedFile(CyChunkedFile* file, uint32_m n);
+// Moves cursor down n lines, keeping its column across vertical moves
+// (Down, or PageDown with n being the amount of visible lines)
+void CyMoveDownInChunkedFile(CyChunkedFile* file, uint32_m n);
+// Moves cursor to the start of the file (Ctrl+Home)
+void CyMoveToStartInChunkedFile(CyChunkedFile* file);
+// Moves cursor to the end of the file (Ctrl+End)
+void CyMoveToEndInChunkedFile(CyChunkedFile* file);
+
 // Inserts codepoint
 muBool CyInsertCodepointInChunkedFile(CyChunkedFile* file, uint32_m codepoint);
 // Backspace a codepoint
@@ -67,7 +228,59 @@ muBool CyGetFirstSlotInChunkedFile(CyChunkedFile* file, CyChunkSlot* slot);
 // Gets the next slot
 // Returns false if no slot
 muBool CyGetNextSlotInChunkedFile(CyChunkSlot* slot);
+// Gets the previous slot
+// Returns false if no slot
+muBool CyGetPrevSlotInChunkedFile(CyChunkSlot* slot);
+// Gets the slot of the codepoint at the given offset; O(log n)
+// Returns false if no slot
+muBool CyGetSlotAtOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset, CyChunkSlot* slot);
+
+// Gets the line the given offset is on, starting at 0; O(log n)
+uint32_m CyGetLineOfOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset);
+// Gets the offset of the start of the given line, starting at 0; O(log n)
+// Clamps to the last line
+uint32_m CyGetLineStartInChunkedFile(CyChunkedFile* file, uint32_m line);
+// Gets the offset of the end of the given line (before its newline); O(log n)
+// Clamps to the last line
+uint32_m CyGetLineEndInChunkedFile(CyChunkedFile* file, uint32_m line);
+// Gets the column of the given offset within its line, with tabs
+// expanded; O(log n) no matter how long the line is
+uint32_m CyGetColumnOfOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset);
+// Gets the offset of the codepoint taking up the given column of a line,
+// with tabs expanded, or of the line's end if it's shorter; O(log n)
+// Sets start to the column the codepoint starts at, which is before the
+// given one if it's a tab or wide codepoint going past it
+// Clamps to the last line
+uint32_m CyGetOffsetOfColumnInChunkedFile(CyChunkedFile* file, uint32_m line, uint32_m column, uint32_m* start);
+
+// Starts iterating over grapheme clusters at the last boundary at or before
+// the given offset
+// O(log n), plus however far back it needs to look to be sure of where
+// clusters start, which is usually only a few codepoints
+void CyBeginGraphemesInChunkedFile(CyChunkedFile* file, uint32_m offset, CySegmentIterator* iter);
+// Moves on to the next grapheme cluster boundary
+// Returns false if already at the end of the file
+muBool CyGetNextGraphemeInChunkedFile(CySegmentIterator* iter);
+// Starts iterating over words at the last boundary at or before the given
+// offset; see CyBeginGraphemesInChunkedFile
+// Words are as in UAX #29, so spaces and punctuation also come as words
+// of their own
+void CyBeginWordsInChunkedFile(CyChunkedFile* file, uint32_m offset, CySegmentIterator* iter);
+// Moves on to the next word boundary
+// Returns false if already at the end of the file
+muBool CyGetNextWordInChunkedFile(CySegmentIterator* iter);
+// Gets the word containing the codepoint at the given offset as [start, end),
+// such as for double-click selection; offsets past the end go for the last word
+// Returns whether or not it's an actual word, rather than spaces or punctuation
+muBool CyGetWordAtOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset, uint32_m* start, uint32_m* end);
 
 // Returns whether or not a given slot is at the cursor
 muBool CyIsSlotAtCursor(CyChunkedFile* file, CyChunkSlot* slot);
 
+// Gets the statistics of the entire file
+// O(1) outside of a transaction
+void CyGetChunkedFileStats(CyChunkedFile* file, CyTextStats* stats);
+// Gets the statistics of the codepoints [start, end), such as a selection
+// O(log n)
+void CyGetChunkedFileRangeStats(CyChunkedFile* file, uint32_m start, uint32_m end, CyTextStats* stats);
+
@@ -8,17 +8,120 @@
 #include "rendering/fonts.h"
 #include "editor/textBuffer.h"
 
+// Changed cells at most this far apart are uploaded as one span
+#define EDITOR_BOX_SPAN_GAP 4
+// Glyph index of cells that draw nothing
+#define EDITOR_BOX_NO_GLYPH 0xFFFFFFFF
+// Glyphs a cell can have at most: its codepoint's and its mark's
+#define EDITOR_BOX_CELL_GLYPHS 2
+// Flag on CyEditorBox.glyphCells for glyphs drawing a cell's mark
+#define EDITOR_BOX_MARK_GLYPH 0x80000000
+// Codepoint of cells covered by the wide codepoint in the cell before them
+#define EDITOR_BOX_COVERED_CELL 0xFFFFFFFE
+// Rects are positioned relative to an anchor line, which is moved to the
+// top line once it's this many lines away, to keep positions precise
+#define EDITOR_BOX_ANCHOR_LINES 1024
+// Rows are counted from here while wrapping, leaving room both ways
+#define EDITOR_BOX_WRAP_ROW_BASE 0x80000000
+// Digits the line-number gutter always has room for, and at most has
+#define EDITOR_BOX_GUTTER_MIN_DIGITS 3
+#define EDITOR_BOX_GUTTER_MAX_DIGITS 10
+
+// Amount of colors in an editor box's palette
+#define EDITOR_BOX_PALETTE_SIZE 16
+// Palette indices cells are colored with by default
+#define EDITOR_BOX_TEXT_COLOR 1
+#define EDITOR_BOX_BACKGROUND_COLOR 0
+// Palette index line numbers are colored with
+#define EDITOR_BOX_GUTTER_COLOR 2
+// Packs the text and background palette indices of a cell
+#define EDITOR_BOX_COLORS(text, background) ((uint8_m)((text) | ((background) << 4)))
+// Gets the text and background palette indices of packed colors
+#define EDITOR_BOX_TEXT(colors) ((colors) & 15)
+#define EDITOR_BOX_BACKGROUND(colors) ((colors) >> 4)
+
 // Struct representing an individual slot in the editor
+// Kept packed so that cells can be compared cheaply; the rects drawn for
+// a slot are derived from it, its index and the line of its row
 struct CyEditorBoxSlot {
-	// Texture index into CyEditorBox.font->textures[]
-	uint16_m texture;
-	// Layer index for the texture
-	uint16_m layer;
-	// Codepoint
+	// Codepoint; EDITOR_BOX_COVERED_CELL if covered by a wide one
 	uint32_m codepoint;
+	// First mark combining with the codepoint (see CyGetCodepointCells);
+	// 0 if none
+	// Its glyph is drawn over the codepoint's, in the same cell
+	uint32_m mark;
+	// Index of the slot's glyph, and of its mark's, within
+	// CyEditorBox.textRects; EDITOR_BOX_NO_GLYPH if blank
+	uint32_m glyph;
+	uint32_m markGlyph;
+	// Packed palette indices; see EDITOR_BOX_COLORS
+	uint8_m colors;
 };
 typedef struct CyEditorBoxSlot CyEditorBoxSlot;
 
+// Struct representing what the last refresh of an editor box did
+struct CyEditorBoxRefreshStats {
+	// Time the refresh took, in seconds, and how much of it was spent
+	// uploading at the end
+	double seconds;
+	double uploadSeconds;
+	// Amount of cells whose contents changed
+	uint32_m changedCells;
+	// Amount of gutter rows whose line numbers were drawn again
+	uint32_m gutterRows;
+	// Amount of spans uploaded, and the bytes uploaded in total
+	uint32_m uploadSpans;
+	uint32_m uploadBytes;
+};
+typedef struct CyEditorBoxRefreshStats CyEditorBoxRefreshStats;
+
+// Struct representing a run of cells of a row that show the same codepoint;
+// rows are laid out into these before their cells are updated, so that
+// blank space, like tabs, is filled a run at a time
+struct CyCellRun {
+	// Codepoint each cell shows, if it's a space (which tabs are laid out
+	// as); otherwise the first cell shows it, covering the rest, as wide
+	// codepoints do
+	uint32_m codepoint;
+	// Mark combining with the codepoint; 0 if none
+	uint32_m mark;
+	// First column of the run within the row, and how many columns it
+	// takes up, which may go past the end of the row
+	uint32_m column;
+	uint32_m columns;
+};
+typedef struct CyCellRun CyCellRun;
+
+// Struct representing how far laying out the rows of an editor box has
+// gotten through the file, and the runs of the row last laid out
+struct CyRowLayout {
+	// Next codepoint, if there's any left
+	CyChunkSlot slot;
+	muBool more;
+	// Offset of the next codepoint, and its column within its line
+	uint32_m offset;
+	uint32_m column;
+	// Line of the row, the column of the line that the row starts at, and
+	// the last line of the file
+	uint32_m line;
+	uint32_m rowStart;
+	uint32_m lastLine;
+	// Whether or not the row's line ended within it
+	muBool lineEnded;
+	// Amount of runs the row was laid out into, in CyEditorBox.runs
+	uint32_m numRuns;
+	// Run that a mark coming next combines with; 0xFFFFFFFF if none, like
+	// at the start of a row
+	uint32_m markRun;
+	// First run holding a codepoint at or after the first changed one,
+	// numRuns if the change was reached after the last run, and
+	// 0xFFFFFFFF if it wasn't reached
+	uint32_m changedRun;
+	// Column of the row that the cursor is at; 0xFFFFFFFF if it's not in it
+	uint32_m cursorColumn;
+};
+typedef struct CyRowLayout CyRowLayout;
+
 // Struct representing an editor box
 struct CyEditorBox {
 	// Respective font; should at least be monospace
@@ -27,23 +130,135 @@ struct CyEditorBox {
 	CyChunkedFile file;
 	// Width and height of entire box, in columns and rows
 	uint32_m textDim[2];
+	// Position of the top left of the box within the window, in pixels;
+	// 0, 0 unless set otherwise after initializing
+	float origin[2];
+	// Width and height the box was last fit into, in pixels; the gutter
+	// takes its columns from this width, leaving the rest to textDim[0]
+	float maxDim[2];
+	// Amount of rows laid out; one more than fits, for the row partially
+	// scrolled into view at the bottom
+	uint32_m numRows;
 
-	// Amount of rects; textDim[0] * textDim[1]
+	// Amount of cells; textDim[0] * numRows
 	uint32_m numRects;
-	// The text texture rects + buffer
+	// Amount of cells and rows that there's room for in the arrays and
+	// buffers below; grown and shrunk geometrically on resizes, so that
+	// dragging a window's edge only reallocates now and then
+	uint32_m rectCapacity;
+	uint32_m rowCapacity;
+	// Glyphs of the non-blank cells and their marks in no particular
+	// order, + buffer; room is kept for EDITOR_BOX_CELL_GLYPHS per cell,
+	// but only the first numGlyphs are drawn
 	mug2DTextureArrayRect* textRects;
 	mugObjects textRectBuf;
-	// Background color rects
+	uint32_m numGlyphs;
+	// Cell that each glyph belongs to, with EDITOR_BOX_MARK_GLYPH set if
+	// it draws the cell's mark
+	uint32_m* glyphCells;
+	// Whether or not each glyph changed since it was last uploaded,
+	// and the range [firstChangedGlyph, lastChangedGlyph) they're within
+	muBool* changedGlyphs;
+	uint32_m firstChangedGlyph;
+	uint32_m lastChangedGlyph;
+	// Background color rects + buffer; one for each run of cells in a row
+	// whose background differs from the clear color, first numBackgrounds
 	mugRect* colRects;
 	mugObjects colRectBuf;
+	uint32_m numBackgrounds;
 
 	// Cursor info
 	uint32_m cursorWidth;
 	mugRect cursorRect;
 	mugObjects cursorRectBuf;
+	// Whether or not the cursor was in view as of the last refresh, and
+	// the column and row of the view it was in if so
+	muBool cursorVisible;
+	uint32_m cursorCell[2];
+
+	// First visible line, and first visible column of each line
+	uint32_m topLine;
+	uint32_m leftColumn;
+	// Row of the top line shown at the top, when wrapping
+	uint32_m topSegment;
+	// Pixels the top line is scrolled out of view by;
+	// always less than the height of a row
+	float scrollPixels;
+	// Top line, first visible column and row of the top line as of the
+	// last refresh
+	uint32_m viewLine;
+	uint32_m viewColumn;
+	uint32_m viewSegment;
+	// Row the top of the view was as of the last refresh; the top line
+	// when not wrapping, and otherwise counted from EDITOR_BOX_WRAP_ROW_BASE
+	// by the rows scrolled, so rows can be told apart like lines can
+	uint32_m viewRow;
+	// Rows are kept in a ring, so that scrolling by a few lines only lays
+	// out and uploads the rows newly scrolled into view; this is the ring
+	// row that the top line is laid out in
+	uint32_m ringTop;
+	// Row (see viewRow) each ring row was laid out for; 0xFFFFFFFF if none
+	uint32_m* rowLines;
+	// Amount of rows, from the top, that were laid out as of the last
+	// refresh; fewer than numRows if the box has grown taller since
+	uint32_m keptRows;
+	// Likewise the amount of columns, from the left; fewer than textDim[0]
+	// if the box has grown wider since
+	uint32_m keptColumns;
+	// Row (see viewRow) that rects are positioned relative to; everything
+	// is shifted into place when rendering
+	uint32_m anchorLine;
+
+	// Whether or not lines longer than the box are wrapped onto the rows
+	// below rather than cut off; see CySetEditorBoxWrap
+	muBool wrap;
+	// Rows each line wraps into, 0 if not worked out yet; kept while
+	// wrapping, and only forgotten for edited lines, or for every line when
+	// the width changes
+	uint32_m* wrapRows;
+	uint32_m numWrapLines;
+	uint32_m wrapCapacity;
+	// Line that rows are next worked out from when idle
+	uint32_m wrapScan;
+
+	// Whether or not line numbers are drawn in a gutter left of the text;
+	// see CySetEditorBoxGutter
+	muBool gutter;
+	// Columns of the gutter: the digits of the last line number, at least
+	// EDITOR_BOX_GUTTER_MIN_DIGITS, and one more to pad it from the text;
+	// 0 until the first refresh with the gutter on
+	uint32_m gutterColumns;
+	// Line number drawn in the gutter of each ring row, 0 if none (like for
+	// the rows a line wraps onto), and 0xFFFFFFFF if not drawn yet; rows
+	// are only drawn again when this or their row changes
+	uint32_m* gutterLines;
+	// Glyph of each digit of the gutter, a row of them for each ring row,
+	// + buffer; room for EDITOR_BOX_GUTTER_MAX_DIGITS of them per row of
+	// rowCapacity, so that the gutter can widen without reallocating
+	mug2DTextureArrayRect* gutterRects;
+	mugObjects gutterRectBuf;
+	// Ring rows [firstGutterRow, lastGutterRow) drawn since the last upload
+	uint32_m firstGutterRow;
+	uint32_m lastGutterRow;
 
 	// Individual slot info
 	CyEditorBoxSlot* slots;
+	// Runs that a row is laid out into; room for one per column, plus
+	// the blank runs at either end
+	CyCellRun* runs;
+	uint32_m runCapacity;
+	// Colors that slots refer to, in RGBA
+	float palette[EDITOR_BOX_PALETTE_SIZE][4];
+	// Whether or not the palette changed since the last refresh
+	muBool paletteChanged;
+
+	// Offset of the first codepoint changed since the last refresh;
+	// 0xFFFFFFFF if the file hasn't changed
+	uint32_m dirtyOffset;
+	// What the last refresh did
+	CyEditorBoxRefreshStats refreshStats;
+	// Amount of draw calls the last render made
+	uint32_m drawCalls;
 };
 typedef struct CyEditorBox CyEditorBox;
 
@@ -56,9 +271,67 @@ muBool CyInitEditorBox(CyEditorBox* box, CyFont* font, float max_width, float ma
 // Logs messages
 void CyDestroyEditorBox(CyEditorBox* box);
 
+// Resizes an editor box to fit a new width and height, the gutter included
+// Cells still in view are kept as they are, and only the ones newly in
+// view are laid out on the next refresh
+// Room is grown and shrunk geometrically, so most resizes don't allocate
+// at all; returns false if the room couldn't be grown, leaving the box as
+// it was
+muBool CyResizeEditorBox(CyEditorBox* box, float max_width, float max_height);
+
 // Renders text box
 void CyRenderEditorBox(CyEditorBox* box);
 
-// Refreshes the editor box to represent the chunked file
+// Refreshes the editor box to represent the visible part of the chunked file
+// Lines longer than the box are cut off, unless wrapping
+// Seeks to the top line in O(log n) and only lays out the visible lines;
+// columns out of view to either side are seeked past in O(log n) too, so
+// very long lines cost no more than short ones
+// Only cells whose contents changed are rewritten and uploaded, and blank
+// cells have no glyph at all; likewise, only gutter rows whose line number
+// changed are drawn again; see box->refreshStats for what was done
 void CyRefreshEditorBox(CyEditorBox* box);
 
+// Scrolls the editor box so that the given line is at the top and the
+// given column is at the left
+// Takes effect on the next refresh; the column is ignored when wrapping
+void CySetEditorBoxView(CyEditorBox* box, uint32_m topLine, uint32_m leftColumn);
+// Scrolls the editor box by an amount of pixels, downward if positive
+// Returns whether or not the top row changed, which takes a refresh;
+// if it didn't, the rows are simply shifted when rendering
+// O(rows scrolled) when wrapping, with the rows of lines cached
+muBool CyScrollEditorBox(CyEditorBox* box, float pixels);
+
+// Turns wrapping long lines onto the rows below on or off
+// Each line is wrapped into (columns / width) + 1 rows, so that there's
+// always room for the cursor at its end
+// Returns false if the rows of each line couldn't be allocated
+muBool CySetEditorBoxWrap(CyEditorBox* box, muBool wrap);
+// Sets the columns between tab stops of the box's file; FILE_TAB_WIDTH
+// by default
+// Everything is laid out again on the next refresh
+void CySetEditorBoxTabWidth(CyEditorBox* box, uint32_m width);
+// Turns the line-number gutter on or off
+// The gutter widens and narrows with the digits of the last line number
+// on refresh, taking its columns from the text's; cells still in view
+// are kept, and only newly shown columns are laid out, unless wrapping,
+// where every line is wrapped again at the new width
+// Returns false if the gutter couldn't be allocated
+muBool CySetEditorBoxGutter(CyEditorBox* box, muBool gutter);
+// Works out the rows of up to maxLines lines that aren't known yet, so
+// that scrolling far later doesn't have to; meant to be called when idle,
+// like after a resize
+// Returns whether or not the rows of every line are known
+muBool CyRewrapEditorBox(CyEditorBox* box, uint32_m maxLines);
+// Sets a color of the editor box's palette, in RGBA
+// Cells using it are recolored on the next refresh
+void CySetEditorBoxColor(CyEditorBox* box, uint8_m index, float r, float g, float b, float a);
+
+// Gets the slot shown at a column and row of the view as of the last
+// refresh; the rows are kept in a ring, so they aren't in order in slots
+CyEditorBoxSlot* CyGetEditorBoxCell(CyEditorBox* box, uint32_m column, uint32_m row);
+
+// Scrolls the editor box as little as possible to bring the cursor into view
+// O(log n), plus the length of the cursor's line up to the cursor
+void CyScrollEditorBoxToCursor(CyEditorBox* box);
+
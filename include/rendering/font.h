@@ -3,27 +3,60 @@
 
 #include "libs/libs.h"
 
-// Each font texture has 256 layers for 256 codepoints
+// Each loaded range holds 256 codepoints
 #define FONT_LAYERS 256
+// The glyphs of a range are laid out in a grid of this many glyphs per side,
+// making up one layer of the font's atlas
+#define FONT_ATLAS_GRID 16
 // Maximum amount of loaded font ranges
 // 256 ranges, 256 characters per range, 65536 max loaded codepoints
 // Max amount of glyphs in a TrueType font is 65536 so this is usually fine
+// (This is also the least amount of texture array layers OpenGL guarantees)
 #define FONT_RANGE_BUF 256
 // Assumed PPI of display
 #define PPI 96.f
 // Rendering method
 #define FONT_RENDER_METHOD MUTTR_FULL_PIXEL_AA8X8
+// Amount of FONT_LAYERS-sized codepoint ranges needed to cover all of Unicode
+#define FONT_RANGE_COUNT (0x110000 / FONT_LAYERS)
+// Texture index of a codepoint range with no texture loaded
+#define FONT_NO_TEXTURE 0xFFFF
+
+// Struct representing where a codepoint's texture layer goes relative to
+// its cell, in pixels, at the font's current point size
+struct CyGlyphMetrics {
+	// Offset of the layer's center from the left of the cell
+	float xOffset;
+	// Offset of the layer's center from the top of the cell
+	float yOffset;
+	// Whether or not the glyph draws nothing, like a space's does
+	muBool blank;
+	// Whether or not the offsets have been calculated yet
+	muBool cached;
+};
+typedef struct CyGlyphMetrics CyGlyphMetrics;
 
 // Struct representing font to be rendered by mug
 struct CyFont {
 	// The TrueType font handle
 	muttFont font;
-	// Amount of textures
+	// Amount of loaded ranges, each being a layer of the atlas
 	uint16_m numTextures;
-	// Texture handles
-	mugTexture textures[FONT_RANGE_BUF];
-	// Unicode beginning ranges for each texture
+	// Texture array holding the glyphs of all loaded ranges, so that any
+	// text can be drawn with it at once; 0 if no ranges are loaded
+	mugTexture atlas;
+	// Pixels of each layer of the atlas, kept to rebuild it with when
+	// another range is loaded
+	muByte* atlasPixels;
+	// Unicode beginning ranges for each atlas layer
 	uint32_m textureStartCodes[FONT_RANGE_BUF];
+	// Atlas layer of each codepoint range; FONT_NO_TEXTURE if not loaded
+	uint16_m rangeTextures[FONT_RANGE_COUNT];
+	// Cached glyph metrics of each codepoint range, allocated on first use;
+	// only valid for the current point size
+	CyGlyphMetrics* rangeMetrics[FONT_RANGE_COUNT];
+	// Metrics handed out when a range's cache couldn't be allocated
+	CyGlyphMetrics uncachedMetrics;
 	// Point size that the textures are rendered at
 	float pointSize;
 	// Width and height of each texture layer
@@ -52,7 +85,7 @@ muBool CyLoadFont(CyFont* font, const char* filename);
 void CyDestroyFont(CyFont* font);
 
 // Sets the point size of a font
-// Also deloads all font layers
+// Also deloads all font layers and clears cached glyph metrics
 void CySetFontPointSize(CyFont* font, float pointSize);
 
 // Loads a codepoint into a font range
@@ -64,11 +97,20 @@ muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint);
 // Sets layer if found
 muBool CyFontIsCodepointLoaded(CyFont* font, uint32_m codepoint, uint16_m* texture, uint16_m* layer);
 
-// Gets the texture and layer of a codepoint
+// Gets the atlas layer of a codepoint's range, and the codepoint's index
+// within the range; O(1)
 // Defaults on missing character
 void CyFontGetTexture(CyFont* font, uint32_m codepoint, uint16_m* texture, uint16_m* layer);
+// Gets the cutout of a codepoint's glyph in the atlas, in texture
+// coordinates, given what CyFontGetTexture gave
+void CyFontGetCutout(uint16_m texture, uint16_m layer, float pos[3], float dim[2]);
 
 // Gets a codepoint from a font
 // Defaults on missing
 uint16_m CyFontGetGlyphID(CyFont* font, uint32_m codepoint);
 
+// Gets the metrics of a codepoint at the current point size
+// Calculated on first use and cached from then on
+// Defaults on missing
+const CyGlyphMetrics* CyFontGetGlyphMetrics(CyFont* font, uint32_m codepoint);
+
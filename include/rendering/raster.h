@@ -0,0 +1,114 @@
+// raster.h
+// Rasterizes the frames recorded by the headless gfx backend into an
+// RGBA framebuffer in memory, redrawing only the tiles that changed
+
+#include "libs/libs.h"
+
+// Width and height of a tile, in pixels
+// Each tile is only redrawn if what's drawn over it changed
+#define RASTER_TILE_SIZE 32
+// Amount of texture cutouts whose opaque part can be remembered; a power
+// of 2
+#define RASTER_TRIM_CACHE 4096
+
+// Struct representing an object flattened for rasterizing, in pixels
+struct CyRasterItem {
+	// Pixels covered, [x0, x1) by [y0, y1), within the framebuffer
+	int32_m x0;
+	int32_m y0;
+	int32_m x1;
+	int32_m y1;
+	// Color, multiplied with the texture if there is one
+	uint8_m color[4];
+	// Pixels and dimensions of the texture layer sampled from, 0 if
+	// there's none, and the texel (16.16 fixed point) at the center of the
+	// first pixel and how far it moves per pixel
+	muByte* pixels;
+	uint32_m texWidth;
+	uint32_m texHeight;
+	int32_m u;
+	int32_m v;
+	int32_m du;
+	int32_m dv;
+	// Hash of everything above that affects what's drawn
+	uint64_m hash;
+};
+typedef struct CyRasterItem CyRasterItem;
+
+// Struct representing the part of a texture cutout that isn't fully
+// transparent, in texels relative to the cutout
+struct CyRasterTrim {
+	// Whether or not this is in use
+	muBool used;
+	// Cutout; texture number, layer, first texel and dimensions
+	uint32_m textureId;
+	uint32_m layer;
+	int32_m texel[2];
+	int32_m dim[2];
+	// Opaque part, [ink[0], ink[2]) by [ink[1], ink[3]); empty if it's
+	// all transparent
+	int32_m ink[4];
+};
+typedef struct CyRasterTrim CyRasterTrim;
+
+// Struct representing a software rasterizer
+struct CyRaster {
+	// Dimensions of the framebuffer, in pixels
+	uint32_m width;
+	uint32_m height;
+	// Framebuffer; RGBA, 8 bits per channel, top row first
+	muByte* pixels;
+
+	// Amount of tiles across and down
+	uint32_m tilesX;
+	uint32_m tilesY;
+	// Hash of what was drawn over each tile last frame
+	uint64_m* tileHashes;
+	// Whether or not the tiles have been drawn at all
+	muBool drawn;
+
+	// Items of the frame, in the order they're drawn
+	CyRasterItem* items;
+	uint32_m numItems;
+	uint32_m itemCapacity;
+	// Indexes of the items over each tile, with tile t's being
+	// [binStarts[t], binStarts[t+1])
+	uint32_m* binStarts;
+	uint32_m* bins;
+	uint32_m binCapacity;
+	// Opaque parts of the texture cutouts seen so far, hashed by cutout
+	CyRasterTrim* trims;
+	uint32_m numTrims;
+
+	// What the last frame did: tiles redrawn, items drawn (over all
+	// redrawn tiles, so items over several are counted more than once),
+	// objects skipped for being of a type that can't be rasterized, and
+	// time taken, in seconds
+	uint32_m dirtyTiles;
+	uint32_m drawnItems;
+	uint32_m skippedObjects;
+	double seconds;
+};
+typedef struct CyRaster CyRaster;
+
+// Initializes a rasterizer with a framebuffer of the given size
+// Returns false if it couldn't be allocated
+muBool CyInitRaster(CyRaster* raster, uint32_m width, uint32_m height);
+// Destroys a rasterizer
+void CyDestroyRaster(CyRaster* raster);
+
+// Makes every tile be redrawn next frame
+void CyInvalidateRaster(CyRaster* raster);
+
+// Rasterizes the frame recorded by the headless backend since its last
+// clear, redrawing only the tiles whose items changed since last frame
+// Should be called once the frame is presented, before anything drawn in
+// it is filled again
+// Rects and texture rects are drawn axis-aligned, with nearest filtering
+// and no wrapping; other objects are skipped
+void CyRasterizeFrame(CyRaster* raster);
+
+// Writes the framebuffer to a binary PPM file, dropping alpha
+// Returns false if the file couldn't be written
+muBool CyWriteRasterPPM(CyRaster* raster, const char* filename);
+
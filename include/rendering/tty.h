@@ -0,0 +1,109 @@
+// tty.h
+// Draws an editor box's cells to a terminal instead of a window, only
+// writing the cells that changed since the last frame, and turns the
+// terminal's key sequences into input events
+
+#include "libs/libs.h"
+
+#include <stdio.h>
+
+// Defined in editor/visualBuffer.h and editor/input.h
+struct CyEditorBox;
+struct CyInputQueue;
+
+// Codepoint of cells whose contents on the terminal aren't known
+#define TTY_UNKNOWN_CELL 0xFFFFFFFF
+// Runs of at least this many of the same cell are written once and then
+// repeated (REP); 0 to never repeat
+#define TTY_REPEAT_MIN 5
+// Rows whose blank end has at least this many changed cells get it
+// erased (EL) instead of written over
+#define TTY_CLEAR_MIN 3
+// Rows with at least this many changed cells are checked for having
+// been shifted along by up to TTY_SHIFT_MAX cells, which is done by
+// inserting or deleting cells (ICH/DCH) instead of writing them all again
+#define TTY_SHIFT_MIN 8
+#define TTY_SHIFT_MAX 8
+// Rows are likewise checked for having been shifted down or up by up to
+// TTY_SHIFT_MAX lines, which is done by inserting or deleting lines
+// (IL/DL) if it saves writing at least this many rows again
+#define TTY_SHIFT_LINES_MIN 2
+// Bytes buffered before they're written to the stream
+#define TTY_BUFFER_SIZE 16384
+// Most bytes of an unfinished key sequence kept between reads
+#define TTY_PENDING_SIZE 16
+
+// Struct representing what's shown in a cell of the terminal
+struct CyTtyCell {
+	// Codepoint; TTY_UNKNOWN_CELL if not known, and
+	// EDITOR_BOX_COVERED_CELL if covered by a wide one
+	uint32_m codepoint;
+	// Mark combining with the codepoint; 0 if none
+	uint32_m mark;
+	// Packed palette indices of the editor box; see EDITOR_BOX_COLORS
+	uint8_m colors;
+};
+typedef struct CyTtyCell CyTtyCell;
+
+// Struct representing a terminal being drawn to
+struct CyTty {
+	// Stream that escape sequences are written to
+	FILE* out;
+	// Dimensions of the terminal, in columns and rows
+	uint32_m columns;
+	uint32_m rows;
+
+	// What was last written to each cell, row by row
+	CyTtyCell* screen;
+	// Where the terminal's cursor is, if known
+	muBool cursorKnown;
+	uint32_m cursorX;
+	uint32_m cursorY;
+	// Whether or not the cursor is shown
+	muBool cursorShown;
+	// Colors last set, if known
+	muBool colorsKnown;
+	uint8_m colors;
+	// View of the box last drawn, if known, so that the terminal can be
+	// scrolled along with it
+	muBool viewKnown;
+	uint32_m topRow;
+	uint32_m leftColumn;
+
+	// Bytes of the frame not yet written to out
+	char buffer[TTY_BUFFER_SIZE];
+	size_m bufferLength;
+
+	// Bytes of input read that don't make up a whole key sequence yet
+	muByte pending[TTY_PENDING_SIZE];
+	uint32_m numPending;
+
+	// Bytes written by the last frame, and by all frames
+	size_m frameBytes;
+	uint64_m totalBytes;
+	uint32_m frames;
+};
+typedef struct CyTty CyTty;
+
+// Initializes a terminal of the given size, writing to a stream
+// Returns false if it couldn't be allocated
+muBool CyInitTty(CyTty* tty, FILE* out, uint32_m columns, uint32_m rows);
+// Destroys a terminal, leaving it with default colors and a shown cursor
+void CyDestroyTty(CyTty* tty);
+
+// Forgets what's on the terminal, so that the next frame clears it and
+// writes every cell
+void CyInvalidateTty(CyTty* tty);
+
+// Writes the cells of an editor box that differ from what the terminal
+// shows, then moves the cursor to the box's
+// The box should be refreshed, and the terminal should be exactly its
+// size; rows scrolled by whole lines are scrolled on the terminal first
+// Every cursor move is made the cheapest way; see tty->frameBytes for how
+// many bytes were written
+void CyDrawTty(CyTty* tty, struct CyEditorBox* box);
+
+// Turns bytes read from the terminal into input events
+// Key sequences cut off at the end are kept until the next call
+void CyReadTtyInput(CyTty* tty, struct CyInputQueue* queue, const muByte* data, uint32_m length);
+
@@ -6,6 +6,11 @@
 #include "core/useful.h"
 #include "libs/libs.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+
 /* Boilerplate variables */
 
 	// Global mug context
@@ -52,10 +57,117 @@
 	// Window keyboard map
 	muBool* keyboard;
 
+	// Backend that gfx is running on
+	uint8_m gfx_backend = GFX_BACKEND_WINDOW;
+	// Record of the headless backend
+	CyGfxRecord gfx_record;
+	// Keyboard map of the headless backend; nothing is ever held
+	muBool headlessKeyboard[MU_KEYBOARD_LENGTH];
+
+/* Inner */
+
+	// Gets the size of an object of a type
+	// Returns 0 for unknown types
+	size_m CyGfxObjectSize(mugObjectType type) {
+		switch (type) {
+			default: return 0; break;
+			case MUG_OBJECT_POINT: return sizeof(mugPoint); break;
+			case MUG_OBJECT_LINE: return sizeof(mugLine); break;
+			case MUG_OBJECT_TRIANGLE: return sizeof(mugTriangle); break;
+			case MUG_OBJECT_RECT: return sizeof(mugRect); break;
+			case MUG_OBJECT_CIRCLE: return sizeof(mugCircle); break;
+			case MUG_OBJECT_SQUIRCLE: return sizeof(mugSquircle); break;
+			case MUG_OBJECT_ROUND_RECT: return sizeof(mugRoundRect); break;
+			case MUG_OBJECT_TEXTURE_2D: return sizeof(mug2DTextureRect); break;
+			case MUG_OBJECT_TEXTURE_2D_ARRAY: return sizeof(mug2DTextureArrayRect); break;
+		}
+	}
+
+	// Gets the size of a texture's pixels
+	size_m CyGfxTextureSize(mugTextureInfo* info, uint32_m* dim) {
+		size_m size = (size_m)dim[0] * (size_m)dim[1];
+		if (info->type == MUG_TEXTURE_2D_ARRAY) {
+			size *= (size_m)dim[2];
+		}
+
+		switch (info->format) {
+			default: case MUG_TEXTURE_U8_R: return size; break;
+			case MUG_TEXTURE_U8_RGB: return size * 3; break;
+			case MUG_TEXTURE_U8_RGBA: return size * 4; break;
+		}
+	}
+
+	// Counts a command on the headless backend, and adds it to the list if
+	// there's room
+	// Returns the command to fill in, or 0 if it was only counted
+	CyGfxCommand* CyGfxRecordCommand(uint8_m type, mugObjectType objectType) {
+		++gfx_record.counts[type];
+
+		if (gfx_record.numCommands == gfx_record.commandCapacity) {
+			if (gfx_record.commandCapacity == GFX_RECORD_MAX_COMMANDS) {
+				++gfx_record.droppedCommands;
+				return 0;
+			}
+			uint32_m capacity = (gfx_record.commandCapacity == 0) ? 256 : gfx_record.commandCapacity * 2;
+			if (capacity > GFX_RECORD_MAX_COMMANDS) {
+				capacity = GFX_RECORD_MAX_COMMANDS;
+			}
+			CyGfxCommand* commands = (CyGfxCommand*)realloc(gfx_record.commands, capacity * sizeof(CyGfxCommand));
+			if (!commands) {
+				++gfx_record.droppedCommands;
+				return 0;
+			}
+			gfx_record.commands = commands;
+			gfx_record.commandCapacity = capacity;
+		}
+
+		CyGfxCommand* command = &gfx_record.commands[gfx_record.numCommands++];
+		memset(command, 0, sizeof(CyGfxCommand));
+		command->type = type;
+		command->objectType = objectType;
+		if (objectType <= MUG_OBJECT_LAST) {
+			memcpy(command->shift, gfx_record.shifts[objectType], sizeof(command->shift));
+		}
+		return command;
+	}
+
+	// Forgets an object buffer or texture in the recorded commands, as
+	// it's being destroyed
+	void CyGfxForgetRecorded(CyGfxObjects* objects, CyGfxTexture* texture) {
+		for (uint32_m i = 0; i < gfx_record.numCommands; ++i) {
+			if (objects && gfx_record.commands[i].objects == objects) {
+				gfx_record.commands[i].objects = 0;
+			}
+			if (texture && gfx_record.commands[i].texture == texture) {
+				gfx_record.commands[i].texture = 0;
+			}
+		}
+	}
+
+	// Frees every object buffer and texture left on the headless backend
+	void CyGfxFreeRecord(void) {
+		while (gfx_record.objects) {
+			CyGfxObjects* next = gfx_record.objects->next;
+			free(gfx_record.objects->objects);
+			free(gfx_record.objects);
+			gfx_record.objects = next;
+		}
+		while (gfx_record.textures) {
+			CyGfxTexture* next = gfx_record.textures->next;
+			free(gfx_record.textures->pixels);
+			free(gfx_record.textures);
+			gfx_record.textures = next;
+		}
+		free(gfx_record.commands);
+		memset(&gfx_record, 0, sizeof(gfx_record));
+	}
+
 /* Functions */
 
 	// Initializes gfx
 	void CyGfxInit(void) {
+		gfx_backend = GFX_BACKEND_WINDOW;
+
 		// Init mug
 		CyLog("Initializing mug...\n");
 		mug_context_create(&mug, window_system, MU_TRUE);
@@ -75,8 +187,40 @@
 		CyLog("\n");
 	}
 
+	// Initializes gfx without a window, on the headless backend
+	void CyGfxInitHeadless(uint32_m width, uint32_m height) {
+		CyLog("Initializing headless gfx as %" PRIu32 "x%" PRIu32 "...\n", width, height);
+		gfx_backend = GFX_BACKEND_HEADLESS;
+		memset(&gfx_record, 0, sizeof(gfx_record));
+		gfx_record.width = width;
+		gfx_record.height = height;
+
+		// Stand in for the window
+		gfx_system_name = "headless";
+		wininfo.width = width;
+		wininfo.height = height;
+		gfx = 0;
+		win = 0;
+		memset(headlessKeyboard, 0, sizeof(headlessKeyboard));
+		keyboard = headlessKeyboard;
+
+		CyLog("\n");
+	}
+
 	// Terminates gfx
 	void CyGfxTerm(void) {
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			// Anything left alive would've leaked on a real graphic
+			if (gfx_record.liveObjects != 0 || gfx_record.liveTextures != 0) {
+				CyLog("%" PRIu32 " object buffers and %" PRIu32 " textures were never destroyed\n", gfx_record.liveObjects, gfx_record.liveTextures);
+			}
+			CyLog("Freeing headless record...\n");
+			CyGfxFreeRecord();
+			gfx_backend = GFX_BACKEND_WINDOW;
+			CyLog("\n");
+			return;
+		}
+
 		CyLog("Destroying graphic...\n");
 		gfx = mu_graphic_destroy(gfx);
 
@@ -96,19 +240,310 @@
 	// Returns whether or not the gfx is still going
 	// AKA whether or not the program should still be running
 	muBool CyGfxExists(void) {
+		// (Nothing closes the headless backend; its users decide when to stop)
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			return MU_TRUE;
+		}
 		return mu_graphic_exists(gfx);
 	}
 
 	// Clears the screen of the gfx
 	void CyGfxClear(void) {
-		mu_graphic_clear(gfx, 0.f, 0.f, 0.f);
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			// The command list only holds the frame being drawn
+			gfx_record.numCommands = 0;
+			gfx_record.droppedCommands = 0;
+			CyGfxRecordCommand(GFX_COMMAND_CLEAR, 0);
+			return;
+		}
+		mu_graphic_clear(gfx, GFX_CLEAR_COLOR);
 	}
 
 	// Calls the general update functions for the gfx
 	void CyGfxUpdate(void) {
+		CyGfxPresent();
+		CyGfxWait();
+	}
+
+	// Presents what's been rendered since the last clear
+	void CyGfxPresent(void) {
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			CyGfxRecordCommand(GFX_COMMAND_PRESENT, 0);
+			return;
+		}
 		// Swap buffers (to present image)
 		mu_graphic_swap_buffers(gfx);
-		// Update graphic at ~100 FPS
-		mu_graphic_update(gfx, 100.f);
+	}
+
+	// Sleeps until it's time to poll for events again, then handles them
+	void CyGfxWait(void) {
+		// (There are no events to wait for on the headless backend)
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			return;
+		}
+		// Update graphic at the poll rate
+		mu_graphic_update(gfx, GFX_POLL_RATE);
+	}
+
+	// Gets the current time, in seconds
+	double CyGfxTime(void) {
+		// (No mug context exists to get the time from on the headless backend)
+		if (gfx_backend == GFX_BACKEND_HEADLESS) {
+			return (double)clock() / (double)CLOCKS_PER_SEC;
+		}
+		return mu_time_get();
+	}
+
+	// Clears the headless backend's counters and command list
+	void CyGfxResetRecord(void) {
+		memset(gfx_record.counts, 0, sizeof(gfx_record.counts));
+		gfx_record.uploadBytes = 0;
+		gfx_record.renderedObjects = 0;
+		gfx_record.numCommands = 0;
+		gfx_record.droppedCommands = 0;
+	}
+
+/* Objects */
+
+	// Creates a buffer of objects of a type, filled with the given objects
+	mugObjects CyGfxCreateObjects(mugObjectType type, uint32_m count, void* objects) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			return mu_gobjects_create(gfx, type, count, objects);
+		}
+
+		size_m objectSize = CyGfxObjectSize(type);
+		if (objectSize == 0) {
+			return 0;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)malloc(sizeof(CyGfxObjects));
+		if (!buffer) {
+			return 0;
+		}
+		buffer->type = type;
+		buffer->count = count;
+		buffer->objectSize = objectSize;
+		buffer->texture = 0;
+		buffer->objects = (muByte*)malloc((count == 0 ? 1 : count) * objectSize);
+		if (!buffer->objects) {
+			free(buffer);
+			return 0;
+		}
+		if (objects) {
+			memcpy(buffer->objects, objects, count * objectSize);
+		}
+
+		buffer->next = gfx_record.objects;
+		gfx_record.objects = buffer;
+		++gfx_record.liveObjects;
+
+		gfx_record.uploadBytes += count * objectSize;
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_CREATE_OBJECTS, type);
+		if (command) {
+			command->objects = buffer;
+			command->count = count;
+			command->bytes = count * objectSize;
+		}
+		return (mugObjects)buffer;
+	}
+
+	// Destroys a buffer of objects
+	mugObjects CyGfxDestroyObjects(mugObjects objects) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			return mu_gobjects_destroy(gfx, objects);
+		}
+		if (!objects) {
+			return 0;
+		}
+
+		// Unlink it from the live buffers
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		CyGfxObjects** link = &gfx_record.objects;
+		while (*link && *link != buffer) {
+			link = &(*link)->next;
+		}
+		if (*link) {
+			*link = buffer->next;
+			--gfx_record.liveObjects;
+		}
+
+		CyGfxForgetRecorded(buffer, 0);
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_DESTROY_OBJECTS, buffer->type);
+		if (command) {
+			command->count = buffer->count;
+		}
+
+		free(buffer->objects);
+		free(buffer);
+		return 0;
+	}
+
+	// Fills all objects in a buffer
+	void CyGfxFillObjects(mugObjects objects, void* data) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobjects_fill(gfx, objects, data);
+			return;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		CyGfxSubfillObjects(objects, 0, buffer->count, data);
+	}
+
+	// Fills a range of objects in a buffer
+	void CyGfxSubfillObjects(mugObjects objects, uint32_m offset, uint32_m count, void* data) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobjects_subfill(gfx, objects, offset, count, data);
+			return;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		if (offset > buffer->count || count > buffer->count - offset) {
+			return;
+		}
+		size_m bytes = count * buffer->objectSize;
+		memcpy(&buffer->objects[offset * buffer->objectSize], data, bytes);
+
+		gfx_record.uploadBytes += bytes;
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_FILL_OBJECTS, buffer->type);
+		if (command) {
+			command->objects = buffer;
+			command->offset = offset;
+			command->count = count;
+			command->bytes = bytes;
+		}
+	}
+
+	// Renders all objects in a buffer
+	void CyGfxRenderObjects(mugObjects objects) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobjects_render(gfx, objects);
+			return;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		CyGfxSubrenderObjects(objects, 0, buffer->count);
+	}
+
+	// Renders a range of objects in a buffer
+	void CyGfxSubrenderObjects(mugObjects objects, uint32_m offset, uint32_m count) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobjects_subrender(gfx, objects, offset, count);
+			return;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		if (offset > buffer->count || count > buffer->count - offset) {
+			return;
+		}
+
+		gfx_record.renderedObjects += count;
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_RENDER_OBJECTS, buffer->type);
+		if (command) {
+			command->objects = buffer;
+			command->texture = buffer->texture;
+			command->offset = offset;
+			command->count = count;
+		}
+	}
+
+	// Sets the texture that a buffer's objects are rendered with
+	void CyGfxTextureObjects(mugObjects objects, mugTexture texture) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobjects_texture(gfx, objects, texture);
+			return;
+		}
+
+		CyGfxObjects* buffer = (CyGfxObjects*)objects;
+		buffer->texture = (CyGfxTexture*)texture;
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_TEXTURE_OBJECTS, buffer->type);
+		if (command) {
+			command->objects = buffer;
+			command->texture = buffer->texture;
+		}
+	}
+
+	// Sets the shift added to the position of every object of a type
+	void CyGfxShiftObjects(mugObjectType type, float shift[3]) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			mu_gobject_mod(gfx, type, MUG_OBJECT_ADD_POS, shift);
+			return;
+		}
+		if (type > MUG_OBJECT_LAST) {
+			return;
+		}
+
+		memcpy(gfx_record.shifts[type], shift, sizeof(gfx_record.shifts[type]));
+		CyGfxRecordCommand(GFX_COMMAND_SHIFT_OBJECTS, type);
+	}
+
+	// Creates a texture from pixels
+	mugTexture CyGfxCreateTexture(mugTextureInfo* info, uint32_m* dim, muByte* pixels) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			return mu_gtexture_create(gfx, info, dim, pixels);
+		}
+
+		CyGfxTexture* texture = (CyGfxTexture*)malloc(sizeof(CyGfxTexture));
+		if (!texture) {
+			return 0;
+		}
+		texture->id = gfx_record.nextTextureId++;
+		texture->info = *info;
+		texture->dim[0] = dim[0];
+		texture->dim[1] = dim[1];
+		texture->dim[2] = (info->type == MUG_TEXTURE_2D_ARRAY) ? dim[2] : 1;
+
+		size_m bytes = CyGfxTextureSize(info, dim);
+		texture->pixels = (muByte*)malloc(bytes == 0 ? 1 : bytes);
+		if (!texture->pixels) {
+			free(texture);
+			return 0;
+		}
+		memcpy(texture->pixels, pixels, bytes);
+
+		texture->next = gfx_record.textures;
+		gfx_record.textures = texture;
+		++gfx_record.liveTextures;
+
+		gfx_record.uploadBytes += bytes;
+		CyGfxCommand* command = CyGfxRecordCommand(GFX_COMMAND_CREATE_TEXTURE, 0);
+		if (command) {
+			command->texture = texture;
+			command->bytes = bytes;
+		}
+		return (mugTexture)texture;
+	}
+
+	// Destroys a texture
+	mugTexture CyGfxDestroyTexture(mugTexture texture) {
+		if (gfx_backend == GFX_BACKEND_WINDOW) {
+			return mu_gtexture_destroy(gfx, texture);
+		}
+		if (!texture) {
+			return 0;
+		}
+
+		// Unlink it from the live textures
+		CyGfxTexture* headless = (CyGfxTexture*)texture;
+		CyGfxTexture** link = &gfx_record.textures;
+		while (*link && *link != headless) {
+			link = &(*link)->next;
+		}
+		if (*link) {
+			*link = headless->next;
+			--gfx_record.liveTextures;
+		}
+
+		// Nothing renders with it anymore
+		for (CyGfxObjects* buffer = gfx_record.objects; buffer; buffer = buffer->next) {
+			if (buffer->texture == headless) {
+				buffer->texture = 0;
+			}
+		}
+		CyGfxForgetRecorded(0, headless);
+		CyGfxRecordCommand(GFX_COMMAND_DESTROY_TEXTURE, 0);
+
+		free(headless->pixels);
+		free(headless);
+		return 0;
 	}
 
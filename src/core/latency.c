@@ -0,0 +1,148 @@
+// latency.c
+// Measures how long input takes to make it through each stage of a frame
+// and onto the screen
+
+#include "core/latency.h"
+#include "core/log.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+/* Inner */
+
+	// Adds a latency to a histogram
+	void CyAddLatency(CyLatencyHistogram* histogram, double seconds) {
+		if (seconds < 0.0) {
+			seconds = 0.0;
+		}
+
+		uint32_m bucket = LATENCY_BUCKETS - 1;
+		if (seconds < LATENCY_BUCKET_SECONDS * (LATENCY_BUCKETS - 1)) {
+			bucket = (uint32_m)(seconds / LATENCY_BUCKET_SECONDS);
+		}
+		++histogram->buckets[bucket];
+
+		++histogram->count;
+		histogram->total += seconds;
+		if (seconds > histogram->max) {
+			histogram->max = seconds;
+		}
+	}
+
+/* Outer */
+
+	// Gets the name of a stage
+	const char* CyGetLatencyStageName(uint8_m stage) {
+		switch (stage) {
+			default: return "unknown"; break;
+			case LATENCY_APPLY: return "apply"; break;
+			case LATENCY_REFRESH: return "refresh"; break;
+			case LATENCY_FILL: return "fill"; break;
+			case LATENCY_RENDER: return "render"; break;
+			case LATENCY_PRESENT: return "present"; break;
+		}
+	}
+
+	// Clears all measured latencies
+	void CyResetLatency(CyLatency* latency) {
+		memset(latency->stages, 0, sizeof(latency->stages));
+		latency->measuring = MU_FALSE;
+		latency->start = 0.0;
+	}
+
+	// Starts measuring the frame that applies input received at a given time
+	void CyBeginLatency(CyLatency* latency, double inputTime) {
+		latency->measuring = MU_TRUE;
+		latency->start = inputTime;
+	}
+
+	// Notes that a stage of the measured frame finished at a given time
+	void CyMarkLatency(CyLatency* latency, uint8_m stage, double time) {
+		if (!latency->measuring || stage >= LATENCY_STAGES) {
+			return;
+		}
+
+		CyAddLatency(&latency->stages[stage], time - latency->start);
+		if (stage == LATENCY_PRESENT) {
+			latency->measuring = MU_FALSE;
+		}
+	}
+
+	// Gets a percentile (0 to 1) of a stage's latencies, in seconds
+	double CyGetLatencyPercentile(CyLatency* latency, uint8_m stage, double percentile) {
+		CyLatencyHistogram* histogram = &latency->stages[stage];
+		if (histogram->count == 0) {
+			return 0.0;
+		}
+
+		// Find the bucket the percentile falls in, and give its upper edge
+		double target = percentile * (double)histogram->count;
+		uint32_m seen = 0;
+		for (uint32_m b = 0; b < LATENCY_BUCKETS; ++b) {
+			seen += histogram->buckets[b];
+			if ((double)seen >= target && seen != 0) {
+				// (The last bucket has no upper edge)
+				if (b == LATENCY_BUCKETS - 1) {
+					return histogram->max;
+				}
+				double seconds = (double)(b + 1) * LATENCY_BUCKET_SECONDS;
+				return (seconds < histogram->max) ? seconds : histogram->max;
+			}
+		}
+		return histogram->max;
+	}
+
+	// Gets the average of a stage's latencies, in seconds
+	double CyGetLatencyMean(CyLatency* latency, uint8_m stage) {
+		CyLatencyHistogram* histogram = &latency->stages[stage];
+		if (histogram->count == 0) {
+			return 0.0;
+		}
+		return histogram->total / (double)histogram->count;
+	}
+
+	// Logs p50/p99/max of each stage
+	void CyLogLatency(CyLatency* latency) {
+		CyLog("Input latency (ms)  %8s %8s %8s  (samples)\n", "p50", "p99", "max");
+		for (uint8_m s = 0; s < LATENCY_STAGES; ++s) {
+			CyLog("  %-17s %8.3f %8.3f %8.3f  (%" PRIu32 ")\n", CyGetLatencyStageName(s),
+				CyGetLatencyPercentile(latency, s, 0.5) * 1000.0,
+				CyGetLatencyPercentile(latency, s, 0.99) * 1000.0,
+				latency->stages[s].max * 1000.0, latency->stages[s].count
+			);
+		}
+	}
+
+	// Writes p50/p99/max of each stage, followed by every histogram, as CSV
+	muBool CyWriteLatencyCSV(CyLatency* latency, const char* filename) {
+		FILE* fptr = fopen(filename, "w");
+		if (!fptr) {
+			return MU_FALSE;
+		}
+
+		// Summary of each stage
+		fprintf(fptr, "stage,samples,mean_ms,p50_ms,p99_ms,max_ms\n");
+		for (uint8_m s = 0; s < LATENCY_STAGES; ++s) {
+			fprintf(fptr, "%s,%" PRIu32 ",%.4f,%.4f,%.4f,%.4f\n", CyGetLatencyStageName(s), latency->stages[s].count,
+				CyGetLatencyMean(latency, s) * 1000.0,
+				CyGetLatencyPercentile(latency, s, 0.5) * 1000.0,
+				CyGetLatencyPercentile(latency, s, 0.99) * 1000.0,
+				latency->stages[s].max * 1000.0
+			);
+		}
+
+		// Non-empty buckets of each stage, by their upper edge
+		fprintf(fptr, "\nstage,bucket_ms,samples\n");
+		for (uint8_m s = 0; s < LATENCY_STAGES; ++s) {
+			for (uint32_m b = 0; b < LATENCY_BUCKETS; ++b) {
+				if (latency->stages[s].buckets[b] != 0) {
+					fprintf(fptr, "%s,%.1f,%" PRIu32 "\n", CyGetLatencyStageName(s), (double)(b + 1) * LATENCY_BUCKET_SECONDS * 1000.0, latency->stages[s].buckets[b]);
+				}
+			}
+		}
+
+		muBool success = !ferror(fptr);
+		fclose(fptr);
+		return success;
+	}
+
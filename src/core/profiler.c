@@ -0,0 +1,107 @@
+// profiler.c
+// Times the phases of each frame, keeping the last few frames around for
+// rolling statistics
+
+#include "core/profiler.h"
+
+#ifdef CY_PROFILE
+
+#include "core/gfx.h"
+
+#include <string.h>
+
+/* Outer */
+
+	// Initializes a profiler with no frames
+	void CyInitProfiler(CyProfiler* profiler) {
+		memset(profiler, 0, sizeof(CyProfiler));
+	}
+
+	// Starts profiling a frame
+	void CyBeginProfileFrame(CyProfiler* profiler) {
+		memset(&profiler->frames[profiler->frame], 0, sizeof(CyProfileFrame));
+		profiler->frameStart = CyGfxTime();
+	}
+
+	// Finishes profiling a frame
+	void CyEndProfileFrame(CyProfiler* profiler, muBool drew) {
+		if (!drew) {
+			return;
+		}
+
+		profiler->frames[profiler->frame].seconds = CyGfxTime() - profiler->frameStart;
+		profiler->frame = (profiler->frame + 1) % PROFILE_FRAMES;
+		if (profiler->numFrames < PROFILE_FRAMES) {
+			++profiler->numFrames;
+		}
+	}
+
+	// Gets the time a phase starts at
+	double CyBeginProfilePhase(void) {
+		return CyGfxTime();
+	}
+
+	// Adds the time since a phase started to it
+	void CyEndProfilePhase(CyProfiler* profiler, uint8_m phase, double start) {
+		profiler->frames[profiler->frame].phases[phase] += CyGfxTime() - start;
+	}
+
+	// Adds draw calls and uploaded bytes to the current frame
+	void CyCountProfileFrame(CyProfiler* profiler, uint32_m drawCalls, uint32_m uploadBytes) {
+		profiler->frames[profiler->frame].drawCalls += drawCalls;
+		profiler->frames[profiler->frame].uploadBytes += uploadBytes;
+	}
+
+	// Gets the average and the maximum of each of the kept frames' stats
+	void CyGetProfileStats(CyProfiler* profiler, CyProfileFrame* mean, CyProfileFrame* max) {
+		memset(mean, 0, sizeof(CyProfileFrame));
+		memset(max, 0, sizeof(CyProfileFrame));
+		if (profiler->numFrames == 0) {
+			return;
+		}
+
+		// Sum up into the mean, divided afterwards
+		// Once the ring is full, the current frame's slot holds the frame still
+		// being profiled, so it's left out
+		uint32_m finished = profiler->numFrames;
+		if (finished == PROFILE_FRAMES) {
+			--finished;
+		}
+		double drawCalls = 0.0, uploadBytes = 0.0;
+		for (uint32_m f = 0; f < profiler->numFrames; ++f) {
+			if (f == profiler->frame) {
+				continue;
+			}
+			CyProfileFrame* frame = &profiler->frames[f];
+			for (uint8_m p = 0; p < PROFILE_PHASES; ++p) {
+				mean->phases[p] += frame->phases[p];
+				if (frame->phases[p] > max->phases[p]) {
+					max->phases[p] = frame->phases[p];
+				}
+			}
+			mean->seconds += frame->seconds;
+			if (frame->seconds > max->seconds) {
+				max->seconds = frame->seconds;
+			}
+
+			drawCalls += (double)frame->drawCalls;
+			uploadBytes += (double)frame->uploadBytes;
+			if (frame->drawCalls > max->drawCalls) {
+				max->drawCalls = frame->drawCalls;
+			}
+			if (frame->uploadBytes > max->uploadBytes) {
+				max->uploadBytes = frame->uploadBytes;
+			}
+		}
+
+		double frames = (double)finished;
+		for (uint8_m p = 0; p < PROFILE_PHASES; ++p) {
+			mean->phases[p] /= frames;
+		}
+		mean->seconds /= frames;
+		mean->drawCalls = (uint32_m)((drawCalls / frames) + 0.5);
+		mean->uploadBytes = (uint32_m)((uploadBytes / frames) + 0.5);
+	}
+
+#endif
+
@@ -2,6 +2,7 @@
 // Used for the logic of Unicode strings
 
 #include "core/string.h"
+#include "core/unicode.h"
 
 // Converts a single UTF-8 portion to a codepoint
 // Returns how much to increment data by; 0 means failed
@@ -117,7 +118,7 @@ uint8_m CyCodepointUTF8Encode(uint32_m codepoint, muByte* data) {
 		// 3-byte
 		case 3: {
 			// 1110xxxx
-			data[0] = (muByte)(((codepoint >> 12) & 15) | 124);
+			data[0] = (muByte)(((codepoint >> 12) & 15) | 224);
 			// 10xxxxxx
 			data[1] = (muByte)(((codepoint >> 6)  & 63) | 128);
 			// 10xxxxxx
@@ -141,3 +142,28 @@ uint8_m CyCodepointUTF8Encode(uint32_m codepoint, muByte* data) {
 	return len;
 }
 
+// Returns whether or not a codepoint is part of a word
+// (letters, digits, underscores and the marks that attach to them)
+muBool CyIsWordCodepoint(uint32_m codepoint) {
+	// ASCII
+	if (codepoint < 128) {
+		return (codepoint >= 0x30 && codepoint <= 0x39) // 0-9
+			|| (codepoint >= 0x41 && codepoint <= 0x5A) // A-Z
+			|| (codepoint >= 0x61 && codepoint <= 0x7A) // a-z
+			|| (codepoint == 0x5F) // _
+		;
+	}
+
+	// Everything else goes by its Unicode properties
+	uint16_m properties = CyGetUnicodeProperties(codepoint);
+	if (UNICODE_ALNUM(properties)) {
+		return MU_TRUE;
+	}
+	switch (UNICODE_WORD_BREAK(properties)) {
+		default: return MU_FALSE;
+		case WORD_BREAK_ALETTER: case WORD_BREAK_HEBREW_LETTER: case WORD_BREAK_KATAKANA:
+		case WORD_BREAK_NUMERIC: case WORD_BREAK_EXTEND_NUM_LET: case WORD_BREAK_EXTEND:
+		case WORD_BREAK_FORMAT: return MU_TRUE;
+	}
+}
+
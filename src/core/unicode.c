@@ -0,0 +1,284 @@
+// unicode.c
+// Unicode properties and text segmentation (UAX #29)
+// The property tables themselves are in the generated unicodeTables.c
+
+#include "core/unicode.h"
+
+// Gets the amount of cells a codepoint takes up when displayed
+uint32_m CyGetCodepointCells(uint32_m codepoint) {
+	// (ASCII is always one cell, and by far the most common)
+	if (codepoint < 0x80) {
+		return 1;
+	}
+	return UNICODE_WIDTH_CELLS(UNICODE_WIDTH(CyGetUnicodeProperties(codepoint)));
+}
+
+// Resets grapheme state to the start of text
+void CyResetGraphemeState(CyGraphemeState* state) {
+	state->start = MU_TRUE;
+	state->prev = 0;
+	state->regionalIndicators = 0;
+	state->pictographic = 0;
+	state->conjunct = 0;
+}
+
+// Resets word state to the start of text
+void CyResetWordState(CyWordState* state) {
+	state->start = MU_TRUE;
+	state->prev = 0;
+	state->last = WORD_BREAK_OTHER;
+	state->beforeLast = WORD_BREAK_OTHER;
+	state->regionalIndicators = 0;
+}
+
+// Feeds the properties of the next codepoint
+// Returns whether or not there's a grapheme break before it
+muBool CyGraphemeBreakBefore(CyGraphemeState* state, uint16_m properties) {
+	uint8_m prev = UNICODE_GRAPHEME_BREAK(state->prev);
+	uint8_m cur = UNICODE_GRAPHEME_BREAK(properties);
+	uint8_m conjunct = UNICODE_INCB(properties);
+
+	// Go through the rules in order; the rule numbers are those of UAX #29
+	muBool result;
+	// GB1
+	if (state->start) {
+		result = MU_FALSE;
+	}
+	// GB3
+	else if (prev == GRAPHEME_BREAK_CR && cur == GRAPHEME_BREAK_LF) {
+		result = MU_FALSE;
+	}
+	// GB4
+	else if (prev == GRAPHEME_BREAK_CR || prev == GRAPHEME_BREAK_LF || prev == GRAPHEME_BREAK_CONTROL) {
+		result = MU_TRUE;
+	}
+	// GB5
+	else if (cur == GRAPHEME_BREAK_CR || cur == GRAPHEME_BREAK_LF || cur == GRAPHEME_BREAK_CONTROL) {
+		result = MU_TRUE;
+	}
+	// GB6
+	else if (prev == GRAPHEME_BREAK_L && (cur == GRAPHEME_BREAK_L || cur == GRAPHEME_BREAK_V || cur == GRAPHEME_BREAK_LV || cur == GRAPHEME_BREAK_LVT)) {
+		result = MU_FALSE;
+	}
+	// GB7
+	else if ((prev == GRAPHEME_BREAK_LV || prev == GRAPHEME_BREAK_V) && (cur == GRAPHEME_BREAK_V || cur == GRAPHEME_BREAK_T)) {
+		result = MU_FALSE;
+	}
+	// GB8
+	else if ((prev == GRAPHEME_BREAK_LVT || prev == GRAPHEME_BREAK_T) && cur == GRAPHEME_BREAK_T) {
+		result = MU_FALSE;
+	}
+	// GB9, GB9a
+	else if (cur == GRAPHEME_BREAK_EXTEND || cur == GRAPHEME_BREAK_ZWJ || cur == GRAPHEME_BREAK_SPACING_MARK) {
+		result = MU_FALSE;
+	}
+	// GB9b
+	else if (prev == GRAPHEME_BREAK_PREPEND) {
+		result = MU_FALSE;
+	}
+	// GB9c
+	else if (state->conjunct == 2 && conjunct == INCB_CONSONANT) {
+		result = MU_FALSE;
+	}
+	// GB11
+	else if (state->pictographic == 2 && cur == GRAPHEME_BREAK_EXTENDED_PICTOGRAPHIC) {
+		result = MU_FALSE;
+	}
+	// GB12, GB13
+	else if (cur == GRAPHEME_BREAK_REGIONAL_INDICATOR && (state->regionalIndicators & 1)) {
+		result = MU_FALSE;
+	}
+	// GB999
+	else {
+		result = MU_TRUE;
+	}
+
+	// Update state
+	state->start = MU_FALSE;
+	state->prev = properties;
+	state->regionalIndicators = (cur == GRAPHEME_BREAK_REGIONAL_INDICATOR) ? (state->regionalIndicators + 1) : 0;
+
+	if (cur == GRAPHEME_BREAK_EXTENDED_PICTOGRAPHIC) {
+		state->pictographic = 1;
+	} else if (cur == GRAPHEME_BREAK_EXTEND && state->pictographic == 1) {
+		state->pictographic = 1;
+	} else if (cur == GRAPHEME_BREAK_ZWJ && state->pictographic == 1) {
+		state->pictographic = 2;
+	} else {
+		state->pictographic = 0;
+	}
+
+	if (conjunct == INCB_CONSONANT) {
+		state->conjunct = 1;
+	} else if (conjunct == INCB_LINKER && state->conjunct != 0) {
+		state->conjunct = 2;
+	} else if (conjunct != INCB_EXTEND) {
+		state->conjunct = 0;
+	}
+
+	return result;
+}
+
+// Returns whether or not a word break property is AHLetter
+muBool CyIsAHLetter(uint8_m wordBreak) {
+	return wordBreak == WORD_BREAK_ALETTER || wordBreak == WORD_BREAK_HEBREW_LETTER;
+}
+
+// Returns whether or not a word break property is MidLetter or MidNumLetQ
+muBool CyIsMidLetter(uint8_m wordBreak) {
+	return wordBreak == WORD_BREAK_MID_LETTER || wordBreak == WORD_BREAK_MID_NUM_LET || wordBreak == WORD_BREAK_SINGLE_QUOTE;
+}
+
+// Returns whether or not a word break property is MidNum or MidNumLetQ
+muBool CyIsMidNum(uint8_m wordBreak) {
+	return wordBreak == WORD_BREAK_MID_NUM || wordBreak == WORD_BREAK_MID_NUM_LET || wordBreak == WORD_BREAK_SINGLE_QUOTE;
+}
+
+// Returns whether or not a word break property needs the property of the
+// codepoint after it for CyWordBreakBefore
+muBool CyWordBreakNeedsNext(uint8_m wordBreak) {
+	return CyIsMidLetter(wordBreak) || CyIsMidNum(wordBreak) || wordBreak == WORD_BREAK_DOUBLE_QUOTE;
+}
+
+// Feeds the properties of the next codepoint
+// Returns whether or not there's a word break before it
+muBool CyWordBreakBefore(CyWordState* state, uint16_m properties, uint8_m next) {
+	uint8_m prev = UNICODE_WORD_BREAK(state->prev);
+	uint8_m cur = UNICODE_WORD_BREAK(properties);
+	uint8_m last = state->last;
+	uint8_m beforeLast = state->beforeLast;
+	muBool prevNewline = prev == WORD_BREAK_CR || prev == WORD_BREAK_LF || prev == WORD_BREAK_NEWLINE;
+
+	// Go through the rules in order; the rule numbers are those of UAX #29
+	muBool result;
+	// WB1
+	if (state->start) {
+		result = MU_FALSE;
+	}
+	// WB3
+	else if (prev == WORD_BREAK_CR && cur == WORD_BREAK_LF) {
+		result = MU_FALSE;
+	}
+	// WB3a
+	else if (prevNewline) {
+		result = MU_TRUE;
+	}
+	// WB3b
+	else if (cur == WORD_BREAK_CR || cur == WORD_BREAK_LF || cur == WORD_BREAK_NEWLINE) {
+		result = MU_TRUE;
+	}
+	// WB3c
+	else if (prev == WORD_BREAK_ZWJ && UNICODE_GRAPHEME_BREAK(properties) == GRAPHEME_BREAK_EXTENDED_PICTOGRAPHIC) {
+		result = MU_FALSE;
+	}
+	// WB3d
+	else if (prev == WORD_BREAK_WSEG_SPACE && cur == WORD_BREAK_WSEG_SPACE) {
+		result = MU_FALSE;
+	}
+	// WB4; these are treated as whatever came before them from here on
+	else if (cur == WORD_BREAK_EXTEND || cur == WORD_BREAK_FORMAT || cur == WORD_BREAK_ZWJ) {
+		state->prev = properties;
+		return MU_FALSE;
+	}
+	// WB5
+	else if (CyIsAHLetter(last) && CyIsAHLetter(cur)) {
+		result = MU_FALSE;
+	}
+	// WB6
+	else if (CyIsAHLetter(last) && CyIsMidLetter(cur) && CyIsAHLetter(next)) {
+		result = MU_FALSE;
+	}
+	// WB7
+	else if (CyIsAHLetter(beforeLast) && CyIsMidLetter(last) && CyIsAHLetter(cur)) {
+		result = MU_FALSE;
+	}
+	// WB7a
+	else if (last == WORD_BREAK_HEBREW_LETTER && cur == WORD_BREAK_SINGLE_QUOTE) {
+		result = MU_FALSE;
+	}
+	// WB7b
+	else if (last == WORD_BREAK_HEBREW_LETTER && cur == WORD_BREAK_DOUBLE_QUOTE && next == WORD_BREAK_HEBREW_LETTER) {
+		result = MU_FALSE;
+	}
+	// WB7c
+	else if (beforeLast == WORD_BREAK_HEBREW_LETTER && last == WORD_BREAK_DOUBLE_QUOTE && cur == WORD_BREAK_HEBREW_LETTER) {
+		result = MU_FALSE;
+	}
+	// WB8, WB9, WB10
+	else if ((CyIsAHLetter(last) || last == WORD_BREAK_NUMERIC) && (CyIsAHLetter(cur) || cur == WORD_BREAK_NUMERIC)) {
+		result = MU_FALSE;
+	}
+	// WB11
+	else if (beforeLast == WORD_BREAK_NUMERIC && CyIsMidNum(last) && cur == WORD_BREAK_NUMERIC) {
+		result = MU_FALSE;
+	}
+	// WB12
+	else if (last == WORD_BREAK_NUMERIC && CyIsMidNum(cur) && next == WORD_BREAK_NUMERIC) {
+		result = MU_FALSE;
+	}
+	// WB13
+	else if (last == WORD_BREAK_KATAKANA && cur == WORD_BREAK_KATAKANA) {
+		result = MU_FALSE;
+	}
+	// WB13a
+	else if ((CyIsAHLetter(last) || last == WORD_BREAK_NUMERIC || last == WORD_BREAK_KATAKANA || last == WORD_BREAK_EXTEND_NUM_LET) && cur == WORD_BREAK_EXTEND_NUM_LET) {
+		result = MU_FALSE;
+	}
+	// WB13b
+	else if (last == WORD_BREAK_EXTEND_NUM_LET && (CyIsAHLetter(cur) || cur == WORD_BREAK_NUMERIC || cur == WORD_BREAK_KATAKANA)) {
+		result = MU_FALSE;
+	}
+	// WB15, WB16
+	else if (last == WORD_BREAK_REGIONAL_INDICATOR && cur == WORD_BREAK_REGIONAL_INDICATOR && (state->regionalIndicators & 1)) {
+		result = MU_FALSE;
+	}
+	// WB999
+	else {
+		result = MU_TRUE;
+	}
+
+	// Update state
+	state->start = MU_FALSE;
+	state->prev = properties;
+	state->regionalIndicators = (cur == WORD_BREAK_REGIONAL_INDICATOR) ? ((last == WORD_BREAK_REGIONAL_INDICATOR) ? (state->regionalIndicators + 1) : 1) : 0;
+	state->beforeLast = last;
+	state->last = cur;
+	return result;
+}
+
+// Returns whether or not a grapheme break before a codepoint is certain no
+// matter what comes before the codepoint preceding it
+muBool CyIsGraphemeSafeBreak(uint16_m prev, uint16_m properties) {
+	uint8_m cur = UNICODE_GRAPHEME_BREAK(properties);
+	if (cur == GRAPHEME_BREAK_CONTROL || cur == GRAPHEME_BREAK_CR) {
+		return MU_TRUE;
+	}
+	// Other codepoints only join with a preceding Prepend, save for
+	// conjunct consonants; they also end any run the rules keep track of
+	return cur == GRAPHEME_BREAK_OTHER && UNICODE_INCB(properties) != INCB_CONSONANT
+		&& UNICODE_GRAPHEME_BREAK(prev) != GRAPHEME_BREAK_PREPEND;
+}
+
+// Returns whether or not a word break before a codepoint is certain no matter
+// what comes before the codepoint preceding it
+muBool CyIsWordSafeBreak(uint16_m prev, uint16_m properties) {
+	uint8_m before = UNICODE_WORD_BREAK(prev);
+	uint8_m cur = UNICODE_WORD_BREAK(properties);
+
+	// Around newlines
+	if (before == WORD_BREAK_CR && cur == WORD_BREAK_LF) {
+		return MU_FALSE;
+	}
+	if (before == WORD_BREAK_CR || before == WORD_BREAK_LF || before == WORD_BREAK_NEWLINE) {
+		return MU_TRUE;
+	}
+	if (cur == WORD_BREAK_CR || cur == WORD_BREAK_LF || cur == WORD_BREAK_NEWLINE) {
+		return MU_TRUE;
+	}
+
+	// After a space, as nothing joins onto one other than more spaces and
+	// the codepoints ignored by WB4
+	return before == WORD_BREAK_WSEG_SPACE && cur != WORD_BREAK_WSEG_SPACE
+		&& cur != WORD_BREAK_EXTEND && cur != WORD_BREAK_FORMAT && cur != WORD_BREAK_ZWJ;
+}
+
@@ -0,0 +1,120 @@
+// input.c
+// Queues up input events so that they're applied to a chunked file all at
+// once each frame, rather than one by one as they arrive
+
+#include "editor/textBuffer.h"
+#include "editor/input.h"
+#include "core/gfx.h"
+
+/* Inner */
+
+	// Applies a single event to a chunked file
+	void CyApplyInputEvent(CyChunkedFile* file, CyInputEvent* event) {
+		switch (event->type) {
+			default: break;
+
+			case INPUT_WRITE: CyWriteCodepointInChunkedFile(file, event->value); break;
+			case INPUT_INSERT: CyInsertCodepointInChunkedFile(file, event->value); break;
+			case INPUT_BACKSPACE: {
+				for (uint32_m i = 0; i < event->value; ++i) {
+					CyBackspaceCodepointInChunkedFile(file);
+				}
+			} break;
+
+			case INPUT_LEFT: {
+				for (uint32_m i = 0; i < event->value; ++i) {
+					CyMoveGraphemeLeftInChunkedFile(file);
+				}
+			} break;
+			case INPUT_RIGHT: {
+				for (uint32_m i = 0; i < event->value; ++i) {
+					CyMoveGraphemeRightInChunkedFile(file);
+				}
+			} break;
+			case INPUT_WORD_LEFT: {
+				for (uint32_m i = 0; i < event->value; ++i) {
+					CyMoveWordLeftInChunkedFile(file);
+				}
+			} break;
+			case INPUT_WORD_RIGHT: {
+				for (uint32_m i = 0; i < event->value; ++i) {
+					CyMoveWordRightInChunkedFile(file);
+				}
+			} break;
+			case INPUT_UP: CyMoveUpInChunkedFile(file, event->value); break;
+			case INPUT_DOWN: CyMoveDownInChunkedFile(file, event->value); break;
+
+			case INPUT_LINE_START: CyMoveToLineStartInChunkedFile(file); break;
+			case INPUT_LINE_END: CyMoveToLineEndInChunkedFile(file); break;
+			case INPUT_START: CyMoveToStartInChunkedFile(file); break;
+			case INPUT_END: CyMoveToEndInChunkedFile(file); break;
+		}
+	}
+
+	// Applies every queued event as one edit transaction
+	void CyFlushInputQueue(CyInputQueue* queue) {
+		if (queue->head == queue->tail) {
+			return;
+		}
+
+		CyBeginEdit(queue->file);
+		for (; queue->head != queue->tail; ++queue->head) {
+			CyApplyInputEvent(queue->file, &queue->events[queue->head % INPUT_QUEUE_SIZE]);
+		}
+		CyCommitEdit(queue->file);
+	}
+
+/* Outer */
+
+	// Initializes an empty input queue for a chunked file
+	void CyInitInputQueue(CyInputQueue* queue, struct CyChunkedFile* file) {
+		queue->file = file;
+		queue->head = queue->tail = 0;
+		queue->received = 0;
+		queue->receivedTime = 0.0;
+	}
+
+	// Queues an input event, collapsing it into the last one if it repeats it
+	void CyPushInput(CyInputQueue* queue, uint8_m type, uint32_m value) {
+		// Note when input started coming in
+		if (queue->received == 0) {
+			queue->receivedTime = CyGfxTime();
+		}
+		++queue->received;
+
+		// Repeats of the last event can often be done in one go
+		if (queue->head != queue->tail) {
+			CyInputEvent* last = &queue->events[(queue->tail - 1) % INPUT_QUEUE_SIZE];
+			if (last->type == type) {
+				// Motions and backspaces are done value times, so they add up
+				if (type == INPUT_BACKSPACE || (type >= INPUT_LEFT && type <= INPUT_DOWN)) {
+					last->value += value;
+					return;
+				}
+				// Moving to the start/end of something again changes nothing
+				if (type >= INPUT_LINE_START) {
+					return;
+				}
+			}
+		}
+
+		// Make room if needed
+		if (queue->tail - queue->head == INPUT_QUEUE_SIZE) {
+			CyFlushInputQueue(queue);
+		}
+
+		CyInputEvent* event = &queue->events[queue->tail % INPUT_QUEUE_SIZE];
+		event->type = type;
+		event->value = value;
+		++queue->tail;
+	}
+
+	// Applies every queued event to the file as one edit transaction
+	uint32_m CyApplyInput(CyInputQueue* queue) {
+		CyFlushInputQueue(queue);
+
+		uint32_m received = queue->received;
+		queue->received = 0;
+		return received;
+	}
+
@@ -10,6 +10,7 @@
 // after it.
 
 #include "editor/textBuffer.h"
+#include "core/string.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -18,16 +19,444 @@
 
 /* Inner functions */
 
-	// Destroys all chunks recursively
+	// Destroys all chunks
 	void CyDestroyEachChunk(CyFileChunk* chunk) {
-		// If another chunk still exists, fall into that
+		// Walk the list rather than recursing; large files
+		// have far too many chunks for the stack
+		while (chunk) {
+			CyFileChunk* next = chunk->next;
+			// Deallocate this chunk
+			free(chunk);
+			chunk = next;
+		}
+	}
+
+	// Gets the column a tab starting at the given column goes to
+	uint32_m CyNextTabStop(CyChunkedFile* file, uint32_m column) {
+		return ((column / file->tabWidth) + 1) * file->tabWidth;
+	}
+
+	// Gets the column that text with the given statistics ends at, if it
+	// starts at the start of a line
+	uint32_m CyStatsColumn(CyChunkedFile* file, CyTextStats* stats) {
+		if (stats->tabbed) {
+			return CyNextTabStop(file, stats->leadColumns) + stats->tabColumns;
+		}
+		return stats->leadColumns;
+	}
+
+	// Adds b's statistics onto a's, with b's text coming right after a's
+	void CyAddStats(CyChunkedFile* file, CyTextStats* a, CyTextStats* b) {
+		// Only the columns after b's last newline count if it has one
+		if (b->newlines != 0) {
+			a->leadColumns = b->leadColumns;
+			a->tabColumns = b->tabColumns;
+			a->tabbed = b->tabbed;
+		}
+		// Otherwise b's columns carry on from a's
+		else if (!b->tabbed) {
+			if (a->tabbed) {
+				a->tabColumns += b->leadColumns;
+			} else {
+				a->leadColumns += b->leadColumns;
+			}
+		}
+		else if (a->tabbed) {
+			a->tabColumns = CyNextTabStop(file, a->tabColumns + b->leadColumns) + b->tabColumns;
+		}
+		else {
+			a->leadColumns += b->leadColumns;
+			a->tabColumns = b->tabColumns;
+			a->tabbed = MU_TRUE;
+		}
+
+		a->codepoints += b->codepoints;
+		a->newlines += b->newlines;
+		a->words += b->words;
+		a->nonASCII += b->nonASCII;
+	}
+
+	// Subtracts b's statistics from a's
+	// (Columns can't be taken back off, so a's are left as they are)
+	void CySubtractStats(CyTextStats* a, CyTextStats* b) {
+		a->codepoints -= b->codepoints;
+		a->newlines -= b->newlines;
+		a->words -= b->words;
+		a->nonASCII -= b->nonASCII;
+	}
+
+	// Adds a codepoint onto statistics, given the codepoint before it (0 if none)
+	void CyCountCodepoint(CyChunkedFile* file, CyTextStats* stats, uint32_m codepoint, uint32_m prev) {
+		++stats->codepoints;
+		if (codepoint == 13) {
+			++stats->newlines;
+			stats->leadColumns = stats->tabColumns = 0;
+			stats->tabbed = MU_FALSE;
+		}
+		// Tabs go to the next tab stop
+		else if (codepoint == 9) {
+			if (stats->tabbed) {
+				stats->tabColumns = CyNextTabStop(file, stats->tabColumns);
+			} else {
+				stats->tabColumns = 0;
+				stats->tabbed = MU_TRUE;
+			}
+		}
+		// Wide codepoints take up two columns, and marks none
+		else if (stats->tabbed) {
+			stats->tabColumns += CyGetCodepointCells(codepoint);
+		} else {
+			stats->leadColumns += CyGetCodepointCells(codepoint);
+		}
+		if (codepoint > 127) {
+			++stats->nonASCII;
+		}
+		// A word starts at a word codepoint not preceded by one
+		if (CyIsWordCodepoint(codepoint) && (prev == 0 || !CyIsWordCodepoint(prev))) {
+			++stats->words;
+		}
+	}
+
+	// Gets the last codepoint before a chunk; 0 if none
+	uint32_m CyCodepointBeforeChunk(CyFileChunk* chunk) {
+		for (chunk = chunk->prev; chunk; chunk = chunk->prev) {
+			for (uint32_m c = FILE_CHUNK_CODEPOINTS; c > 0; --c) {
+				if (chunk->data[c-1] != 0) {
+					return chunk->data[c-1];
+				}
+			}
+		}
+		return 0;
+	}
+
+	// Generates a random priority for the index tree (xorshift)
+	uint32_m CyIndexPriority(CyChunkedFile* file) {
+		uint32_m x = file->indexSeed;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		file->indexSeed = x;
+		return x;
+	}
+
+	// Recomputes the subtree statistics of a chunk from its children
+	// (In order, since columns depend on what comes before them)
+	void CyIndexPull(CyChunkedFile* file, CyFileChunk* chunk) {
+		if (chunk->left) {
+			chunk->subtree = chunk->left->subtree;
+			CyAddStats(file, &chunk->subtree, &chunk->stats);
+		} else {
+			chunk->subtree = chunk->stats;
+		}
+		if (chunk->right) {
+			CyAddStats(file, &chunk->subtree, &chunk->right->subtree);
+		}
+	}
+
+	// Recomputes subtree statistics from a chunk up to the root
+	void CyIndexPullPath(CyChunkedFile* file, CyFileChunk* chunk) {
+		while (chunk) {
+			CyIndexPull(file, chunk);
+			chunk = chunk->parent;
+		}
+	}
+
+	// Recomputes the subtree statistics of every chunk in a subtree,
+	// children first; O(n) for the whole tree
+	void CyIndexPullAll(CyChunkedFile* file, CyFileChunk* chunk) {
+		if (!chunk) {
+			return;
+		}
+		CyIndexPullAll(file, chunk->left);
+		CyIndexPullAll(file, chunk->right);
+		CyIndexPull(file, chunk);
+	}
+
+	// Replaces a child of parent (or the root if parent is 0)
+	void CyIndexReplaceChild(CyChunkedFile* file, CyFileChunk* parent, CyFileChunk* oldChild, CyFileChunk* newChild) {
+		if (!parent) {
+			file->root = newChild;
+		} else if (parent->left == oldChild) {
+			parent->left = newChild;
+		} else {
+			parent->right = newChild;
+		}
+		if (newChild) {
+			newChild->parent = parent;
+		}
+	}
+
+	// Rotates a chunk above its parent in the index tree
+	void CyIndexRotateUp(CyChunkedFile* file, CyFileChunk* chunk) {
+		CyFileChunk* parent = chunk->parent;
+		CyIndexReplaceChild(file, parent->parent, parent, chunk);
+
+		// If chunk is the left child, its right subtree becomes
+		// parent's left subtree, and parent becomes its right child
+		if (parent->left == chunk) {
+			parent->left = chunk->right;
+			if (chunk->right) {
+				chunk->right->parent = parent;
+			}
+			chunk->right = parent;
+		}
+		// (Mirrored)
+		else {
+			parent->right = chunk->left;
+			if (chunk->left) {
+				chunk->left->parent = parent;
+			}
+			chunk->left = parent;
+		}
+		parent->parent = chunk;
+
+		CyIndexPull(file, parent);
+		CyIndexPull(file, chunk);
+	}
+
+	// Inserts an empty chunk into the index tree right after another chunk
+	void CyIndexInsertAfter(CyChunkedFile* file, CyFileChunk* chunk, CyFileChunk* newChunk) {
+		newChunk->left = newChunk->right = 0;
+		newChunk->priority = CyIndexPriority(file);
+
+		// Next in order is the leftmost of the right subtree
+		if (!chunk->right) {
+			chunk->right = newChunk;
+			newChunk->parent = chunk;
+		} else {
+			CyFileChunk* leftmost = chunk->right;
+			while (leftmost->left) {
+				leftmost = leftmost->left;
+			}
+			leftmost->left = newChunk;
+			newChunk->parent = leftmost;
+		}
+
+		// The chunk is empty, so no statistics change; just restore heap order
+		while (newChunk->parent && newChunk->priority > newChunk->parent->priority) {
+			CyIndexRotateUp(file, newChunk);
+		}
+	}
+
+	// Removes a chunk from the index tree
+	void CyIndexRemove(CyChunkedFile* file, CyFileChunk* chunk) {
+		// Rotate down until it's a leaf
+		while (chunk->left || chunk->right) {
+			CyFileChunk* child;
+			if (!chunk->left) {
+				child = chunk->right;
+			} else if (!chunk->right) {
+				child = chunk->left;
+			} else {
+				child = (chunk->left->priority > chunk->right->priority) ? chunk->left : chunk->right;
+			}
+			CyIndexRotateUp(file, child);
+		}
+
+		// Then detach it
+		CyFileChunk* parent = chunk->parent;
+		CyIndexReplaceChild(file, parent, chunk, 0);
+		CyIndexPullPath(file, parent);
+	}
+
+	// Finds the chunk holding the n-th codepoint (or the n-th newline if byNewline)
+	// n must be less than the total amount in the file
+	// Sets before to the statistics of everything before the chunk
+	CyFileChunk* CyIndexFind(CyChunkedFile* file, uint32_m n, muBool byNewline, CyTextStats* before) {
+		memset(before, 0, sizeof(CyTextStats));
+		CyFileChunk* chunk = file->root;
+
+		while (chunk) {
+			// Go left if it's within the left subtree
+			if (chunk->left) {
+				uint32_m leftAmount = (byNewline) ? chunk->left->subtree.newlines : chunk->left->subtree.codepoints;
+				if (n < leftAmount) {
+					chunk = chunk->left;
+					continue;
+				}
+				n -= leftAmount;
+				CyAddStats(file, before, &chunk->left->subtree);
+			}
+
+			// Stop if it's within this chunk
+			uint32_m amount = (byNewline) ? chunk->stats.newlines : chunk->stats.codepoints;
+			if (n < amount) {
+				return chunk;
+			}
+
+			// Go right if not
+			n -= amount;
+			CyAddStats(file, before, &chunk->stats);
+			chunk = chunk->right;
+		}
+
+		return 0;
+	}
+
+	// Returns whether or not text with the given statistics goes past the
+	// given column of a line, or past the line itself
+	muBool CyStatsPastColumn(CyChunkedFile* file, CyTextStats* stats, uint32_m line, uint32_m column) {
+		return stats->newlines > line || (stats->newlines == line && CyStatsColumn(file, stats) > column);
+	}
+
+	// Finds the chunk holding the codepoint that takes up the given column
+	// of a line, or the newline ending it if it's shorter
+	// Returns 0 if it's at the end of the file
+	// Sets before to the statistics of everything before the chunk
+	CyFileChunk* CyIndexFindColumn(CyChunkedFile* file, uint32_m line, uint32_m column, CyTextStats* before) {
+		memset(before, 0, sizeof(CyTextStats));
+		CyFileChunk* chunk = file->root;
+
+		while (chunk) {
+			// Go left if it's within the left subtree
+			CyTextStats next = *before;
+			if (chunk->left) {
+				CyAddStats(file, &next, &chunk->left->subtree);
+				if (CyStatsPastColumn(file, &next, line, column)) {
+					chunk = chunk->left;
+					continue;
+				}
+				*before = next;
+			}
+
+			// Stop if it's within this chunk
+			CyAddStats(file, &next, &chunk->stats);
+			if (CyStatsPastColumn(file, &next, line, column)) {
+				return chunk;
+			}
+
+			// Go right if not
+			*before = next;
+			chunk = chunk->right;
+		}
+
+		return 0;
+	}
+
+	// Counts the statistics of a chunk on its own, given the last codepoint
+	// before it (0 if none), leaving the index tree as it is
+	// Returns the last codepoint in it, or the one before it if it's empty
+	uint32_m CyCountChunk(CyChunkedFile* file, CyFileChunk* chunk, uint32_m prev) {
+		memset(&chunk->stats, 0, sizeof(CyTextStats));
+		for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+			if (chunk->data[c] != 0) {
+				CyCountCodepoint(file, &chunk->stats, chunk->data[c], prev);
+				prev = chunk->data[c];
+			}
+		}
+		return prev;
+	}
+
+	// Recounts the statistics of a chunk
+	void CyRecountChunk(CyChunkedFile* file, CyFileChunk* chunk) {
+		CyCountChunk(file, chunk, CyCodepointBeforeChunk(chunk));
+		CyIndexPullPath(file, chunk);
+	}
+
+	// Recounts a chunk and the next non-empty chunk after it, since
+	// whether or not a word starts there depends on this chunk
+	void CyRecountChunkAndNext(CyChunkedFile* file, CyFileChunk* chunk) {
+		CyRecountChunk(file, chunk);
+		for (chunk = chunk->next; chunk; chunk = chunk->next) {
+			for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+				if (chunk->data[c] != 0) {
+					CyRecountChunk(file, chunk);
+					return;
+				}
+			}
+		}
+	}
+
+	// Unlinks a chunk from the file and frees it
+	void CyRemoveChunk(CyChunkedFile* file, CyFileChunk* chunk) {
+		chunk->prev->next = chunk->next;
 		if (chunk->next) {
-			CyDestroyEachChunk(chunk->next);
+			chunk->next->prev = chunk->prev;
 		}
-		// Deallocate this chunk
+		CyIndexRemove(file, chunk);
 		free(chunk);
 	}
 
+	// Marks a chunk as touched by the current transaction
+	void CyTouchChunk(CyChunkedFile* file, CyFileChunk* chunk) {
+		// Skip if already touched
+		if (chunk->touched) {
+			return;
+		}
+
+		// Grow touched list if needed
+		if (file->numTouched == file->touchedCapacity) {
+			uint32_m newCapacity = (file->touchedCapacity) ? (file->touchedCapacity * 2) : 16;
+			CyFileChunk** newTouched = (CyFileChunk**)realloc(file->touched, sizeof(CyFileChunk*) * newCapacity);
+			// If we can't track it, just fall back to shaking everything
+			if (!newTouched) {
+				file->touchedOverflow = MU_TRUE;
+				return;
+			}
+			file->touched = newTouched;
+			file->touchedCapacity = newCapacity;
+		}
+
+		chunk->touched = MU_TRUE;
+		file->touched[file->numTouched++] = chunk;
+	}
+
+	// Allocates a new empty chunk placed after the given chunk
+	// Returns 0 if failed to allocate
+	CyFileChunk* CyAllocateChunkAfter(CyChunkedFile* file, CyFileChunk* chunk) {
+		// Allocate new chunk
+		CyFileChunk* newChunk = (CyFileChunk*)malloc(sizeof(CyFileChunk));
+		if (!newChunk) {
+			return 0;
+		}
+
+		// Initialize variables
+		memset(newChunk, 0, sizeof(CyFileChunk));
+
+		// Link it in:
+		// chunk -> newChunk -> chunk->next
+		// - chunk->next <- newChunk
+		if (chunk->next) {
+			chunk->next->prev = newChunk;
+		}
+		// - newChunk -> chunk->next
+		newChunk->next = chunk->next;
+		// - newChunk <- chunk
+		newChunk->prev = chunk;
+		// - chunk -> newChunk
+		chunk->next = newChunk;
+		CyIndexInsertAfter(file, chunk, newChunk);
+
+		return newChunk;
+	}
+
+	// Records a change at the given offset into the current transaction's
+	// coalesced edit range; offset is relative to the text before the change
+	void CyMarkEdit(CyChunkedFile* file, uint32_m offset, uint32_m removed, uint32_m inserted) {
+		// First change of the transaction is simply taken as-is
+		if (!file->editPending) {
+			file->edit.offset = offset;
+			file->edit.removed = removed;
+			file->edit.inserted = inserted;
+			file->editPending = MU_TRUE;
+			return;
+		}
+
+		// Union of the already changed span and this change, in current text
+		CyEditRange* edit = &file->edit;
+		uint32_m start = (offset < edit->offset) ? offset : edit->offset;
+		uint32_m end = edit->offset + edit->inserted;
+		if (offset + removed > end) {
+			end = offset + removed;
+		}
+
+		// Map the union back to the text before the transaction, then
+		// forward to the text after this change
+		edit->removed = (end - start) - edit->inserted + edit->removed;
+		edit->inserted = (end - start) - removed + inserted;
+		edit->offset = start;
+	}
+
 	// Pushes cursor to farthest left empty slot
 	void CyShiftLeft(CyChunkedFile* file) {
 		while (MU_TRUE) {
@@ -98,186 +527,186 @@
 	// Pushes data starting from the cursor and past to a new chunk rightwards
 	muBool CyPushRight(CyChunkedFile* file) {
 		// Allocate new chunk
-		CyFileChunk* newChunk = (CyFileChunk*)malloc(sizeof(CyFileChunk));
+		// cursorChunk -> newChunk -> cursorChunk->next
+		CyFileChunk* newChunk = CyAllocateChunkAfter(file, file->cursorChunk);
 		if (!newChunk) {
 			return MU_FALSE;
 		}
 
-		// Initialize variables
-		memset(newChunk->data, 0, 4 * FILE_CHUNK_CODEPOINTS);
-
-		// cursorChunk -> newChunk -> cursorChunk->next
-		// - cursorChunk->next <- newChunk
-		if (file->cursorChunk->next) {
-			file->cursorChunk->next->prev = newChunk;
-		}
-		// - newChunk -> cursorChunk->next
-		newChunk->next = file->cursorChunk->next;
-		// - newChunk <- cursorChunk
-		newChunk->prev = file->cursorChunk;
-		// - cursorChunk -> newChunk
-		file->cursorChunk->next = newChunk;
-
 		// Move data over from cursor chunk to new
 		memcpy(&newChunk->data[file->cursorIndex], &file->cursorChunk->data[file->cursorIndex], 4 * (FILE_CHUNK_CODEPOINTS - file->cursorIndex));
 		// And then zero-out that data
 		memset(&file->cursorChunk->data[file->cursorIndex], 0, 4 * (FILE_CHUNK_CODEPOINTS - file->cursorIndex));
+		CyTouchChunk(file, file->cursorChunk);
+		CyTouchChunk(file, newChunk);
 
 		return MU_TRUE;
 	}
 
 	// Scans each chunk in a file for empty chunks, and removes them
+	// Also recounts the statistics of every chunk, and then of every subtree
+	// in a single pass rather than up the path from each chunk
 	void CyShakeFile(CyChunkedFile* file) {
 		// Start at first chunk
 		CyFileChunk* chunk = file->chunks;
+		// Last codepoint so far, which words in the next chunk depend on
+		uint32_m prev = 0;
 
-		while (MU_TRUE) {
-			// Go to next chunk
-			if (!chunk->next) {
-				return;
-			}
-			chunk = chunk->next;
-
-			// If the cursor is in this chunk, don't consider
-			if (file->cursorChunk == chunk) {
-				continue;
-			}
+		while (chunk) {
+			// Get the next chunk before this one is possibly removed
+			CyFileChunk* next = chunk->next;
 
-			// Scan through for non-empty codepoints
-			muBool empty = MU_TRUE;
-			for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
-				if (chunk->data[c] != 0) {
-					empty = MU_FALSE;
-					break;
-				}
-			}
+			// Recount; tells us whether or not it's empty
+			prev = CyCountChunk(file, chunk, prev);
 
-			// If empty, remove
-			if (empty) {
-				chunk->prev->next = chunk->next;
-				if (chunk->next) {
-					chunk->next->prev = chunk->prev;
-				}
-				free(chunk);
+			// If empty (and neither the first nor the cursor's chunk), remove
+			if (chunk != file->chunks && chunk != file->cursorChunk && chunk->stats.codepoints == 0) {
+				CyRemoveChunk(file, chunk);
 			}
-		}
-	}
-
-/* Outer functions */
 
-	// Initializes an empty chunked file
-	// Returns false if failed to allocate chunks
-	muBool CyCreateEmptyChunkedFile(CyChunkedFile* file) {
-		// Allocate one chunk
-		file->chunks = (CyFileChunk*)malloc(sizeof(CyFileChunk));
-		if (!file->chunks) {
-			return MU_FALSE;
+			chunk = next;
 		}
-		// Set all memory within the chunk to 0
-		memset(file->chunks, 0, sizeof(CyFileChunk));
 
-		// Set cursor to 0
-		file->cursorChunk = file->chunks;
-		file->cursorIndex = 0;
-		return MU_TRUE;
+		// Subtrees are only added up once every chunk is counted
+		CyIndexPullAll(file, file->root);
 	}
 
-	// Destroys a chunked file
-	void CyDestroyChunkedFile(CyChunkedFile* file) {
-		// Destroy all chunks
-		CyDestroyEachChunk(file->chunks);
-	}
+	// Flushes the bookkeeping of the chunks touched so far:
+	// recounts their statistics and removes the ones that are now empty
+	// Only looks at the touched chunks, unlike CyShakeFile
+	void CyFlushTouchedChunks(CyChunkedFile* file) {
+		// Recount touched chunks
+		for (uint32_m t = 0; t < file->numTouched; ++t) {
+			CyRecountChunkAndNext(file, file->touched[t]);
+		}
 
-	// Moves cursor left n times
-	// Simply stops if it can't go any further left
-	void CyMoveLeftInChunkedFile(CyChunkedFile* file, uint32_m n) {
-		// Loop n amount of times
-		while (n) {
-			// If this is the last index in the chunk:
-			if (file->cursorIndex == 0) {
-				// If there is a previous chunk, go to it
-				if (file->cursorChunk->prev) {
-					file->cursorChunk = file->cursorChunk->prev;
-					file->cursorIndex = FILE_CHUNK_CODEPOINTS - 1;
-				}
-				// If there is no previous chunk, farthest we can go; exit
-				else {
-					return;
-				}
-			}
+		// Remove the ones that are now empty
+		for (uint32_m t = 0; t < file->numTouched; ++t) {
+			CyFileChunk* chunk = file->touched[t];
+			chunk->touched = MU_FALSE;
 
-			// If this isn't the last index in the chunk, simply
-			// decrement by 1
-			else {
-				--file->cursorIndex;
+			// The first chunk and the cursor's chunk are never removed
+			if (chunk != file->chunks && chunk != file->cursorChunk && chunk->stats.codepoints == 0) {
+				CyRemoveChunk(file, chunk);
 			}
+		}
+		file->numTouched = 0;
 
-			// If we landed on a valid codepoint, count the left movement
-			if (file->cursorChunk->data[file->cursorIndex] != 0) {
-				--n;
-			}
+		// If not everything could be tracked, go through the whole file
+		if (file->touchedOverflow) {
+			CyShakeFile(file);
+			file->touchedOverflow = MU_FALSE;
 		}
 	}
 
-	// Moves cursor right n times
-	// Simply stops if it can't go any further right
-	// This code is very similar to CyMoveLeftInChunkedFile
-	void CyMoveRightInChunkedFile(CyChunkedFile* file, uint32_m n) {
-		// Loop n amount of times
-		while (n) {
-			// If this is the last index in the chunk:
-			if (file->cursorIndex == FILE_CHUNK_CODEPOINTS-1) {
-				// If there is a next chunk, go to it
-				if (file->cursorChunk->next) {
-					file->cursorChunk = file->cursorChunk->next;
-					file->cursorIndex = 0;
-				}
-				// If there is no next chunk, farthest we can go; exit
-				else {
-					break;
+	// Writes codepoint; see CyWriteCodepointInChunkedFile
+	muBool CyWriteCodepoint(CyChunkedFile* file, uint32_m codepoint) {
+		// Is the current slot empty?
+		if (file->cursorChunk->data[file->cursorIndex] == 0) {
+			// If so, set the slot.
+			file->cursorChunk->data[file->cursorIndex] = codepoint;
+			CyTouchChunk(file, file->cursorChunk);
+			CyMarkEdit(file, file->cursorOffset, 0, 1);
+			// Move right.
+			if (!file->cursorChunk->next && file->cursorIndex == FILE_CHUNK_CODEPOINTS-1) {
+				// Allocate new chunk
+				CyFileChunk* newChunk = CyAllocateChunkAfter(file, file->cursorChunk);
+				if (!newChunk) {
+					return MU_FALSE;
 				}
-			}
 
-			// If this isn't the last index in the chunk, simply
-			// increment by 1
-			else {
-				++file->cursorIndex;
+				// Set cursor to new chunk
+				file->cursorChunk = newChunk;
+				file->cursorIndex = 0;
+				++file->cursorOffset;
 			}
-
-			// If we're on on a valid codepoint, count the right movement
-			if (file->cursorChunk->data[file->cursorIndex] != 0) {
-				--n;
+			else {
+				CyMoveRightInChunkedFile(file, 1);
 			}
+			// And we're done.
+			return MU_TRUE;
 		}
 
-		// If we landed on an empty codepoint:
-		if (file->cursorChunk->data[file->cursorIndex] == 0) {
-			// That means that we reached the end of all the data;
-			// go back to nearest empty slot to ensure optimal space usage
-			CyShiftLeft(file);
-		}
-	}
-
-	// Inserts codepoint
-	muBool CyInsertCodepointInChunkedFile(CyChunkedFile* file, uint32_m codepoint) {
-		// If cursor is at the end of this chunk and there is no next chunk:
-		if (file->cursorIndex == FILE_CHUNK_CODEPOINTS-1 && !file->cursorChunk->next) {
-			// Allocate new chunk
-			CyFileChunk* newChunk = (CyFileChunk*)malloc(sizeof(CyFileChunk));
-			if (!newChunk) {
+		// If there is no previous spot, there is no free space.
+		if (!file->cursorChunk->prev && file->cursorIndex == 0) {
+			// In such case, data must be pushed.
+			if (!CyPushRight(file)) {
 				return MU_FALSE;
 			}
+			// And codepoint must be set
+			file->cursorChunk->data[file->cursorIndex] = codepoint;
+			CyMarkEdit(file, file->cursorOffset, 0, 1);
+			// Move cursor right, past the codepoint.
+			CyMoveRightInChunkedFile(file, 1);
+			return MU_TRUE;
+		}
+
+		// There is a previous spot; is it zero?
+		CyFileChunk* testChunk = file->cursorChunk;
+		uint32_m testIndex = file->cursorIndex;
+		if (testIndex == 0) {
+			testChunk = testChunk->prev;
+			testIndex = FILE_CHUNK_CODEPOINTS-1;
+		} else {
+			--testIndex;
+		}
+
+		if (testChunk->data[testIndex] == 0) {
+			// If it is, try moving back as far as possible
+			// before it isn't zero.
+			CyFileChunk* prevChunk = testChunk;
+			uint32_m prevIndex = testIndex;
+			while (MU_TRUE) {
+				if (!prevChunk->prev && prevIndex == 0) {
+					break;
+				}
+
+				if (prevIndex == 0) {
+					prevChunk = prevChunk->prev;
+					prevIndex = FILE_CHUNK_CODEPOINTS-1;
+				} else {
+					--prevIndex;
+				}
+
+				if (prevChunk->data[prevIndex] == 0) {
+					testChunk = prevChunk;
+					testIndex = prevIndex;
+				} else {
+					break;
+				}
+			}
 
-			// Initialize variables
-			memset(newChunk->data, 0, 4 * FILE_CHUNK_CODEPOINTS);
-
-			// cursorChunk -> newChunk -> cursorChunk->next
-			// - newChunk -> cursorChunk->next
-			newChunk->next = file->cursorChunk->next;
-			// - newChunk <- cursorChunk
-			newChunk->prev = file->cursorChunk;
-			// - cursorChunk -> newChunk
-			file->cursorChunk->next = newChunk;
+			// Then set it.
+			testChunk->data[testIndex] = codepoint;
+			CyTouchChunk(file, testChunk);
+			CyMarkEdit(file, file->cursorOffset, 0, 1);
+			// The cursor now has one more codepoint before it.
+			++file->cursorOffset;
+			return MU_TRUE;
+		}
+
+		// There is no previous spot.
+		// Push right.
+		if (!CyPushRight(file)) {
+			return MU_FALSE;
+		}
+		// Set codepoint.
+		file->cursorChunk->data[file->cursorIndex] = codepoint;
+		CyMarkEdit(file, file->cursorOffset, 0, 1);
+		// Move cursor right.
+		CyMoveRightInChunkedFile(file, 1);
+
+		return MU_TRUE;
+	}
+
+	// Inserts codepoint; see CyInsertCodepointInChunkedFile
+	muBool CyInsertCodepoint(CyChunkedFile* file, uint32_m codepoint) {
+		// If cursor is at the end of this chunk and there is no next chunk:
+		if (file->cursorIndex == FILE_CHUNK_CODEPOINTS-1 && !file->cursorChunk->next) {
+			// Allocate new chunk
+			if (!CyAllocateChunkAfter(file, file->cursorChunk)) {
+				return MU_FALSE;
+			}
 		}
 
 		// If the given codepoint is a newline or tab and we're overwriting a non-zero codepoint:
@@ -285,7 +714,7 @@
 			&& (file->cursorChunk->data[file->cursorIndex] != 0)
 		) {
 			// It's just inserted.
-			return CyWriteCodepointInChunkedFile(file, codepoint);
+			return CyWriteCodepoint(file, codepoint);
 		}
 
 		// If the current codepoint is newline:
@@ -326,21 +755,24 @@
 			}
 		}
 		// Set codepoint of current slot
+		CyMarkEdit(file, file->cursorOffset, (file->cursorChunk->data[file->cursorIndex] != 0) ? 1 : 0, 1);
 		file->cursorChunk->data[file->cursorIndex] = codepoint;
+		CyTouchChunk(file, file->cursorChunk);
 		// Move right
 		CyMoveRightInChunkedFile(file, 1);
 
 		return MU_TRUE;
 	}
 
-	// Backspace a codepoint
-	void CyBackspaceCodepointInChunkedFile(CyChunkedFile* file) {
+	// Backspaces a codepoint; see CyBackspaceCodepointInChunkedFile
+	void CyBackspaceCodepoint(CyChunkedFile* file) {
 		// Save where we currently are.
 		CyFileChunk* prevChunk = file->cursorChunk;
 		uint32_m prevIndex = file->cursorIndex;
 
 		// Move left until we're rather farthest left possible
 		// or we're on a non-zero codepoint.
+		muBool found = MU_FALSE;
 		while (MU_TRUE) {
 			if (!file->cursorChunk->prev && file->cursorIndex == 0) {
 				break;
@@ -355,121 +787,555 @@
 			}
 
 			if (file->cursorChunk->data[file->cursorIndex] != 0) {
+				found = MU_TRUE;
 				break;
 			}
 		}
 
+		// If there's nothing to the left, there's nothing to remove.
+		if (!found) {
+			file->cursorChunk = prevChunk;
+			file->cursorIndex = prevIndex;
+			return;
+		}
+
 		// 3. Set that codepoint to 0.
 		file->cursorChunk->data[file->cursorIndex] = 0;
+		CyTouchChunk(file, file->cursorChunk);
+		--file->cursorOffset;
+		CyMarkEdit(file, file->cursorOffset, 1, 0);
 
 		// 4. Go back.
 		if (prevChunk->data[prevIndex] != 0) {
 			file->cursorChunk = prevChunk;
 			file->cursorIndex = prevIndex;
 		}
-		
-		// 5. Shake file (optimize later)
-		CyShakeFile(file);
+		// If we're staying on the now-empty slot, make sure it's the leftmost one
+		else {
+			CyShiftLeft(file);
+		}
+
+		// 5. Empty chunks are shaken once the transaction commits.
 	}
 
-	// Writes codepoint
-	muBool CyWriteCodepointInChunkedFile(CyChunkedFile* file, uint32_m codepoint) {
-		// Is the current slot empty?
-		if (file->cursorChunk->data[file->cursorIndex] == 0) {
-			// If so, set the slot.
-			file->cursorChunk->data[file->cursorIndex] = codepoint;
-			// Move right.
-			if (!file->cursorChunk->next && file->cursorIndex == FILE_CHUNK_CODEPOINTS-1) {
-				// Allocate new chunk
-				CyFileChunk* newChunk = (CyFileChunk*)malloc(sizeof(CyFileChunk));
-				if (!newChunk) {
-					return MU_FALSE;
-				}
+	// Gets the word break property of the first codepoint after a slot that
+	// isn't ignored by WB4; WORD_BREAK_OTHER if there's none
+	uint8_m CyGetNextWordBreak(CyChunkSlot slot) {
+		while (CyGetNextSlotInChunkedFile(&slot)) {
+			uint8_m wordBreak = UNICODE_WORD_BREAK(CyGetUnicodeProperties(slot.codepoint));
+			if (wordBreak != WORD_BREAK_EXTEND && wordBreak != WORD_BREAK_FORMAT && wordBreak != WORD_BREAK_ZWJ) {
+				return wordBreak;
+			}
+		}
+		return WORD_BREAK_OTHER;
+	}
 
-				// Initialize variables
-				memset(newChunk->data, 0, 4 * FILE_CHUNK_CODEPOINTS);
+	// Feeds the codepoint of an iterator's slot to its segmentation state
+	// Returns whether or not there's a break before it
+	muBool CyFeedSegmentIterator(CySegmentIterator* iter, muBool words) {
+		uint16_m properties = CyGetUnicodeProperties(iter->slot.codepoint);
+		if (!words) {
+			return CyGraphemeBreakBefore(&iter->grapheme, properties);
+		}
 
-				// cursorChunk -> newChunk -> cursorChunk->next
-				// - newChunk -> cursorChunk->next
-				newChunk->next = file->cursorChunk->next;
-				// - newChunk <- cursorChunk
-				newChunk->prev = file->cursorChunk;
-				// - cursorChunk -> newChunk
-				file->cursorChunk->next = newChunk;
+		uint8_m next = WORD_BREAK_OTHER;
+		if (CyWordBreakNeedsNext(UNICODE_WORD_BREAK(properties))) {
+			next = CyGetNextWordBreak(iter->slot);
+		}
+		return CyWordBreakBefore(&iter->word, properties, next);
+	}
 
-				// Set cursor to new chunk
-				file->cursorChunk = newChunk;
-				file->cursorIndex = 0;
+	// Moves an iterator on to the next boundary
+	// Returns false if already at the end of the file
+	muBool CyAdvanceSegmentIterator(CySegmentIterator* iter, muBool words) {
+		if (iter->end) {
+			return MU_FALSE;
+		}
+
+		while (MU_TRUE) {
+			++iter->offset;
+			if (!CyGetNextSlotInChunkedFile(&iter->slot)) {
+				iter->end = MU_TRUE;
+				return MU_TRUE;
 			}
-			else {
-				CyMoveRightInChunkedFile(file, 1);
+			if (CyFeedSegmentIterator(iter, words)) {
+				return MU_TRUE;
 			}
-			// And we're done.
-			return MU_TRUE;
 		}
+	}
 
-		// If there is no previous spot, there is no free space.
-		if (!file->cursorChunk->prev && file->cursorIndex == 0) {
-			// In such case, data must be pushed.
-			if (!CyPushRight(file)) {
-				return MU_FALSE;
+	// Starts an iterator at a boundary at or before the given offset that
+	// segmenting can safely start over from, looking back codepoint by
+	// codepoint for one
+	void CyBeginSegmentsAtSafeBreak(CyChunkedFile* file, uint32_m offset, muBool words, CySegmentIterator* iter) {
+		CyResetGraphemeState(&iter->grapheme);
+		CyResetWordState(&iter->word);
+		iter->end = MU_FALSE;
+
+		// Start from the last codepoint at most
+		CyFlushTouchedChunks(file);
+		uint32_m total = file->root->subtree.codepoints;
+		if (total == 0) {
+			CyGetFirstSlotInChunkedFile(file, &iter->slot);
+			iter->offset = 0;
+			iter->end = MU_TRUE;
+			return;
+		}
+		if (offset >= total) {
+			offset = total-1;
+		}
+		CyGetSlotAtOffsetInChunkedFile(file, offset, &iter->slot);
+
+		// Look back for a safe break
+		uint16_m properties = CyGetUnicodeProperties(iter->slot.codepoint);
+		CyChunkSlot prev = iter->slot;
+		while (offset > 0) {
+			CyGetPrevSlotInChunkedFile(&prev);
+			uint16_m prevProperties = CyGetUnicodeProperties(prev.codepoint);
+			if (words ? CyIsWordSafeBreak(prevProperties, properties) : CyIsGraphemeSafeBreak(prevProperties, properties)) {
+				break;
 			}
-			// And codepoint must be set
-			file->cursorChunk->data[file->cursorIndex] = codepoint;
-			return MU_TRUE;
+			iter->slot = prev;
+			properties = prevProperties;
+			--offset;
 		}
 
-		// There is a previous spot; is it zero?
-		CyFileChunk* testChunk = file->cursorChunk;
-		uint32_m testIndex = file->cursorIndex;
-		if (testIndex == 0) {
-			testChunk = testChunk->prev;
-			testIndex = FILE_CHUNK_CODEPOINTS-1;
-		} else {
-			--testIndex;
+		iter->offset = offset;
+		CyFeedSegmentIterator(iter, words);
+	}
+
+	// Starts an iterator at the last boundary at or before the given offset
+	void CyBeginSegments(CyChunkedFile* file, uint32_m offset, muBool words, CySegmentIterator* iter) {
+		CyBeginSegmentsAtSafeBreak(file, offset, words, iter);
+
+		CySegmentIterator next = *iter;
+		while (next.offset < offset && CyAdvanceSegmentIterator(&next, words) && next.offset <= offset) {
+			*iter = next;
 		}
+	}
 
-		if (testChunk->data[testIndex] == 0) {
-			// If it is, try moving back as far as possible
-			// before it isn't zero.
-			CyFileChunk* prevChunk = testChunk;
-			uint32_m prevIndex = testIndex;
-			while (MU_TRUE) {
-				if (!prevChunk->prev && prevIndex == 0) {
-					break;
+/* Outer functions */
+
+	// Initializes an empty chunked file
+	// Returns false if failed to allocate chunks
+	muBool CyCreateEmptyChunkedFile(CyChunkedFile* file) {
+		// Allocate one chunk
+		file->chunks = (CyFileChunk*)malloc(sizeof(CyFileChunk));
+		if (!file->chunks) {
+			return MU_FALSE;
+		}
+		// Set all memory within the chunk to 0
+		memset(file->chunks, 0, sizeof(CyFileChunk));
+		// It's the only chunk in the index
+		file->root = file->chunks;
+		file->indexSeed = 0x9E3779B9;
+		file->chunks->priority = CyIndexPriority(file);
+
+		// Set cursor to 0
+		file->cursorChunk = file->chunks;
+		file->cursorIndex = 0;
+		file->cursorOffset = 0;
+		file->stickyValid = MU_FALSE;
+		file->tabWidth = FILE_TAB_WIDTH;
+
+		// No transaction is open
+		file->editDepth = 0;
+		file->editPending = MU_FALSE;
+		memset(&file->edit, 0, sizeof(CyEditRange));
+		memset(&file->lastEdit, 0, sizeof(CyEditRange));
+		file->version = 0;
+
+		// Nothing touched
+		file->touched = 0;
+		file->numTouched = 0;
+		file->touchedCapacity = 0;
+		file->touchedOverflow = MU_FALSE;
+
+		// No listeners
+		file->numListeners = 0;
+		return MU_TRUE;
+	}
+
+	// Destroys a chunked file
+	void CyDestroyChunkedFile(CyChunkedFile* file) {
+		// Destroy all chunks
+		CyDestroyEachChunk(file->chunks);
+		// Free touched list
+		free(file->touched);
+	}
+
+	// Sets the columns between tab stops
+	void CySetChunkedFileTabWidth(CyChunkedFile* file, uint32_m width) {
+		file->tabWidth = (width == 0) ? 1 : width;
+		// (The sticky column is kept with tabs expanded)
+		file->stickyValid = MU_FALSE;
+		CyFlushTouchedChunks(file);
+		CyShakeFile(file);
+	}
+
+	// Begins an edit transaction
+	void CyBeginEdit(CyChunkedFile* file) {
+		++file->editDepth;
+	}
+
+	// Commits an edit transaction
+	void CyCommitEdit(CyChunkedFile* file) {
+		// Only the outermost commit flushes
+		if (file->editDepth == 0 || --file->editDepth != 0) {
+			return;
+		}
+
+		// Recount and remove chunks emptied by the transaction
+		CyFlushTouchedChunks(file);
+
+		// Publish the coalesced change
+		if (file->editPending) {
+			file->lastEdit = file->edit;
+			file->editPending = MU_FALSE;
+			++file->version;
+
+			// Notify listeners
+			for (uint32_m l = 0; l < file->numListeners; ++l) {
+				file->listeners[l](file, &file->lastEdit, file->listenerData[l]);
+			}
+		}
+	}
+
+	// Adds a listener that gets called after every committed change
+	// Returns false if there are too many listeners
+	muBool CyAddChunkedFileListener(CyChunkedFile* file, CyChunkedFileListener listener, void* data) {
+		if (file->numListeners == FILE_LISTENERS) {
+			return MU_FALSE;
+		}
+		file->listeners[file->numListeners] = listener;
+		file->listenerData[file->numListeners] = data;
+		++file->numListeners;
+		return MU_TRUE;
+	}
+
+	// Removes a listener previously added with the same data
+	void CyRemoveChunkedFileListener(CyChunkedFile* file, CyChunkedFileListener listener, void* data) {
+		for (uint32_m l = 0; l < file->numListeners; ++l) {
+			if (file->listeners[l] == listener && file->listenerData[l] == data) {
+				// Shift the rest down to keep notification order
+				for (uint32_m n = l+1; n < file->numListeners; ++n) {
+					file->listeners[n-1] = file->listeners[n];
+					file->listenerData[n-1] = file->listenerData[n];
 				}
+				--file->numListeners;
+				return;
+			}
+		}
+	}
 
-				if (prevIndex == 0) {
-					prevChunk = prevChunk->prev;
-					prevIndex = FILE_CHUNK_CODEPOINTS-1;
-				} else {
-					--prevIndex;
+	// Moves cursor left n times
+	// Simply stops if it can't go any further left
+	void CyMoveLeftInChunkedFile(CyChunkedFile* file, uint32_m n) {
+		file->stickyValid = MU_FALSE;
+
+		// Last position the cursor was validly at
+		CyFileChunk* validChunk = file->cursorChunk;
+		uint32_m validIndex = file->cursorIndex;
+
+		// Loop n amount of times
+		while (n) {
+			// If this is the last index in the chunk:
+			if (file->cursorIndex == 0) {
+				// If there is a previous chunk, go to it
+				if (file->cursorChunk->prev) {
+					file->cursorChunk = file->cursorChunk->prev;
+					file->cursorIndex = FILE_CHUNK_CODEPOINTS - 1;
 				}
+				// If there is no previous chunk, farthest we can go;
+				// go back to the last valid position (we may be on
+				// leading empty slots) and exit
+				else {
+					file->cursorChunk = validChunk;
+					file->cursorIndex = validIndex;
+					return;
+				}
+			}
 
-				if (prevChunk->data[prevIndex] == 0) {
-					testChunk = prevChunk;
-					testIndex = prevIndex;
-				} else {
+			// If this isn't the last index in the chunk, simply
+			// decrement by 1
+			else {
+				--file->cursorIndex;
+			}
+
+			// If we landed on a valid codepoint, count the left movement
+			if (file->cursorChunk->data[file->cursorIndex] != 0) {
+				validChunk = file->cursorChunk;
+				validIndex = file->cursorIndex;
+				--file->cursorOffset;
+				--n;
+			}
+		}
+	}
+
+	// Moves cursor right n times
+	// Simply stops if it can't go any further right
+	// This code is very similar to CyMoveLeftInChunkedFile
+	void CyMoveRightInChunkedFile(CyChunkedFile* file, uint32_m n) {
+		file->stickyValid = MU_FALSE;
+
+		// Loop n amount of times
+		while (n) {
+			// Whether or not we're about to step over a codepoint
+			muBool stepOver = file->cursorChunk->data[file->cursorIndex] != 0;
+
+			// If this is the last index in the chunk:
+			if (file->cursorIndex == FILE_CHUNK_CODEPOINTS-1) {
+				// If there is a next chunk, go to it
+				if (file->cursorChunk->next) {
+					file->cursorChunk = file->cursorChunk->next;
+					file->cursorIndex = 0;
+				}
+				// If there is no next chunk and we're still on a codepoint,
+				// make room past it so that the cursor can be at the end
+				else if (stepOver) {
+					CyFileChunk* newChunk = CyAllocateChunkAfter(file, file->cursorChunk);
+					if (!newChunk) {
+						break;
+					}
+					file->cursorChunk = newChunk;
+					file->cursorIndex = 0;
+					++file->cursorOffset;
+					break;
+				}
+				// If there is no next chunk, farthest we can go; exit
+				else {
 					break;
 				}
 			}
 
-			// Then set it.
-			testChunk->data[testIndex] = codepoint;
-			return MU_TRUE;
+			// If this isn't the last index in the chunk, simply
+			// increment by 1
+			else {
+				++file->cursorIndex;
+			}
+			if (stepOver) {
+				++file->cursorOffset;
+			}
+
+			// If we're on on a valid codepoint, count the right movement
+			if (file->cursorChunk->data[file->cursorIndex] != 0) {
+				--n;
+			}
 		}
 
-		// There is no previous spot.
-		// Push right.
-		if (!CyPushRight(file)) {
-			return MU_FALSE;
+		// If we landed on an empty codepoint:
+		if (file->cursorChunk->data[file->cursorIndex] == 0) {
+			// That means that we reached the end of all the data;
+			// go back to nearest empty slot to ensure optimal space usage
+			CyShiftLeft(file);
 		}
-		// Set codepoint.
-		file->cursorChunk->data[file->cursorIndex] = codepoint;
-		// Move cursor right.
-		CyMoveRightInChunkedFile(file, 1);
+	}
 
-		return MU_TRUE;
+	// Moves cursor to the given offset
+	// Clamps to the end of the file; O(log n)
+	void CySetCursorInChunkedFile(CyChunkedFile* file, uint32_m offset) {
+		file->stickyValid = MU_FALSE;
+		CyFlushTouchedChunks(file);
+		uint32_m total = file->root->subtree.codepoints;
+		if (offset > total) {
+			offset = total;
+		}
+
+		// Empty file: farthest left slot
+		if (total == 0) {
+			file->cursorChunk = file->chunks;
+			file->cursorIndex = 0;
+			file->cursorOffset = 0;
+			return;
+		}
+
+		CyChunkSlot slot;
+		// Not at the end: on the codepoint at the offset
+		if (offset != total) {
+			CyGetSlotAtOffsetInChunkedFile(file, offset, &slot);
+			file->cursorChunk = slot.chunk;
+			file->cursorIndex = slot.index;
+			file->cursorOffset = offset;
+			return;
+		}
+
+		// At the end: on the empty slot right after the last codepoint
+		CyGetSlotAtOffsetInChunkedFile(file, total-1, &slot);
+		if (slot.index != FILE_CHUNK_CODEPOINTS-1) {
+			file->cursorChunk = slot.chunk;
+			file->cursorIndex = slot.index+1;
+		}
+		else if (slot.chunk->next) {
+			file->cursorChunk = slot.chunk->next;
+			file->cursorIndex = 0;
+		}
+		else {
+			// Make room past the last codepoint
+			CyFileChunk* newChunk = CyAllocateChunkAfter(file, slot.chunk);
+			// (If we can't, the closest we can get is before it)
+			if (!newChunk) {
+				file->cursorChunk = slot.chunk;
+				file->cursorIndex = slot.index;
+				file->cursorOffset = total-1;
+				return;
+			}
+			file->cursorChunk = newChunk;
+			file->cursorIndex = 0;
+		}
+		file->cursorOffset = total;
+	}
+
+	// Moves cursor to the start of its line (Home)
+	void CyMoveToLineStartInChunkedFile(CyChunkedFile* file) {
+		uint32_m line = CyGetLineOfOffsetInChunkedFile(file, file->cursorOffset);
+		CySetCursorInChunkedFile(file, CyGetLineStartInChunkedFile(file, line));
+	}
+
+	// Moves cursor to the end of its line (End)
+	void CyMoveToLineEndInChunkedFile(CyChunkedFile* file) {
+		uint32_m line = CyGetLineOfOffsetInChunkedFile(file, file->cursorOffset);
+		CySetCursorInChunkedFile(file, CyGetLineEndInChunkedFile(file, line));
+	}
+
+	// Moves cursor left by a grapheme cluster
+	void CyMoveGraphemeLeftInChunkedFile(CyChunkedFile* file) {
+		file->stickyValid = MU_FALSE;
+		if (file->cursorOffset == 0) {
+			return;
+		}
+
+		CySegmentIterator iter;
+		CyBeginSegments(file, file->cursorOffset-1, MU_FALSE, &iter);
+		CySetCursorInChunkedFile(file, iter.offset);
+	}
+
+	// Moves cursor right by a grapheme cluster
+	void CyMoveGraphemeRightInChunkedFile(CyChunkedFile* file) {
+		file->stickyValid = MU_FALSE;
+		CySegmentIterator iter;
+		CyBeginSegments(file, file->cursorOffset, MU_FALSE, &iter);
+		CyAdvanceSegmentIterator(&iter, MU_FALSE);
+		if (iter.offset > file->cursorOffset) {
+			CySetCursorInChunkedFile(file, iter.offset);
+		}
+	}
+
+	// Moves cursor to the start of the previous word (Ctrl+Left)
+	void CyMoveWordLeftInChunkedFile(CyChunkedFile* file) {
+		// Go through the words before the cursor, looking further back
+		// each time there's no actual word among them
+		uint32_m limit = file->cursorOffset;
+		while (limit > 0) {
+			CySegmentIterator iter;
+			CyBeginSegmentsAtSafeBreak(file, limit-1, MU_TRUE, &iter);
+			uint32_m start = iter.offset;
+
+			muBool found = MU_FALSE;
+			uint32_m wordStart = 0;
+			while (iter.offset < limit) {
+				muBool word = CyIsWordCodepoint(iter.slot.codepoint);
+				uint32_m segmentStart = iter.offset;
+				CyAdvanceSegmentIterator(&iter, MU_TRUE);
+				if (word) {
+					found = MU_TRUE;
+					wordStart = segmentStart;
+				}
+			}
+
+			if (found) {
+				CySetCursorInChunkedFile(file, wordStart);
+				return;
+			}
+			limit = start;
+		}
+
+		CySetCursorInChunkedFile(file, 0);
+	}
+
+	// Moves cursor to the end of the next word (Ctrl+Right)
+	void CyMoveWordRightInChunkedFile(CyChunkedFile* file) {
+		CySegmentIterator iter;
+		CyBeginSegments(file, file->cursorOffset, MU_TRUE, &iter);
+
+		// Skip ahead until the end of an actual word
+		while (!iter.end) {
+			muBool word = CyIsWordCodepoint(iter.slot.codepoint);
+			CyAdvanceSegmentIterator(&iter, MU_TRUE);
+			if (word && iter.offset > file->cursorOffset) {
+				break;
+			}
+		}
+
+		CySetCursorInChunkedFile(file, iter.offset);
+	}
+
+	// Moves cursor to the given line, keeping its column across vertical moves
+	// The column is kept as shown, with tabs and wide codepoints expanded
+	void CyMoveToLine(CyChunkedFile* file, uint32_m target) {
+		// Reuse the sticky column if nothing has happened since the last vertical move
+		if (!file->stickyValid) {
+			file->stickyColumn = CyGetColumnOfOffsetInChunkedFile(file, file->cursorOffset);
+		}
+
+		// Go to the codepoint at that column, or the end of the line if it's
+		// shorter; a tab or wide codepoint going past it is landed before
+		uint32_m start;
+		uint32_m offset = CyGetOffsetOfColumnInChunkedFile(file, target, file->stickyColumn, &start);
+		// Never land within a grapheme cluster
+		CySegmentIterator iter;
+		CyBeginSegments(file, offset, MU_FALSE, &iter);
+		CySetCursorInChunkedFile(file, iter.offset);
+
+		file->stickyValid = MU_TRUE;
+	}
+
+	// Moves cursor up n lines, keeping its column across vertical moves
+	void CyMoveUpInChunkedFile(CyChunkedFile* file, uint32_m n) {
+		uint32_m line = CyGetLineOfOffsetInChunkedFile(file, file->cursorOffset);
+		CyMoveToLine(file, (line > n) ? (line - n) : 0);
+	}
+
+	// Moves cursor down n lines, keeping its column across vertical moves
+	void CyMoveDownInChunkedFile(CyChunkedFile* file, uint32_m n) {
+		uint32_m line = CyGetLineOfOffsetInChunkedFile(file, file->cursorOffset);
+		uint32_m lastLine = file->root->subtree.newlines;
+		CyMoveToLine(file, (lastLine - line > n) ? (line + n) : lastLine);
+	}
+
+	// Moves cursor to the start of the file (Ctrl+Home)
+	void CyMoveToStartInChunkedFile(CyChunkedFile* file) {
+		CySetCursorInChunkedFile(file, 0);
+	}
+
+	// Moves cursor to the end of the file (Ctrl+End)
+	void CyMoveToEndInChunkedFile(CyChunkedFile* file) {
+		CySetCursorInChunkedFile(file, 0xFFFFFFFF);
+	}
+
+	// Inserts codepoint
+	muBool CyInsertCodepointInChunkedFile(CyChunkedFile* file, uint32_m codepoint) {
+		file->stickyValid = MU_FALSE;
+		CyBeginEdit(file);
+		muBool success = CyInsertCodepoint(file, codepoint);
+		CyCommitEdit(file);
+		return success;
+	}
+
+	// Backspace a codepoint
+	void CyBackspaceCodepointInChunkedFile(CyChunkedFile* file) {
+		file->stickyValid = MU_FALSE;
+		CyBeginEdit(file);
+		CyBackspaceCodepoint(file);
+		CyCommitEdit(file);
+	}
+
+	// Writes codepoint
+	muBool CyWriteCodepointInChunkedFile(CyChunkedFile* file, uint32_m codepoint) {
+		file->stickyValid = MU_FALSE;
+		CyBeginEdit(file);
+		muBool success = CyWriteCodepoint(file, codepoint);
+		CyCommitEdit(file);
+		return success;
 	}
 
 	// Gets the first slot
@@ -523,6 +1389,57 @@
 		return MU_FALSE;
 	}
 
+	// Gets the previous slot
+	// Returns false if no slot
+	muBool CyGetPrevSlotInChunkedFile(CyChunkSlot* slot) {
+		while (MU_TRUE) {
+			if (slot->index == 0 && !slot->chunk->prev) {
+				return MU_FALSE;
+			}
+			else if (slot->index == 0) {
+				slot->chunk = slot->chunk->prev;
+				slot->index = FILE_CHUNK_CODEPOINTS-1;
+			}
+			else {
+				--slot->index;
+			}
+
+			if (slot->chunk->data[slot->index] != 0) {
+				slot->codepoint = slot->chunk->data[slot->index];
+				return MU_TRUE;
+			}
+		}
+
+		return MU_FALSE;
+	}
+
+	// Gets the slot of the codepoint at the given offset; O(log n)
+	// Returns false if no slot
+	muBool CyGetSlotAtOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset, CyChunkSlot* slot) {
+		CyFlushTouchedChunks(file);
+		if (offset >= file->root->subtree.codepoints) {
+			return MU_FALSE;
+		}
+
+		// Find the chunk, then the codepoint within it
+		CyTextStats before;
+		slot->chunk = CyIndexFind(file, offset, MU_FALSE, &before);
+		offset -= before.codepoints;
+		for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+			if (slot->chunk->data[c] == 0) {
+				continue;
+			}
+			if (offset == 0) {
+				slot->index = c;
+				slot->codepoint = slot->chunk->data[c];
+				return MU_TRUE;
+			}
+			--offset;
+		}
+
+		return MU_FALSE;
+	}
+
 	// Returns whether or not a given slot is at the cursor
 	muBool CyIsSlotAtCursor(CyChunkedFile* file, CyChunkSlot* slot) {
 		// First, simply check if they're equal to each other
@@ -542,3 +1459,194 @@
 		return file->cursorChunk == slot->chunk && file->cursorIndex == slot->index;
 	}
 
+	// Gets the statistics of the entire file
+	// O(1) outside of a transaction
+	void CyGetChunkedFileStats(CyChunkedFile* file, CyTextStats* stats) {
+		CyFlushTouchedChunks(file);
+		*stats = file->root->subtree;
+	}
+
+	// Gets the statistics of the first n codepoints
+	// If n is within the file, also gets the codepoint at n and the one before it (0 if none)
+	void CyGetStatsBefore(CyChunkedFile* file, uint32_m n, CyTextStats* stats, uint32_m* at, uint32_m* prev) {
+		*at = *prev = 0;
+
+		// Everything
+		if (n >= file->root->subtree.codepoints) {
+			*stats = file->root->subtree;
+			return;
+		}
+
+		// Find the chunk, then count the rest within it
+		CyFileChunk* chunk = CyIndexFind(file, n, MU_FALSE, stats);
+		n -= stats->codepoints;
+		*prev = CyCodepointBeforeChunk(chunk);
+		for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+			if (chunk->data[c] == 0) {
+				continue;
+			}
+			if (n == 0) {
+				*at = chunk->data[c];
+				return;
+			}
+			CyCountCodepoint(file, stats, chunk->data[c], *prev);
+			*prev = chunk->data[c];
+			--n;
+		}
+	}
+
+	// Gets the statistics of the codepoints [start, end), such as a selection
+	// O(log n)
+	void CyGetChunkedFileRangeStats(CyChunkedFile* file, uint32_m start, uint32_m end, CyTextStats* stats) {
+		CyFlushTouchedChunks(file);
+
+		if (end <= start) {
+			memset(stats, 0, sizeof(CyTextStats));
+			return;
+		}
+
+		// Range is what's before the end minus what's before the start
+		CyTextStats before;
+		uint32_m startAt, startPrev, endAt, endPrev;
+		CyGetStatsBefore(file, start, &before, &startAt, &startPrev);
+		CyGetStatsBefore(file, end, stats, &endAt, &endPrev);
+		CySubtractStats(stats, &before);
+		stats->leadColumns = stats->tabColumns = 0;
+		stats->tabbed = MU_FALSE;
+
+		// A word cut off by the start still counts within the range
+		if (startAt != 0 && startPrev != 0 && CyIsWordCodepoint(startAt) && CyIsWordCodepoint(startPrev)) {
+			++stats->words;
+		}
+	}
+
+	// Gets the line the given offset is on, starting at 0; O(log n)
+	uint32_m CyGetLineOfOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset) {
+		CyFlushTouchedChunks(file);
+		CyTextStats before;
+		uint32_m at, prev;
+		CyGetStatsBefore(file, offset, &before, &at, &prev);
+		return before.newlines;
+	}
+
+	// Gets the offset of the start of the given line, starting at 0; O(log n)
+	// Clamps to the last line
+	uint32_m CyGetLineStartInChunkedFile(CyChunkedFile* file, uint32_m line) {
+		CyFlushTouchedChunks(file);
+		if (line > file->root->subtree.newlines) {
+			line = file->root->subtree.newlines;
+		}
+		if (line == 0) {
+			return 0;
+		}
+
+		// Find the newline ending the previous line
+		CyTextStats before;
+		CyFileChunk* chunk = CyIndexFind(file, line-1, MU_TRUE, &before);
+		uint32_m n = (line-1) - before.newlines;
+		uint32_m offset = before.codepoints;
+		for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+			if (chunk->data[c] == 0) {
+				continue;
+			}
+			if (chunk->data[c] == 13) {
+				if (n == 0) {
+					return offset+1;
+				}
+				--n;
+			}
+			++offset;
+		}
+		return offset;
+	}
+
+	// Gets the offset of the end of the given line (before its newline); O(log n)
+	// Clamps to the last line
+	uint32_m CyGetLineEndInChunkedFile(CyChunkedFile* file, uint32_m line) {
+		CyFlushTouchedChunks(file);
+		if (line >= file->root->subtree.newlines) {
+			return file->root->subtree.codepoints;
+		}
+		return CyGetLineStartInChunkedFile(file, line+1) - 1;
+	}
+
+	// Gets the column of the given offset within its line; O(log n)
+	uint32_m CyGetColumnOfOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset) {
+		CyFlushTouchedChunks(file);
+		CyTextStats before;
+		uint32_m at, prev;
+		CyGetStatsBefore(file, offset, &before, &at, &prev);
+		return CyStatsColumn(file, &before);
+	}
+
+	// Gets the offset of the codepoint taking up the given column of a
+	// line; O(log n)
+	uint32_m CyGetOffsetOfColumnInChunkedFile(CyChunkedFile* file, uint32_m line, uint32_m column, uint32_m* start) {
+		CyFlushTouchedChunks(file);
+		if (line > file->root->subtree.newlines) {
+			line = file->root->subtree.newlines;
+		}
+
+		// Past the end of the file
+		CyTextStats before;
+		CyFileChunk* chunk = CyIndexFindColumn(file, line, column, &before);
+		if (!chunk) {
+			*start = CyStatsColumn(file, &before);
+			return before.codepoints;
+		}
+
+		// Find the codepoint within the chunk
+		for (uint32_m c = 0; c < FILE_CHUNK_CODEPOINTS; ++c) {
+			if (chunk->data[c] == 0) {
+				continue;
+			}
+			CyTextStats next = before;
+			CyCountCodepoint(file, &next, chunk->data[c], 0);
+			if (CyStatsPastColumn(file, &next, line, column)) {
+				break;
+			}
+			before = next;
+		}
+		*start = CyStatsColumn(file, &before);
+		return before.codepoints;
+	}
+
+	// Starts iterating over grapheme clusters at the last boundary at or before
+	// the given offset
+	void CyBeginGraphemesInChunkedFile(CyChunkedFile* file, uint32_m offset, CySegmentIterator* iter) {
+		CyBeginSegments(file, offset, MU_FALSE, iter);
+	}
+
+	// Moves on to the next grapheme cluster boundary
+	// Returns false if already at the end of the file
+	muBool CyGetNextGraphemeInChunkedFile(CySegmentIterator* iter) {
+		return CyAdvanceSegmentIterator(iter, MU_FALSE);
+	}
+
+	// Starts iterating over words at the last boundary at or before the given
+	// offset
+	void CyBeginWordsInChunkedFile(CyChunkedFile* file, uint32_m offset, CySegmentIterator* iter) {
+		CyBeginSegments(file, offset, MU_TRUE, iter);
+	}
+
+	// Moves on to the next word boundary
+	// Returns false if already at the end of the file
+	muBool CyGetNextWordInChunkedFile(CySegmentIterator* iter) {
+		return CyAdvanceSegmentIterator(iter, MU_TRUE);
+	}
+
+	// Gets the word containing the codepoint at the given offset as [start, end)
+	// Returns whether or not it's an actual word
+	muBool CyGetWordAtOffsetInChunkedFile(CyChunkedFile* file, uint32_m offset, uint32_m* start, uint32_m* end) {
+		CySegmentIterator iter;
+		CyFlushTouchedChunks(file);
+		uint32_m total = file->root->subtree.codepoints;
+		CyBeginSegments(file, (offset < total || total == 0) ? offset : (total-1), MU_TRUE, &iter);
+
+		*start = iter.offset;
+		muBool word = !iter.end && CyIsWordCodepoint(iter.slot.codepoint);
+		CyAdvanceSegmentIterator(&iter, MU_TRUE);
+		*end = iter.offset;
+		return word;
+	}
+
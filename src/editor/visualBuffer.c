@@ -6,60 +6,95 @@
 #include "core/gfx.h"
 
 #include <math.h>
+#include <string.h>
 
 /* Inner */
 
-	// Sets proper offsets for a given codepoint slot
-	void CyOffsetCodepoint(CyEditorBox* box, mug2DTextureArrayRect* rect, uint32_m codepoint, float mult, uint32_m i) {
-		// Get glyph header
-		uint16_m glyphID = CyFontGetGlyphID(box->font, codepoint);
-		muttGlyphHeader header;
-		if (mutt_result_is_fatal(mutt_glyph_header(&box->font->font, glyphID, &header))) {
-			return;
-		}
-
-		// Calculate column and row
-		int32_m r = (i / box->textDim[0]);
-		int32_m c = i - (r * box->textDim[0]);
+	// Gets the line of a cell's row, relative to the anchor line
+	float CyGetCellRow(CyEditorBox* box, uint32_m i) {
+		uint32_m line = box->rowLines[i / box->textDim[0]];
+		return (float)((int64_m)line - (int64_m)box->anchorLine);
+	}
 
-		// Get rglyph metrics
-		muttRGlyph rglyph;
-		mutt_rglyph_metrics(&box->font->font, &header, glyphID, &rglyph, box->font->pointSize, PPI);
-		mutt_funits_punits_min_max(&box->font->font, &header, &rglyph, box->font->pointSize, PPI);
+	// Gets the top of a ring row's glyphs, in pixels relative to the anchor
+	// line; worked out once per row rather than for each of its cells
+	float CyGetRowTop(CyEditorBox* box, uint32_m row) {
+		return (float)((int64_m)box->rowLines[row] - (int64_m)box->anchorLine) * roundf(box->font->pHeight);
+	}
 
-		// Offset x-value by lsb
-		rect->center.pos[0] = (((float)c) * box->font->pAdvanceWidth) + (box->font->layerDim[0] * 0.5f);
-		rect->center.pos[0] += rglyph.lsb * mult;
-		rect->center.pos[0] = roundf(rect->center.pos[0]) + .5f;
-		// Offset y-value by this magic thing that works
-		rect->center.pos[1] = (((float)(r-1)) * roundf(box->font->pHeight)) - (box->font->layerDim[1] * 0.5f);
-		rect->center.pos[1] += ((rglyph.ascender * 2.f) - rglyph.descender) * mult;
-		rect->center.pos[1] = roundf(rect->center.pos[1]);
+	// Gets the left of the box's text within the window, in pixels, which
+	// is right of the gutter
+	float CyGetTextLeft(CyEditorBox* box) {
+		return box->origin[0] + roundf(((float)box->gutterColumns) * box->font->pAdvanceWidth);
 	}
 
-	// Sets a codepoint given index
-	void CySetCodepoint(CyEditorBox* box, uint32_m i, uint32_m codepoint) {
-		// De-offset codepoint offsets
-		CyOffsetCodepoint(box, &box->textRects[i], box->slots[i].codepoint, -1.f, i);
+	// Sets proper offsets for a given codepoint's glyph, given its column
+	// and the top of its row
+	void CyOffsetCodepoint(CyEditorBox* box, mug2DTextureArrayRect* rect, uint32_m codepoint, uint32_m column, float top) {
+		// Get cached glyph metrics
+		const CyGlyphMetrics* metrics = CyFontGetGlyphMetrics(box->font, codepoint);
 
-		// Get texture and layer for codepoint
-		uint16_m texture, layer;
-		CyFontGetTexture(box->font, codepoint, &texture, &layer);
+		// Position within the grid, offset by the metrics
+		rect->center.pos[0] = roundf((((float)column) * box->font->pAdvanceWidth) + metrics->xOffset) + .5f;
+		rect->center.pos[1] = roundf(top + metrics->yOffset);
+	}
 
-		// Change texture info
-		box->textRects[i].tex_pos[2] = layer;
-		box->slots[i].texture = texture;
-		box->slots[i].layer = layer;
-		box->slots[i].codepoint = codepoint;
+	// Notes that a glyph needs to be uploaded
+	void CyMarkGlyph(CyEditorBox* box, uint32_m g) {
+		if (box->changedGlyphs[g]) {
+			return;
+		}
+		box->changedGlyphs[g] = MU_TRUE;
+		if (g < box->firstChangedGlyph) {
+			box->firstChangedGlyph = g;
+		}
+		if (g >= box->lastChangedGlyph) {
+			box->lastChangedGlyph = g + 1;
+		}
+	}
 
-		// Offset codepoint
-		CyOffsetCodepoint(box, &box->textRects[i], codepoint, 1.f, i);
+	// Uploads glyphs [first, last), if any
+	void CyUploadGlyphs(CyEditorBox* box, uint32_m first, uint32_m last) {
+		if (first == last) {
+			return;
+		}
+
+		CyGfxSubfillObjects(box->textRectBuf, first, last - first, &box->textRects[first]);
+		++box->refreshStats.uploadSpans;
+		box->refreshStats.uploadBytes += (last - first) * sizeof(mug2DTextureArrayRect);
 	}
 
-	// Calculates the default info of a texture rect
-	void CyDefaultTextureCodepoint(CyEditorBox* box, uint32_m c, uint32_m r, uint32_m i, uint32_m layer) {
-		mug2DTextureArrayRect* rect = &box->textRects[i];
+	// Uploads the changed glyphs that are still drawn
+	// Changed glyphs are gathered into spans, uploaded once they're complete
+	void CyUploadChangedGlyphs(CyEditorBox* box) {
+		uint32_m spanStart = 0, spanEnd = 0;
+		for (uint32_m g = box->firstChangedGlyph; g < box->lastChangedGlyph; ++g) {
+			if (!box->changedGlyphs[g]) {
+				continue;
+			}
+			box->changedGlyphs[g] = MU_FALSE;
+			// (Changed glyphs past the end have since been taken away)
+			if (g >= box->numGlyphs) {
+				continue;
+			}
+
+			// Extend the current span if it's close enough, and start a new one if not
+			if (spanEnd != spanStart && g <= spanEnd + EDITOR_BOX_SPAN_GAP) {
+				spanEnd = g + 1;
+				continue;
+			}
+			CyUploadGlyphs(box, spanStart, spanEnd);
+			spanStart = g;
+			spanEnd = g + 1;
+		}
+		CyUploadGlyphs(box, spanStart, spanEnd);
 
+		box->firstChangedGlyph = box->numRects * EDITOR_BOX_CELL_GLYPHS;
+		box->lastChangedGlyph = 0;
+	}
+
+	// Calculates the info of a cell's glyph that doesn't depend on its codepoint
+	void CyDefaultTextureCodepoint(CyEditorBox* box, uint32_m i, mug2DTextureArrayRect* rect) {
 		// Z-value:
 		rect->center.pos[2] =
 			// Percentage of way through numRects
@@ -68,41 +103,201 @@
 			* 0.5f) + 0.5f
 		;
 
-		// Offset value for space
-		CyOffsetCodepoint(box, rect, 0x20, 1.f, i);
-
 		// Color
-		rect->center.col[0] = rect->center.col[1] =
-		rect->center.col[2] = rect->center.col[3] = 1.f;
+		memcpy(rect->center.col, box->palette[EDITOR_BOX_TEXT(box->slots[i].colors)], sizeof(float) * 4);
 		// Dimensions
 		rect->dim[0] = box->font->layerDim[0];
 		rect->dim[1] = box->font->layerDim[1];
 
 		// Rotation
 		rect->rot = 0.f;
+	}
+
+	// Gets where the index of a cell's glyph is kept, given the cell
+	// with EDITOR_BOX_MARK_GLYPH set for its mark's glyph
+	uint32_m* CyGetGlyphIndex(CyEditorBox* box, uint32_m cell) {
+		CyEditorBoxSlot* slot = &box->slots[cell & ~EDITOR_BOX_MARK_GLYPH];
+		return (cell & EDITOR_BOX_MARK_GLYPH) ? &slot->markGlyph : &slot->glyph;
+	}
+
+	// Gives a cell a glyph after the ones already drawn; see CyGetGlyphIndex
+	void CyAddGlyph(CyEditorBox* box, uint32_m cell) {
+		uint32_m g = box->numGlyphs++;
+		*CyGetGlyphIndex(box, cell) = g;
+		box->glyphCells[g] = cell;
+		CyDefaultTextureCodepoint(box, cell & ~EDITOR_BOX_MARK_GLYPH, &box->textRects[g]);
+	}
+
+	// Takes a cell's glyph away, moving the last glyph into its place so
+	// that the drawn glyphs stay packed; see CyGetGlyphIndex
+	void CyRemoveGlyph(CyEditorBox* box, uint32_m cell) {
+		uint32_m* index = CyGetGlyphIndex(box, cell);
+		uint32_m g = *index;
+		uint32_m last = --box->numGlyphs;
+		*index = EDITOR_BOX_NO_GLYPH;
+		if (g == last) {
+			return;
+		}
 
-		// Cut-out
-		rect->tex_pos[0] = rect->tex_pos[1] = 0.f;
-		rect->tex_pos[2] = layer;
-		rect->tex_dim[0] = rect->tex_dim[1] = 1.f;
+		box->textRects[g] = box->textRects[last];
+		box->glyphCells[g] = box->glyphCells[last];
+		*CyGetGlyphIndex(box, box->glyphCells[g]) = g;
+		CyMarkGlyph(box, g);
 	}
 
-	// Calculates the default info of a color rect
-	void CyDefaultColorCodepoint(CyEditorBox* box, uint32_m c, uint32_m r, uint32_m i) {
-		mugRect* rect = &box->colRects[i];
+	// Takes the glyphs of a cell and of its mark away, if it has them
+	void CyRemoveGlyphs(CyEditorBox* box, uint32_m i) {
+		if (box->slots[i].glyph != EDITOR_BOX_NO_GLYPH) {
+			CyRemoveGlyph(box, i);
+		}
+		if (box->slots[i].markGlyph != EDITOR_BOX_NO_GLYPH) {
+			CyRemoveGlyph(box, i | EDITOR_BOX_MARK_GLYPH);
+		}
+	}
 
+	// Sets a cell's glyph to a codepoint, along with its column and the
+	// top of its row; see CyGetGlyphIndex
+	void CySetGlyph(CyEditorBox* box, uint32_m cell, uint32_m codepoint, uint32_m column, float top) {
+		uint32_m* index = CyGetGlyphIndex(box, cell);
+
+		// Blank cells don't get a glyph at all
+		if (CyFontGetGlyphMetrics(box->font, codepoint)->blank) {
+			if (*index != EDITOR_BOX_NO_GLYPH) {
+				CyRemoveGlyph(box, cell);
+			}
+			return;
+		}
+		if (*index == EDITOR_BOX_NO_GLYPH) {
+			CyAddGlyph(box, cell);
+		}
+
+		// Get texture and layer for codepoint
+		uint16_m texture, layer;
+		CyFontGetTexture(box->font, codepoint, &texture, &layer);
+
+		// Change texture info
+		mug2DTextureArrayRect* rect = &box->textRects[*index];
+		CyFontGetCutout(texture, layer, rect->tex_pos, rect->tex_dim);
+
+		// Offset codepoint
+		CyOffsetCodepoint(box, rect, codepoint, column, top);
+		CyMarkGlyph(box, *index);
+	}
+
+	// Sets a codepoint given index, along with its column and the top of
+	// its row
+	void CySetCodepoint(CyEditorBox* box, uint32_m i, uint32_m codepoint, uint32_m column, float top) {
+		box->slots[i].codepoint = codepoint;
+		CySetGlyph(box, i, codepoint, column, top);
+	}
+
+	// Sets the mark combining with a cell's codepoint, drawn over it
+	void CySetMark(CyEditorBox* box, uint32_m i, uint32_m mark, uint32_m column, float top) {
+		CyEditorBoxSlot* slot = &box->slots[i];
+		slot->mark = mark;
+		if (mark == 0) {
+			if (slot->markGlyph != EDITOR_BOX_NO_GLYPH) {
+				CyRemoveGlyph(box, i | EDITOR_BOX_MARK_GLYPH);
+			}
+			return;
+		}
+		CySetGlyph(box, i | EDITOR_BOX_MARK_GLYPH, mark, column, top);
+	}
+
+	// Sets the color of a glyph from the palette
+	void CyColorGlyph(CyEditorBox* box, uint32_m g) {
+		uint8_m colors = box->slots[box->glyphCells[g] & ~EDITOR_BOX_MARK_GLYPH].colors;
+		memcpy(box->textRects[g].center.col, box->palette[EDITOR_BOX_TEXT(colors)], sizeof(float) * 4);
+		CyMarkGlyph(box, g);
+	}
+
+	// Sets a color of the palette
+	void CySetPaletteColor(CyEditorBox* box, uint8_m index, float r, float g, float b, float a) {
+		box->palette[index][0] = r;
+		box->palette[index][1] = g;
+		box->palette[index][2] = b;
+		box->palette[index][3] = a;
+	}
+
+	// Sets a cell to a codepoint that draws nothing, with no mark, if it
+	// isn't already
+	void CyBlankCell(CyEditorBox* box, uint32_m i, uint32_m codepoint) {
+		CyEditorBoxSlot* slot = &box->slots[i];
+		if (slot->codepoint == codepoint && slot->mark == 0) {
+			return;
+		}
+		slot->codepoint = codepoint;
+		slot->mark = 0;
+		CyRemoveGlyphs(box, i);
+		++box->refreshStats.changedCells;
+	}
+
+	// Sets the cells of a run laid out for a ring row, skipping the ones
+	// that already show it
+	// Changed glyphs are uploaded at the end of the refresh
+	void CyUpdateRun(CyEditorBox* box, uint32_m row, float top, CyCellRun* run) {
+		uint32_m end = run->column + run->columns;
+		if (end > box->textDim[0]) {
+			end = box->textDim[0];
+		}
+		uint32_m i = (row * box->textDim[0]) + run->column;
+
+		// Runs of spaces, like the padding of tabs, are filled without
+		// looking up the glyph of each cell
+		if (run->codepoint == 0x20 && run->mark == 0) {
+			for (uint32_m c = run->column; c < end; ++c, ++i) {
+				CyBlankCell(box, i, 0x20);
+			}
+			return;
+		}
+
+		// Otherwise the first cell shows the codepoint, and the rest are
+		// covered by it
+		CyEditorBoxSlot* slot = &box->slots[i];
+		if (slot->codepoint != run->codepoint || slot->mark != run->mark) {
+			CySetCodepoint(box, i, run->codepoint, run->column, top);
+			CySetMark(box, i, run->mark, run->column, top);
+			++box->refreshStats.changedCells;
+		}
+		for (uint32_m c = run->column + 1; c < end; ++c) {
+			CyBlankCell(box, ++i, EDITOR_BOX_COVERED_CELL);
+		}
+	}
+
+	// Lays a ring row out for another line, moving its glyphs along
+	void CyMoveRow(CyEditorBox* box, uint32_m row, uint32_m line) {
+		box->rowLines[row] = line;
+		float top = CyGetRowTop(box, row);
+
+		uint32_m i = row * box->textDim[0];
+		for (uint32_m c = 0; c < box->textDim[0]; ++c, ++i) {
+			uint32_m g = box->slots[i].glyph;
+			if (g != EDITOR_BOX_NO_GLYPH) {
+				CyOffsetCodepoint(box, &box->textRects[g], box->slots[i].codepoint, c, top);
+				CyMarkGlyph(box, g);
+			}
+			g = box->slots[i].markGlyph;
+			if (g != EDITOR_BOX_NO_GLYPH) {
+				CyOffsetCodepoint(box, &box->textRects[g], box->slots[i].mark, c, top);
+				CyMarkGlyph(box, g);
+			}
+		}
+	}
+
+	// Calculates the background rect of the cells [i, i+columns) of a row
+	void CyDefaultColorCodepoint(CyEditorBox* box, mugRect* rect, uint32_m i, uint32_m columns) {
 		// X-value:
 		rect->center.pos[0] =
-			// Offset center to generally where slot is on the X
-			(((float)c) * box->font->pAdvanceWidth)
+			// Offset center to generally where the first slot is on the X
+			(((float)(i % box->textDim[0])) * box->font->pAdvanceWidth)
 			// Offset by half dimensions to account for position being center of rect
-			+ (box->font->pAdvanceWidth * 0.5f)
+			+ (((float)columns) * box->font->pAdvanceWidth * 0.5f)
 		;
 
 		// Y-value:
 		rect->center.pos[1] =
 			// Offset center to generally where slot is on the Y
-			(((float)r) * box->font->pHeight)
+			(CyGetCellRow(box, i) * box->font->pHeight)
 			// Offset by half dimensions to account for position being center of rect
 			+ (box->font->pHeight * 0.5f)
 		;
@@ -116,29 +311,66 @@
 		;
 
 		// Color:
-		rect->center.col[0] = rect->center.col[1] =
-		rect->center.col[2] = 0.f;
-		rect->center.col[3] = 1.f;
+		memcpy(rect->center.col, box->palette[EDITOR_BOX_BACKGROUND(box->slots[i].colors)], sizeof(float) * 4);
 
 		// Dimensions:
-		rect->dim[0] = box->font->pAdvanceWidth;
+		rect->dim[0] = ((float)columns) * box->font->pAdvanceWidth;
 		rect->dim[1] = box->font->pHeight;
 
 		// Rotation:
 		rect->rot = 0.f;
 	}
 
-	// Sets default codepoint information
-	void CySetDefaultCodepoint(CyEditorBox* box, uint32_m c, uint32_m r, uint16_m texture, uint16_m layer) {
-		uint32_m i = (r * box->textDim[0]) + c;
-		CyEditorBoxSlot* slot = &box->slots[i];
+	// Returns whether or not an RGBA color shows up over the clear color
+	muBool CyIsColorShown(const float* color) {
+		const float clear[3] = { GFX_CLEAR_COLOR };
+		return color[3] != 0.f && (color[0] != clear[0] || color[1] != clear[1] || color[2] != clear[2]);
+	}
 
-		// Set default info
-		CyDefaultTextureCodepoint(box, c, r, i, layer);
-		CyDefaultColorCodepoint(box, c, r, i);
-		slot->texture = texture;
-		slot->layer = layer;
-		slot->codepoint = 0x20;
+	// Gathers each run of cells in a row with a background that shows up
+	// into a background rect, uploading the ones that changed
+	void CyUpdateBackgrounds(CyEditorBox* box) {
+		muBool shown[EDITOR_BOX_PALETTE_SIZE];
+		for (uint8_m c = 0; c < EDITOR_BOX_PALETTE_SIZE; ++c) {
+			shown[c] = CyIsColorShown(box->palette[c]);
+		}
+
+		uint32_m count = 0;
+		uint32_m firstChanged = box->numRects;
+		for (uint32_m r = 0; r < box->numRows; ++r) {
+			uint32_m i = ((box->ringTop + r) % box->numRows) * box->textDim[0];
+			uint32_m end = i + box->textDim[0];
+
+			while (i < end) {
+				// Find the end of the run
+				uint8_m background = EDITOR_BOX_BACKGROUND(box->slots[i].colors);
+				uint32_m first = i;
+				while (i < end && EDITOR_BOX_BACKGROUND(box->slots[i].colors) == background) {
+					++i;
+				}
+				if (!shown[background]) {
+					continue;
+				}
+
+				// Only rewrite the rect if it's different
+				mugRect rect;
+				CyDefaultColorCodepoint(box, &rect, first, i - first);
+				if (count >= box->numBackgrounds || memcmp(&rect, &box->colRects[count], sizeof(mugRect)) != 0) {
+					box->colRects[count] = rect;
+					if (count < firstChanged) {
+						firstChanged = count;
+					}
+				}
+				++count;
+			}
+		}
+		box->numBackgrounds = count;
+
+		if (firstChanged < count) {
+			CyGfxSubfillObjects(box->colRectBuf, firstChanged, count - firstChanged, &box->colRects[firstChanged]);
+			++box->refreshStats.uploadSpans;
+			box->refreshStats.uploadBytes += (count - firstChanged) * sizeof(mugRect);
+		}
 	}
 
 	// Sets info for cursor
@@ -161,12 +393,13 @@
 
 		// If buffer exists, simply refill and exit
 		if (box->cursorRectBuf) {
-			mu_gobjects_fill(gfx, box->cursorRectBuf, &box->cursorRect);
+			CyGfxFillObjects(box->cursorRectBuf, &box->cursorRect);
+			box->refreshStats.uploadBytes += sizeof(mugRect);
 			return MU_TRUE;
 		}
 
 		// If it doesn't, needs to be created
-		box->cursorRectBuf = mu_gobjects_create(gfx, MUG_OBJECT_RECT, 1, &box->cursorRect);
+		box->cursorRectBuf = CyGfxCreateObjects(MUG_OBJECT_RECT, 1, &box->cursorRect);
 		if (!box->cursorRectBuf) {
 			return MU_FALSE;
 		}
@@ -177,13 +410,827 @@
 	// Destroys the cursor
 	void CyDestroyCursor(CyEditorBox* box) {
 		// Destroy buffer
-		mu_gobjects_destroy(gfx, box->cursorRectBuf);
+		CyGfxDestroyObjects(box->cursorRectBuf);
 	}
 
 	// Renders the cursor
 	void CyRenderCursor(CyEditorBox* box) {
-		// Render the buffer
-		mu_gobjects_render(gfx, box->cursorRectBuf);
+		// Don't render if it's out of view
+		if (!box->cursorVisible) {
+			return;
+		}
+		// Render the buffer, shifted into the box and by the partial scroll
+		float shift[3] = { CyGetTextLeft(box), box->origin[1] - roundf(box->scrollPixels), 0.f };
+		CyGfxShiftObjects(MUG_OBJECT_RECT, shift);
+		CyGfxRenderObjects(box->cursorRectBuf);
+		++box->drawCalls;
+	}
+
+	// Frees the slot information of an editor box
+	void CyFreeEditorBoxSlots(CyEditorBox* box) {
+		free(box->runs);
+		free(box->wrapRows);
+		free(box->rowLines);
+		free(box->changedGlyphs);
+		free(box->glyphCells);
+		free(box->slots);
+		free(box->colRects);
+		free(box->textRects);
+	}
+
+	// Reallocates the room for cells, and the buffers drawn from it
+	// Returns false if the room couldn't be grown, leaving it as it was;
+	// room that can't be given back when shrinking is simply kept
+	muBool CySetEditorBoxCapacity(CyEditorBox* box, uint32_m capacity) {
+		uint32_m oldCapacity = box->rectCapacity;
+		muBool grow = capacity > oldCapacity;
+		uint32_m glyphCapacity = capacity * EDITOR_BOX_CELL_GLYPHS;
+		uint32_m oldGlyphCapacity = oldCapacity * EDITOR_BOX_CELL_GLYPHS;
+
+		// Each array stays at least as big as the old capacity if it fails
+		mug2DTextureArrayRect* textRects = (mug2DTextureArrayRect*)realloc(box->textRects, sizeof(mug2DTextureArrayRect) * glyphCapacity);
+		if (textRects) box->textRects = textRects;
+		mugRect* colRects = (mugRect*)realloc(box->colRects, sizeof(mugRect) * capacity);
+		if (colRects) box->colRects = colRects;
+		CyEditorBoxSlot* slots = (CyEditorBoxSlot*)realloc(box->slots, sizeof(CyEditorBoxSlot) * capacity);
+		if (slots) box->slots = slots;
+		uint32_m* glyphCells = (uint32_m*)realloc(box->glyphCells, sizeof(uint32_m) * glyphCapacity);
+		if (glyphCells) box->glyphCells = glyphCells;
+		muBool* changedGlyphs = (muBool*)realloc(box->changedGlyphs, sizeof(muBool) * glyphCapacity);
+		if (changedGlyphs) box->changedGlyphs = changedGlyphs;
+		if (grow) {
+			if (!textRects || !colRects || !slots || !glyphCells || !changedGlyphs) {
+				CyLog("Failed to grow slot information\n");
+				return MU_FALSE;
+			}
+			memset(&box->textRects[oldGlyphCapacity], 0, sizeof(mug2DTextureArrayRect) * (glyphCapacity - oldGlyphCapacity));
+			memset(&box->colRects[oldCapacity], 0, sizeof(mugRect) * (capacity - oldCapacity));
+			memset(&box->changedGlyphs[oldGlyphCapacity], 0, sizeof(muBool) * (glyphCapacity - oldGlyphCapacity));
+		}
+
+		// Buffers can't be resized, so they're made again with what's there
+		mugObjects textRectBuf = CyGfxCreateObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, glyphCapacity, box->textRects);
+		mugObjects colRectBuf = 0;
+		if (textRectBuf) {
+			colRectBuf = CyGfxCreateObjects(MUG_OBJECT_RECT, capacity, box->colRects);
+		}
+		if (!colRectBuf) {
+			if (textRectBuf) {
+				CyGfxDestroyObjects(textRectBuf);
+			}
+			if (grow) {
+				CyLog("Failed to grow graphical buffers\n");
+				return MU_FALSE;
+			}
+			// (The old buffers are bigger, which is fine)
+			box->rectCapacity = capacity;
+			return MU_TRUE;
+		}
+		CyGfxDestroyObjects(box->textRectBuf);
+		CyGfxDestroyObjects(box->colRectBuf);
+		box->textRectBuf = textRectBuf;
+		box->colRectBuf = colRectBuf;
+		box->rectCapacity = capacity;
+		return MU_TRUE;
+	}
+
+	// Reverses the slots [first, last)
+	void CyReverseSlots(CyEditorBoxSlot* slots, uint32_m first, uint32_m last) {
+		while (first + 1 < last) {
+			CyEditorBoxSlot slot = slots[first];
+			slots[first++] = slots[--last];
+			slots[last] = slot;
+		}
+	}
+
+	// Reverses the row lines [first, last)
+	void CyReverseRowLines(uint32_m* rowLines, uint32_m first, uint32_m last) {
+		while (first + 1 < last) {
+			uint32_m line = rowLines[first];
+			rowLines[first++] = rowLines[--last];
+			rowLines[last] = line;
+		}
+	}
+
+	// Rotates the ring of rows in place so that the top line's row is the
+	// first one, and the rest follow in order
+	void CyUnrollEditorBoxRing(CyEditorBox* box) {
+		if (box->ringTop == 0) {
+			return;
+		}
+		uint32_m split = box->ringTop * box->textDim[0];
+		CyReverseSlots(box->slots, 0, split);
+		CyReverseSlots(box->slots, split, box->numRects);
+		CyReverseSlots(box->slots, 0, box->numRects);
+		CyReverseRowLines(box->rowLines, 0, box->ringTop);
+		CyReverseRowLines(box->rowLines, box->ringTop, box->numRows);
+		CyReverseRowLines(box->rowLines, 0, box->numRows);
+		box->ringTop = 0;
+	}
+
+	// Forgets what the gutter's rows show, so that each is drawn again
+	void CyForgetGutter(CyEditorBox* box) {
+		for (uint32_m r = 0; r < box->rowCapacity; ++r) {
+			box->gutterLines[r] = 0xFFFFFFFF;
+		}
+	}
+
+	// Frees the gutter of an editor box
+	void CyFreeEditorBoxGutter(CyEditorBox* box) {
+		if (box->gutterRectBuf) {
+			CyGfxDestroyObjects(box->gutterRectBuf);
+		}
+		free(box->gutterRects);
+		free(box->gutterLines);
+		box->gutterRectBuf = 0;
+		box->gutterRects = 0;
+		box->gutterLines = 0;
+	}
+
+	// Reallocates the gutter to have room for some rows, with its buffer
+	// made again; every row is drawn again afterwards
+	// Returns false if it couldn't be, in which case it's freed
+	muBool CySetGutterCapacity(CyEditorBox* box, uint32_m rows) {
+		uint32_m count = rows * EDITOR_BOX_GUTTER_MAX_DIGITS;
+		uint32_m* gutterLines = (uint32_m*)realloc(box->gutterLines, sizeof(uint32_m) * rows);
+		if (gutterLines) box->gutterLines = gutterLines;
+		mug2DTextureArrayRect* gutterRects = (mug2DTextureArrayRect*)realloc(box->gutterRects, sizeof(mug2DTextureArrayRect) * count);
+		if (gutterRects) box->gutterRects = gutterRects;
+		if (!gutterLines || !gutterRects) {
+			CyFreeEditorBoxGutter(box);
+			return MU_FALSE;
+		}
+		memset(box->gutterRects, 0, sizeof(mug2DTextureArrayRect) * count);
+		for (uint32_m r = 0; r < rows; ++r) {
+			box->gutterLines[r] = 0xFFFFFFFF;
+		}
+
+		// (Buffers can't be resized)
+		if (box->gutterRectBuf) {
+			CyGfxDestroyObjects(box->gutterRectBuf);
+		}
+		box->gutterRectBuf = CyGfxCreateObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, count, box->gutterRects);
+		if (!box->gutterRectBuf) {
+			CyFreeEditorBoxGutter(box);
+			return MU_FALSE;
+		}
+		box->firstGutterRow = rows;
+		box->lastGutterRow = 0;
+		return MU_TRUE;
+	}
+
+	// Draws the line number of a ring row into its gutter, right-aligned;
+	// 0 draws none, leaving the row blank
+	void CyDrawGutterRow(CyEditorBox* box, uint32_m row, uint32_m number) {
+		box->gutterLines[row] = number;
+		uint32_m digits = box->gutterColumns - 1;
+		float top = CyGetRowTop(box, row);
+		mug2DTextureArrayRect* rects = &box->gutterRects[row * digits];
+
+		// Digits from the last one back, then spaces once there are none left
+		for (uint32_m d = digits; d-- > 0;) {
+			uint32_m codepoint = 0x20;
+			if (number != 0) {
+				codepoint = 0x30 + (number % 10);
+				number /= 10;
+			}
+
+			mug2DTextureArrayRect* rect = &rects[d];
+			uint16_m texture, layer;
+			CyFontGetTexture(box->font, codepoint, &texture, &layer);
+			CyFontGetCutout(texture, layer, rect->tex_pos, rect->tex_dim);
+			CyOffsetCodepoint(box, rect, codepoint, d, top);
+			rect->center.pos[2] = .5f;
+			memcpy(rect->center.col, box->palette[EDITOR_BOX_GUTTER_COLOR], sizeof(float) * 4);
+			rect->dim[0] = box->font->layerDim[0];
+			rect->dim[1] = box->font->layerDim[1];
+			rect->rot = 0.f;
+		}
+
+		if (row < box->firstGutterRow) {
+			box->firstGutterRow = row;
+		}
+		if (row >= box->lastGutterRow) {
+			box->lastGutterRow = row + 1;
+		}
+		++box->refreshStats.gutterRows;
+	}
+
+	// Uploads the gutter rows drawn since the last upload, if any
+	void CyUploadGutter(CyEditorBox* box) {
+		if (box->firstGutterRow < box->lastGutterRow) {
+			uint32_m digits = box->gutterColumns - 1;
+			uint32_m first = box->firstGutterRow * digits;
+			uint32_m count = (box->lastGutterRow - box->firstGutterRow) * digits;
+			CyGfxSubfillObjects(box->gutterRectBuf, first, count, &box->gutterRects[first]);
+			++box->refreshStats.uploadSpans;
+			box->refreshStats.uploadBytes += count * sizeof(mug2DTextureArrayRect);
+		}
+		box->firstGutterRow = box->rowCapacity;
+		box->lastGutterRow = 0;
+	}
+
+	// Sets a slot to be laid out from scratch
+	void CyClearSlot(CyEditorBoxSlot* slot) {
+		slot->codepoint = 0xFFFFFFFF;
+		slot->mark = 0;
+		slot->glyph = slot->markGlyph = EDITOR_BOX_NO_GLYPH;
+		slot->colors = EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR);
+	}
+
+	// Gets the amount of columns a codepoint takes up at a given column
+	uint32_m CyGetCodepointColumns(CyEditorBox* box, uint32_m codepoint, uint32_m column) {
+		// Tabs go to the next tab stop
+		if (codepoint == 0x09) {
+			return box->file.tabWidth - (column % box->file.tabWidth);
+		}
+		return CyGetCodepointCells(codepoint);
+	}
+
+	// Finds a row of a wrapped line, stopping at the given row or at the row
+	// holding the given offset, whichever comes first; sets row to the row
+	// stopped at, and returns the column of the line that it starts at
+	// A wide codepoint cut off by the end of a row goes on the next row
+	// instead, so rows are gone through from the start of the line, unless
+	// it's all ASCII and every row is simply as wide as the box
+	uint32_m CyFindWrappedRow(CyEditorBox* box, uint32_m line, uint32_m offset, uint32_m* row) {
+		uint32_m width = box->textDim[0];
+		uint32_m start = CyGetLineStartInChunkedFile(&box->file, line);
+		uint32_m end = CyGetLineEndInChunkedFile(&box->file, line);
+		if (offset > end) {
+			offset = end;
+		}
+
+		CyTextStats stats;
+		CyGetChunkedFileRangeStats(&box->file, start, end, &stats);
+		if (stats.nonASCII == 0) {
+			uint32_m found = CyGetColumnOfOffsetInChunkedFile(&box->file, offset) / width;
+			if (found < *row) {
+				*row = found;
+			}
+			return *row * width;
+		}
+
+		uint32_m target = *row;
+		uint32_m rowStart = 0;
+		uint32_m column = 0;
+		*row = 0;
+		CyChunkSlot slot;
+		CyGetSlotAtOffsetInChunkedFile(&box->file, start, &slot);
+		uint32_m o = start;
+		while (*row < target) {
+			// Once a row is full, the rest goes on the next one (a tab going
+			// past it goes on over as many as it takes)
+			if (column >= rowStart + width) {
+				rowStart += width;
+				++*row;
+				continue;
+			}
+
+			// A wide codepoint cut off by the end of the row starts the next
+			// one, unless it's the first in its row and won't fit anyway
+			uint32_m columns = (o < end) ? CyGetCodepointColumns(box, slot.codepoint, column) : 0;
+			if (o < end && slot.codepoint != 0x09 && column > rowStart && column + columns > rowStart + width) {
+				rowStart = column;
+				++*row;
+				continue;
+			}
+
+			if (o == offset) {
+				break;
+			}
+			column += columns;
+			++o;
+			CyGetNextSlotInChunkedFile(&slot);
+		}
+		return rowStart;
+	}
+
+	// Seeks a row layout to the first codepoint of a row starting at a
+	// column of a line, without going through the columns before it
+	// A tab cut off by the start of the row is gone past, leaving the
+	// column after it
+	void CySeekRowLayout(CyEditorBox* box, CyRowLayout* layout, uint32_m line, uint32_m rowStart) {
+		layout->line = line;
+		layout->rowStart = rowStart;
+		if (rowStart == 0) {
+			layout->offset = CyGetLineStartInChunkedFile(&box->file, line);
+			layout->column = 0;
+			layout->more = CyGetSlotAtOffsetInChunkedFile(&box->file, layout->offset, &layout->slot);
+			return;
+		}
+
+		layout->offset = CyGetOffsetOfColumnInChunkedFile(&box->file, line, rowStart, &layout->column);
+		layout->more = CyGetSlotAtOffsetInChunkedFile(&box->file, layout->offset, &layout->slot);
+		if (layout->more && layout->column < rowStart && layout->slot.codepoint != 0x0D) {
+			layout->column += CyGetCodepointColumns(box, layout->slot.codepoint, layout->column);
+			layout->more = CyGetNextSlotInChunkedFile(&layout->slot);
+			++layout->offset;
+		}
+
+		// Marks right before the row combine with a codepoint out of view,
+		// but they're gone through again in case the cursor is at one
+		if (layout->column == rowStart) {
+			CyChunkSlot prev;
+			while (layout->offset > 0 && CyGetSlotAtOffsetInChunkedFile(&box->file, layout->offset - 1, &prev) && CyGetCodepointCells(prev.codepoint) == 0) {
+				--layout->offset;
+				layout->slot = prev;
+				layout->more = MU_TRUE;
+			}
+		}
+	}
+
+	// Adds a run to the row being laid out, merging it into the last one if
+	// they're both spaces and next to each other
+	void CyAddCellRun(CyEditorBox* box, CyRowLayout* layout, uint32_m codepoint, uint32_m column, uint32_m columns) {
+		layout->markRun = 0xFFFFFFFF;
+		if (layout->numRuns > 0 && codepoint == 0x20) {
+			CyCellRun* last = &box->runs[layout->numRuns - 1];
+			if (last->codepoint == 0x20 && last->mark == 0 && last->column + last->columns == column) {
+				last->columns += columns;
+				// (The change may have been noted as starting at this run)
+				if (layout->changedRun == layout->numRuns) {
+					layout->changedRun = layout->numRuns - 1;
+				}
+				return;
+			}
+		}
+
+		CyCellRun* run = &box->runs[layout->numRuns++];
+		run->codepoint = codepoint;
+		run->mark = 0;
+		run->column = column;
+		run->columns = columns;
+	}
+
+	// Combines a mark with the codepoint laid out last, unless it's out of
+	// view or already has one; a space merged into a run of them is split
+	// off of it first
+	void CyAttachMark(CyEditorBox* box, CyRowLayout* layout, uint32_m mark) {
+		if (layout->markRun == 0xFFFFFFFF) {
+			return;
+		}
+		CyCellRun* run = &box->runs[layout->markRun];
+		if (run->mark != 0) {
+			return;
+		}
+		if (run->columns > 1 && run->codepoint == 0x20) {
+			run->columns -= 1;
+			CyCellRun* split = &box->runs[layout->numRuns];
+			split->codepoint = 0x20;
+			split->column = run->column + run->columns;
+			split->columns = 1;
+			layout->markRun = layout->numRuns++;
+			run = split;
+		}
+		run->mark = mark;
+	}
+
+	// Lays out the row that a row layout is at into runs, going through its
+	// codepoints once; the cells aren't touched until the runs are applied
+	void CyLayOutRow(CyEditorBox* box, CyRowLayout* layout) {
+		uint32_m rowStart = layout->rowStart;
+		uint32_m rowEnd = rowStart + box->textDim[0];
+		layout->numRuns = 0;
+		layout->markRun = 0xFFFFFFFF;
+		layout->changedRun = 0xFFFFFFFF;
+		layout->cursorColumn = 0xFFFFFFFF;
+		layout->lineEnded = MU_FALSE;
+
+		// The rest of a tab cut off by the start of the row, which may be
+		// where the change starts
+		if (layout->column > rowStart) {
+			if (layout->offset - 1 >= box->dirtyOffset) {
+				layout->changedRun = 0;
+			}
+			CyAddCellRun(box, layout, 0x20, 0, layout->column - rowStart);
+		}
+
+		// Loop through each codepoint of the row
+		while (layout->column < rowEnd) {
+			// Note the first run at or after the change
+			if (layout->changedRun == 0xFFFFFFFF && layout->offset >= box->dirtyOffset) {
+				layout->changedRun = layout->numRuns;
+			}
+			// When wrapping, a wide codepoint cut off by the end of the row
+			// starts the next row instead, past a space left at the end of
+			// this one (see CyFindWrappedRow)
+			if (box->wrap && layout->more && layout->column > rowStart && layout->slot.codepoint != 0x0D && layout->slot.codepoint != 0x09
+				&& layout->column + CyGetCodepointCells(layout->slot.codepoint) > rowEnd
+			) {
+				break;
+			}
+			// If this is where the cursor is, note it
+			// (Rows past the end of the file don't count)
+			if (layout->offset == box->file.cursorOffset && layout->column >= rowStart && layout->line <= layout->lastLine && layout->cursorColumn == 0xFFFFFFFF) {
+				layout->cursorColumn = layout->column - rowStart;
+			}
+
+			// Stop at the end of the file or line
+			if (!layout->more) {
+				layout->lineEnded = MU_TRUE;
+				break;
+			}
+			uint32_m codepoint = layout->slot.codepoint;
+			layout->more = CyGetNextSlotInChunkedFile(&layout->slot);
+			++layout->offset;
+			if (codepoint == 0x0D) {
+				layout->lineEnded = MU_TRUE;
+				break;
+			}
+
+			// Marks combine with the codepoint before them
+			uint32_m columns = CyGetCodepointColumns(box, codepoint, layout->column);
+			if (columns == 0) {
+				CyAttachMark(box, layout, codepoint);
+				continue;
+			}
+
+			// Tabs are laid out as spaces, and so are wide codepoints cut off
+			// by the end of the row when not wrapping, which marks don't
+			// combine with
+			uint32_m shown = codepoint;
+			if (codepoint == 0x09 || layout->column + columns > rowEnd) {
+				shown = 0x20;
+			}
+			CyAddCellRun(box, layout, shown, layout->column - rowStart, columns);
+			if (shown == codepoint) {
+				layout->markRun = layout->numRuns - 1;
+			}
+			layout->column += columns;
+		}
+		// A mark right after the end of the row still combines with the
+		// codepoint before it; it's gone through again by the next row
+		if (!layout->lineEnded && layout->more && layout->markRun != 0xFFFFFFFF && CyGetCodepointCells(layout->slot.codepoint) == 0) {
+			CyAttachMark(box, layout, layout->slot.codepoint);
+		}
+
+		// Set the rest of the row to just space, which is all of it if the
+		// line ends before the row starts
+		uint32_m blank = (layout->column > rowStart) ? layout->column : rowStart;
+		if (blank < rowEnd) {
+			CyAddCellRun(box, layout, 0x20, blank - rowStart, rowEnd - blank);
+		}
+	}
+
+	// Moves a row layout on to the row after the one laid out
+	void CyNextLayoutRow(CyEditorBox* box, CyRowLayout* layout) {
+		// The next row of a wrapped line carries on from this one, starting
+		// at a wide codepoint that didn't fit in it
+		if (box->wrap && !layout->lineEnded) {
+			layout->rowStart += box->textDim[0];
+			if (layout->column < layout->rowStart) {
+				layout->rowStart = layout->column;
+			}
+			return;
+		}
+
+		// Otherwise it's of the next line, at the same column; the rest of
+		// this line and the start of the next are seeked past when they're
+		// out of view
+		++layout->line;
+		layout->rowStart = box->leftColumn;
+		layout->column = 0;
+		if (layout->line > layout->lastLine) {
+			layout->more = MU_FALSE;
+		}
+		if (layout->more && (!layout->lineEnded || layout->rowStart != 0)) {
+			CySeekRowLayout(box, layout, layout->line, layout->rowStart);
+		}
+	}
+
+	// Gets the amount of rows a line takes up; always 1 unless wrapping
+	// Worked out from the line's columns the first time, then cached
+	uint32_m CyGetLineRows(CyEditorBox* box, uint32_m line) {
+		if (!box->wrap) {
+			return 1;
+		}
+		if (line < box->numWrapLines && box->wrapRows[line] != 0) {
+			return box->wrapRows[line];
+		}
+
+		uint32_m rows = 0xFFFFFFFF;
+		CyFindWrappedRow(box, line, 0xFFFFFFFF, &rows);
+		++rows;
+		if (line < box->numWrapLines) {
+			box->wrapRows[line] = rows;
+		}
+		return rows;
+	}
+
+	// Gets the last line of the box's file
+	uint32_m CyGetLastLine(CyEditorBox* box) {
+		CyTextStats stats;
+		CyGetChunkedFileStats(&box->file, &stats);
+		return stats.newlines;
+	}
+
+	// Moves a row, given as a line and a row of it, down or up by some
+	// rows, stopping at the first and last row of the file
+	// Returns how many rows it moved by
+	uint32_m CyMoveEditorBoxRows(CyEditorBox* box, uint32_m* line, uint32_m* segment, muBool down, uint32_m rows) {
+		uint32_m moved = 0;
+		if (down) {
+			uint32_m lastLine = CyGetLastLine(box);
+			while (rows > 0) {
+				uint32_m lineRows = CyGetLineRows(box, *line);
+				// Within the line
+				if (*segment + rows < lineRows) {
+					*segment += rows;
+					return moved + rows;
+				}
+				// Past the last row
+				if (*line == lastLine) {
+					moved += lineRows - 1 - *segment;
+					*segment = lineRows - 1;
+					return moved;
+				}
+				// Onto the next line
+				rows -= lineRows - *segment;
+				moved += lineRows - *segment;
+				++*line;
+				*segment = 0;
+			}
+			return moved;
+		}
+
+		while (rows > 0) {
+			// Within the line
+			if (*segment >= rows) {
+				*segment -= rows;
+				return moved + rows;
+			}
+			// Past the first row
+			if (*line == 0) {
+				moved += *segment;
+				*segment = 0;
+				return moved;
+			}
+			// Onto the last row of the previous line
+			rows -= *segment + 1;
+			moved += *segment + 1;
+			--*line;
+			*segment = CyGetLineRows(box, *line) - 1;
+		}
+		return moved;
+	}
+
+	// Counts the rows from one row, given as a line and a row of it, down
+	// to another at or after it
+	// Stops counting once there are at least limit of them
+	uint32_m CyCountEditorBoxRows(CyEditorBox* box, uint32_m line, uint32_m segment, uint32_m toLine, uint32_m toSegment, uint32_m limit) {
+		if (line == toLine) {
+			return toSegment - segment;
+		}
+		uint32_m rows = CyGetLineRows(box, line) - segment;
+		for (uint32_m l = line + 1; l < toLine && rows < limit; ++l) {
+			rows += CyGetLineRows(box, l);
+		}
+		return rows + toSegment;
+	}
+
+	// Makes room for the rows of each line while wrapping, growing it
+	// geometrically; new lines' rows aren't known
+	muBool CyReserveWrapRows(CyEditorBox* box, uint32_m lines) {
+		if (lines > box->wrapCapacity) {
+			uint32_m capacity = (lines > box->wrapCapacity * 2) ? lines : box->wrapCapacity * 2;
+			uint32_m* wrapRows = (uint32_m*)realloc(box->wrapRows, sizeof(uint32_m) * capacity);
+			if (!wrapRows) {
+				return MU_FALSE;
+			}
+			box->wrapRows = wrapRows;
+			box->wrapCapacity = capacity;
+		}
+		return MU_TRUE;
+	}
+
+	// Forgets the rows of each line, so that they're worked out again
+	void CyForgetWrapRows(CyEditorBox* box) {
+		memset(box->wrapRows, 0, sizeof(uint32_m) * box->numWrapLines);
+		box->wrapScan = 0;
+	}
+
+	// Keeps the rows of each line in step with a change to the file; only
+	// the rows of the lines the change touched are forgotten, and the ones
+	// after it are moved along
+	void CyEditWrapRows(CyEditorBox* box, CyEditRange* range) {
+		uint32_m lines = CyGetLastLine(box) + 1;
+		uint32_m first = CyGetLineOfOffsetInChunkedFile(&box->file, range->offset);
+		uint32_m inserted = CyGetLineOfOffsetInChunkedFile(&box->file, range->offset + range->inserted) - first;
+		uint32_m removed = box->numWrapLines + inserted - lines;
+
+		// Rows are simply worked out each time if there's no room for them
+		if (!CyReserveWrapRows(box, lines)) {
+			CyLog("Failed to grow wrapped rows; no longer caching them\n");
+			free(box->wrapRows);
+			box->wrapRows = 0;
+			box->numWrapLines = box->wrapCapacity = 0;
+			return;
+		}
+
+		// Lines [first, first+removed] became [first, first+inserted]
+		uint32_m oldNext = first + removed + 1;
+		uint32_m newNext = first + inserted + 1;
+		if (oldNext != newNext && oldNext < box->numWrapLines) {
+			memmove(&box->wrapRows[newNext], &box->wrapRows[oldNext], sizeof(uint32_m) * (box->numWrapLines - oldNext));
+		}
+		memset(&box->wrapRows[first], 0, sizeof(uint32_m) * (inserted + 1));
+		box->numWrapLines = lines;
+		if (box->wrapScan > first) {
+			box->wrapScan = first;
+		}
+	}
+
+	// Listens for changes to the editor box's file
+	void CyEditorBoxFileChanged(CyChunkedFile* file, CyEditRange* range, void* data) {
+		CyEditorBox* box = (CyEditorBox*)data;
+		// Everything before the change lays out the same as before, except
+		// for the codepoint right before it, which marks combine with
+		uint32_m offset = (range->offset > 0) ? range->offset - 1 : 0;
+		if (offset < box->dirtyOffset) {
+			box->dirtyOffset = offset;
+		}
+		if (box->wrap && box->wrapRows) {
+			CyEditWrapRows(box, range);
+		}
+	}
+
+	// Resizes the cells of an editor box to some columns and rows, keeping
+	// the ones still in view
+	// Returns false if the room couldn't be grown, leaving the box as it was
+	muBool CyResizeEditorBoxCells(CyEditorBox* box, uint32_m columns, uint32_m rows) {
+		if (columns == box->textDim[0] && rows == box->textDim[1]) {
+			return MU_TRUE;
+		}
+		uint32_m numRows = rows + 1;
+		uint32_m numRects = columns * numRows;
+		// Lines wrap differently at a new width
+		muBool rewrap = box->wrap && columns != box->textDim[0];
+
+		// Grow the room geometrically if there isn't enough
+		if (numRows > box->rowCapacity) {
+			uint32_m capacity = (numRows > box->rowCapacity * 2) ? numRows : box->rowCapacity * 2;
+			uint32_m* rowLines = (uint32_m*)realloc(box->rowLines, sizeof(uint32_m) * capacity);
+			if (!rowLines) {
+				CyLog("Failed to grow row information\n");
+				return MU_FALSE;
+			}
+			box->rowLines = rowLines;
+			box->rowCapacity = capacity;
+			if (box->gutter && !CySetGutterCapacity(box, capacity)) {
+				CyLog("Failed to grow gutter; turning it off\n");
+				box->gutter = MU_FALSE;
+				box->gutterColumns = 0;
+			}
+		}
+		if (columns + 2 > box->runCapacity) {
+			uint32_m capacity = (columns + 2 > box->runCapacity * 2) ? columns + 2 : box->runCapacity * 2;
+			CyCellRun* runs = (CyCellRun*)realloc(box->runs, sizeof(CyCellRun) * capacity);
+			if (!runs) {
+				CyLog("Failed to grow row runs\n");
+				return MU_FALSE;
+			}
+			box->runs = runs;
+			box->runCapacity = capacity;
+		}
+		if (numRects > box->rectCapacity) {
+			uint32_m capacity = (numRects > box->rectCapacity * 2) ? numRects : box->rectCapacity * 2;
+			if (!CySetEditorBoxCapacity(box, capacity)) {
+				return MU_FALSE;
+			}
+		}
+
+		// Cells and rows that stay in view
+		uint32_m keptColumns = (columns < box->textDim[0]) ? columns : box->textDim[0];
+		uint32_m keptRows = (numRows < box->numRows) ? numRows : box->numRows;
+
+		// Take the glyphs of the cells going out of view away
+		for (uint32_m r = 0; r < box->numRows; ++r) {
+			uint32_m i = ((box->ringTop + r) % box->numRows) * box->textDim[0];
+			for (uint32_m c = 0; c < box->textDim[0]; ++c, ++i) {
+				if (r >= keptRows || c >= keptColumns) {
+					CyRemoveGlyphs(box, i);
+				}
+			}
+			// A wide codepoint whose covered cell goes out of view is cut off
+			// now, which shows as a space
+			uint32_m last = i - box->textDim[0] + keptColumns - 1;
+			if (r < keptRows && keptColumns < box->textDim[0] && box->slots[last + 1].codepoint == EDITOR_BOX_COVERED_CELL) {
+				CyRemoveGlyphs(box, last);
+				box->slots[last].codepoint = 0x20;
+				box->slots[last].mark = 0;
+			}
+		}
+		// (Glyphs past the end that are still marked would never be
+		// marked again once reused)
+		for (uint32_m g = box->numGlyphs; g < box->lastChangedGlyph; ++g) {
+			box->changedGlyphs[g] = MU_FALSE;
+		}
+		if (box->lastChangedGlyph > box->numGlyphs) {
+			box->lastChangedGlyph = box->numGlyphs;
+		}
+
+		// Move the kept cells to where they go in rows of the new width,
+		// in order, so that none are written over before they're moved
+		CyUnrollEditorBoxRing(box);
+		if (columns > box->textDim[0]) {
+			for (uint32_m r = keptRows; r-- > 0;) {
+				for (uint32_m c = keptColumns; c-- > 0;) {
+					box->slots[(r * columns) + c] = box->slots[(r * box->textDim[0]) + c];
+				}
+			}
+		} else if (columns < box->textDim[0]) {
+			for (uint32_m r = 0; r < keptRows; ++r) {
+				for (uint32_m c = 0; c < keptColumns; ++c) {
+					box->slots[(r * columns) + c] = box->slots[(r * box->textDim[0]) + c];
+				}
+			}
+		}
+		// Cells newly in view are laid out from scratch
+		for (uint32_m r = 0; r < numRows; ++r) {
+			for (uint32_m c = (r < keptRows) ? keptColumns : 0; c < columns; ++c) {
+				CyClearSlot(&box->slots[(r * columns) + c]);
+			}
+		}
+		for (uint32_m r = keptRows; r < numRows; ++r) {
+			box->rowLines[r] = 0xFFFFFFFF;
+		}
+
+		// Glyphs stay where they are on screen, but their cells moved
+		box->textDim[0] = columns;
+		box->textDim[1] = rows;
+		box->numRows = numRows;
+		box->numRects = numRects;
+		for (uint32_m i = 0; i < numRects; ++i) {
+			if (box->slots[i].glyph != EDITOR_BOX_NO_GLYPH) {
+				box->glyphCells[box->slots[i].glyph] = i;
+			}
+			if (box->slots[i].markGlyph != EDITOR_BOX_NO_GLYPH) {
+				box->glyphCells[box->slots[i].markGlyph] = i | EDITOR_BOX_MARK_GLYPH;
+			}
+		}
+		if (box->lastChangedGlyph == 0) {
+			box->firstChangedGlyph = numRects * EDITOR_BOX_CELL_GLYPHS;
+		}
+
+		// New rows only need themselves laid out, but new columns need
+		// every row laid out again
+		if (box->keptRows > keptRows) {
+			box->keptRows = keptRows;
+		}
+		if (box->keptColumns > keptColumns) {
+			box->keptColumns = keptColumns;
+		}
+		// The gutter's rows were moved around along with the ring
+		if (box->gutter) {
+			CyForgetGutter(box);
+		}
+		// Rows of lines are worked out again as they're scrolled to, or
+		// when idle
+		if (rewrap) {
+			CyForgetWrapRows(box);
+			box->viewColumn = 0xFFFFFFFF;
+		}
+
+		// Give room back if far more is kept than needed
+		if (numRects * 4 < box->rectCapacity) {
+			CySetEditorBoxCapacity(box, numRects * 2);
+		}
+
+		CyUpdateBackgrounds(box);
+		return MU_TRUE;
+	}
+
+	// Gets the columns the text of an editor box fits in, which is what's
+	// left of its width after the gutter
+	uint32_m CyGetTextColumns(CyEditorBox* box) {
+		uint32_m columns = (uint32_m)floor(box->maxDim[0] / box->font->pAdvanceWidth);
+		return (columns > box->gutterColumns) ? columns - box->gutterColumns : 1;
+	}
+
+	// Widens or narrows the gutter to fit the digits of the last line
+	// number, giving the columns it takes or leaves to the text
+	void CyFitEditorBoxGutter(CyEditorBox* box, uint32_m lastLine) {
+		uint32_m digits = 1;
+		for (uint32_m number = lastLine + 1; number >= 10; number /= 10) {
+			++digits;
+		}
+		if (digits < EDITOR_BOX_GUTTER_MIN_DIGITS) {
+			digits = EDITOR_BOX_GUTTER_MIN_DIGITS;
+		}
+		if (digits + 1 == box->gutterColumns) {
+			return;
+		}
+
+		uint32_m gutterColumns = box->gutterColumns;
+		box->gutterColumns = digits + 1;
+		if (!CyResizeEditorBoxCells(box, CyGetTextColumns(box), box->textDim[1])) {
+			CyLog("Failed to fit text beside gutter\n");
+			box->gutterColumns = gutterColumns;
+			return;
+		}
+		// Every row has a different amount of digits now
+		CyForgetGutter(box);
 	}
 
 /* Outer */
@@ -200,6 +1247,35 @@
 			return MU_FALSE;
 		}
 
+		// Listen for changes; everything needs to be laid out at first
+		box->dirtyOffset = 0;
+		// View starts at the top left
+		box->topLine = box->leftColumn = 0;
+		box->topSegment = 0;
+		box->scrollPixels = 0.f;
+		box->viewLine = box->viewColumn = 0;
+		box->viewSegment = box->viewRow = 0;
+		// Lines are cut off rather than wrapped at first
+		box->wrap = MU_FALSE;
+		box->wrapRows = 0;
+		box->numWrapLines = box->wrapCapacity = 0;
+		box->wrapScan = 0;
+		// No gutter at first
+		box->gutter = MU_FALSE;
+		box->gutterColumns = 0;
+		box->gutterLines = 0;
+		box->gutterRects = 0;
+		box->gutterRectBuf = 0;
+		box->ringTop = 0;
+		box->origin[0] = box->origin[1] = 0.f;
+		box->maxDim[0] = max_width;
+		box->maxDim[1] = max_height;
+		box->cursorVisible = MU_TRUE;
+		box->cursorCell[0] = box->cursorCell[1] = 0;
+		box->drawCalls = 0;
+		memset(&box->refreshStats, 0, sizeof(box->refreshStats));
+		CyAddChunkedFileListener(&box->file, CyEditorBoxFileChanged, box);
+
 		// Initialize cursor
 		box->cursorWidth = 0.1f * box->font->pAdvanceWidth;
 		box->cursorRectBuf = 0;
@@ -212,12 +1288,24 @@
 		// Set dimensions of text box
 		box->textDim[0] = floor(max_width / font->pAdvanceWidth);
 		box->textDim[1] = floor(max_height / font->pHeight);
-		box->numRects = box->textDim[0] * box->textDim[1];
+		box->numRows = box->textDim[1] + 1;
+		box->numRects = box->textDim[0] * box->numRows;
+		box->rectCapacity = box->numRects;
+		box->rowCapacity = box->numRows;
 
 		// Allocate textRects, colRects, and slots
 		CyLog("Allocating visual and informational slot information...\n");
-
-		box->textRects = (mug2DTextureArrayRect*)malloc(sizeof(mug2DTextureArrayRect) * box->numRects);
+		box->textRects = 0;
+		box->colRects = 0;
+		box->slots = 0;
+		box->glyphCells = 0;
+		box->changedGlyphs = 0;
+		box->rowLines = 0;
+		box->wrapRows = 0;
+		box->runs = 0;
+		box->runCapacity = box->textDim[0] + 2;
+
+		box->textRects = (mug2DTextureArrayRect*)calloc(box->numRects * EDITOR_BOX_CELL_GLYPHS, sizeof(mug2DTextureArrayRect));
 		if (!box->textRects) {
 			CyLog("Failed to allocate texture rects\n");
 			CyDestroyChunkedFile(&box->file);
@@ -225,20 +1313,23 @@
 			return MU_FALSE;
 		}
 
-		box->colRects = (mugRect*)malloc(sizeof(mugRect) * box->numRects);
+		box->colRects = (mugRect*)calloc(box->numRects, sizeof(mugRect));
 		if (!box->colRects) {
 			CyLog("Failed to allocate color rects\n");
-			free(box->textRects);
+			CyFreeEditorBoxSlots(box);
 			CyDestroyChunkedFile(&box->file);
 			CyDestroyCursor(box);
 			return MU_FALSE;
 		}
 
 		box->slots = (CyEditorBoxSlot*)malloc(sizeof(CyEditorBoxSlot) * box->numRects);
-		if (!box->slots) {
+		box->glyphCells = (uint32_m*)malloc(sizeof(uint32_m) * box->numRects * EDITOR_BOX_CELL_GLYPHS);
+		box->changedGlyphs = (muBool*)calloc(box->numRects * EDITOR_BOX_CELL_GLYPHS, sizeof(muBool));
+		box->rowLines = (uint32_m*)malloc(sizeof(uint32_m) * box->numRows);
+		box->runs = (CyCellRun*)malloc(sizeof(CyCellRun) * box->runCapacity);
+		if (!box->slots || !box->glyphCells || !box->changedGlyphs || !box->rowLines || !box->runs) {
 			CyLog("Failed to allocate per-slot information\n");
-			free(box->colRects);
-			free(box->textRects);
+			CyFreeEditorBoxSlots(box);
 			CyDestroyChunkedFile(&box->file);
 			CyDestroyCursor(box);
 			return MU_FALSE;
@@ -247,38 +1338,50 @@
 		// Fill in default info for arrays
 		CyLog("Setting default slot information...\n");
 
-		uint16_m space_texture, space_layer;
-		CyFontGetTexture(font, 0x20, &space_texture, &space_layer);
+		// White text on black by default, with gray line numbers
+		for (uint8_m i = 0; i < EDITOR_BOX_PALETTE_SIZE; ++i) {
+			CySetPaletteColor(box, i, 1.f, 1.f, 1.f, 1.f);
+		}
+		CySetPaletteColor(box, EDITOR_BOX_BACKGROUND_COLOR, 0.f, 0.f, 0.f, 1.f);
+		CySetPaletteColor(box, EDITOR_BOX_GUTTER_COLOR, .5f, .5f, .5f, 1.f);
+		box->paletteChanged = MU_FALSE;
 
-		// Loop through each column and row
-		for (uint32_m c = 0; c < box->textDim[0]; ++c) {
-			for (uint32_m r = 0; r < box->textDim[1]; ++r) {
-				CySetDefaultCodepoint(box, c, r, space_texture, space_layer);
-			}
+		// Nothing is drawn until the first refresh lays each cell out
+		// (0xFFFFFFFF isn't a codepoint, so no cell is skipped)
+		for (uint32_m i = 0; i < box->numRects; ++i) {
+			CyClearSlot(&box->slots[i]);
 		}
+		for (uint32_m r = 0; r < box->numRows; ++r) {
+			box->rowLines[r] = 0xFFFFFFFF;
+		}
+		box->keptRows = 0;
+		box->keptColumns = 0;
+		box->anchorLine = 0;
+		box->numGlyphs = 0;
+		box->numBackgrounds = 0;
+		box->firstChangedGlyph = box->numRects * EDITOR_BOX_CELL_GLYPHS;
+		box->lastChangedGlyph = 0;
 
 		// Create and fill buffers
 		CyLog("Creating and filling graphical buffers...\n");
 
-		box->textRectBuf = mu_gobjects_create(gfx, MUG_OBJECT_TEXTURE_2D_ARRAY, box->numRects, box->textRects);
+		box->textRectBuf = CyGfxCreateObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, box->numRects * EDITOR_BOX_CELL_GLYPHS, box->textRects);
 		if (!box->textRectBuf) {
 			CyLog("Failed to create texture object buffer\n");
-			free(box->slots);
-			free(box->colRects);
-			free(box->textRects);
+			CyFreeEditorBoxSlots(box);
 			CyDestroyChunkedFile(&box->file);
 			CyDestroyCursor(box);
+			return MU_FALSE;
 		}
 
-		box->colRectBuf = mu_gobjects_create(gfx, MUG_OBJECT_RECT, box->numRects, box->colRects);
+		box->colRectBuf = CyGfxCreateObjects(MUG_OBJECT_RECT, box->numRects, box->colRects);
 		if (!box->colRectBuf) {
 			CyLog("Failed to create color object buffer\n");
-			mu_gobjects_destroy(gfx, box->textRectBuf);
-			free(box->slots);
-			free(box->colRects);
-			free(box->textRects);
+			CyGfxDestroyObjects(box->textRectBuf);
+			CyFreeEditorBoxSlots(box);
 			CyDestroyChunkedFile(&box->file);
 			CyDestroyCursor(box);
+			return MU_FALSE;
 		}
 
 		CyLog("\n");
@@ -289,100 +1392,471 @@
 	// Logs messages
 	void CyDestroyEditorBox(CyEditorBox* box) {
 		CyLog("Destroying graphical buffers...\n");
-		mu_gobjects_destroy(gfx, box->colRectBuf);
-		mu_gobjects_destroy(gfx, box->textRectBuf);
+		CyGfxDestroyObjects(box->colRectBuf);
+		CyGfxDestroyObjects(box->textRectBuf);
 		CyDestroyCursor(box);
 
 		CyLog("Deallocating visual and informational slot information...\n");
-		free(box->slots);
-		free(box->colRects);
-		free(box->textRects);
+		CyFreeEditorBoxSlots(box);
+		CyFreeEditorBoxGutter(box);
 
 		CyLog("Destroying chunked file...\n");
 		CyDestroyChunkedFile(&box->file);
 	}
 
+	// Resizes an editor box to fit a new width and height
+	muBool CyResizeEditorBox(CyEditorBox* box, float max_width, float max_height) {
+		float maxDim[2] = { box->maxDim[0], box->maxDim[1] };
+		box->maxDim[0] = max_width;
+		box->maxDim[1] = max_height;
+		// (Always at least one row, like when the window is minimized)
+		uint32_m rows = (uint32_m)floor(max_height / box->font->pHeight);
+		rows = (rows == 0) ? 1 : rows;
+		if (!CyResizeEditorBoxCells(box, CyGetTextColumns(box), rows)) {
+			box->maxDim[0] = maxDim[0];
+			box->maxDim[1] = maxDim[1];
+			return MU_FALSE;
+		}
+		return MU_TRUE;
+	}
+
 	// Renders text box
 	void CyRenderEditorBox(CyEditorBox* box) {
+		// Everything is laid out relative to the anchor row
+		float rows = (float)((int64_m)box->viewRow - (int64_m)box->anchorLine);
+		float shift[3] = { CyGetTextLeft(box), 0.f, 0.f };
+		box->drawCalls = 0;
+
 		// Render background rects
-		mu_gobjects_render(gfx, box->colRectBuf);
+		if (box->numBackgrounds != 0) {
+			shift[1] = box->origin[1] - (rows * box->font->pHeight) - roundf(box->scrollPixels);
+			CyGfxShiftObjects(MUG_OBJECT_RECT, shift);
+			CyGfxSubrenderObjects(box->colRectBuf, 0, box->numBackgrounds);
+			++box->drawCalls;
+		}
 		// Render cursor
 		CyRenderCursor(box);
 
-		// Render spans of slots with the same texture
-		uint32_m prev_i = 0;
-		for (uint32_m i = 1; i < box->numRects; ++i) {
-			if (box->slots[i].texture != box->slots[i-1].texture) {
-				mu_gobjects_texture(gfx, box->textRectBuf, box->font->textures[box->slots[i-1].texture]);
-				mu_gobjects_subrender(gfx, box->textRectBuf, prev_i, i-prev_i);
-				prev_i = i;
-			}
-			if (i+1 == box->numRects) {
-				mu_gobjects_texture(gfx, box->textRectBuf, box->font->textures[box->slots[i-1].texture]);
-				mu_gobjects_subrender(gfx, box->textRectBuf, prev_i, box->numRects - prev_i);
-			}
+		// Render text; all glyphs are in the font's atlas, so they draw at once
+		if (box->numGlyphs != 0) {
+			shift[1] = box->origin[1] - (rows * roundf(box->font->pHeight)) - roundf(box->scrollPixels);
+			CyGfxShiftObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, shift);
+			CyGfxTextureObjects(box->textRectBuf, box->font->atlas);
+			CyGfxSubrenderObjects(box->textRectBuf, 0, box->numGlyphs);
+			++box->drawCalls;
+		}
+
+		// Render the gutter's digits left of the text, lined up with its rows
+		if (box->gutter && box->gutterColumns != 0) {
+			shift[0] = box->origin[0];
+			shift[1] = box->origin[1] - (rows * roundf(box->font->pHeight)) - roundf(box->scrollPixels);
+			CyGfxShiftObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, shift);
+			CyGfxTextureObjects(box->gutterRectBuf, box->font->atlas);
+			CyGfxSubrenderObjects(box->gutterRectBuf, 0, box->numRows * (box->gutterColumns - 1));
+			++box->drawCalls;
 		}
+
+		// Reset shifts
+		shift[0] = shift[1] = 0.f;
+		CyGfxShiftObjects(MUG_OBJECT_RECT, shift);
+		CyGfxShiftObjects(MUG_OBJECT_TEXTURE_2D_ARRAY, shift);
 	}
 
-	// Refreshes the editor box to represent the chunked file
+	// Refreshes the editor box to represent the visible part of the chunked file
 	void CyRefreshEditorBox(CyEditorBox* box) {
-		// Get first slot
-		CyChunkSlot chunkSlot;
-		muBool moreCodepoints = CyGetFirstSlotInChunkedFile(&box->file, &chunkSlot);
-		// If this is where the cursor is, update accordingly
-		if (CyIsSlotAtCursor(&box->file, &chunkSlot)) {
-			CySetDefaultCursor(box, 0, 0);
+		double start = CyGfxTime();
+		memset(&box->refreshStats, 0, sizeof(box->refreshStats));
+
+		// Keep the top line within the file
+		uint32_m lastLine = CyGetLastLine(box);
+		if (box->topLine > lastLine) {
+			box->topLine = lastLine;
+		}
+		// Fit the gutter to the last line number, before anything's laid
+		// out at the width left for the text
+		if (box->gutter) {
+			CyFitEditorBoxGutter(box, lastLine);
+			if (box->paletteChanged) {
+				CyForgetGutter(box);
+			}
+		}
+		if (!box->wrap) {
+			box->topSegment = 0;
+		} else if (box->topSegment >= CyGetLineRows(box, box->topLine)) {
+			box->topSegment = CyGetLineRows(box, box->topLine) - 1;
+		}
+		// (Lines are never cut off when wrapping)
+		uint32_m width = box->textDim[0];
+		if (box->wrap) {
+			box->leftColumn = 0;
 		}
 
-		// Loop through each slot
-		for (uint32_m i = 0; i < box->numRects; ++i) {
-			// Set to just space if no more codepoints exist in the chunked file
-			if (!moreCodepoints) {
-				CySetCodepoint(box, i, 0x20);
-				continue;
+		// Whether or not cells are being compared against the file;
+		// cells for codepoints before the first changed one stay the same,
+		// as long as they're still in view
+		muBool rewrite = (box->dirtyOffset <= CyGetLineStartInChunkedFile(&box->file, box->topLine) || box->leftColumn != box->viewColumn);
+
+		// Row at the top of the view; the top line if not wrapping, and
+		// otherwise counted from the last refresh's by the rows scrolled, if
+		// it's close enough for any rows to be kept
+		uint32_m topRow = box->topLine;
+		if (box->wrap) {
+			topRow = box->viewRow;
+			muBool after = box->topLine > box->viewLine || (box->topLine == box->viewLine && box->topSegment > box->viewSegment);
+			muBool before = box->topLine < box->viewLine || (box->topLine == box->viewLine && box->topSegment < box->viewSegment);
+			if (after) {
+				uint32_m rows = CyCountEditorBoxRows(box, box->viewLine, box->viewSegment, box->topLine, box->topSegment, box->numRows);
+				if (rows < box->numRows) {
+					topRow += rows;
+				} else {
+					rewrite = MU_TRUE;
+				}
+			} else if (before) {
+				uint32_m rows = CyCountEditorBoxRows(box, box->topLine, box->topSegment, box->viewLine, box->viewSegment, box->numRows);
+				if (rows < box->numRows) {
+					topRow -= rows;
+				} else {
+					rewrite = MU_TRUE;
+				}
 			}
+		}
 
-			// i-value relative to row
-			uint32_m rowI = i - ((floor(((float)i) / ((float)box->textDim[0])) * box->textDim[0]));
+		// Move the anchor row to the top row once it's far away; every
+		// row is then laid out for a new line
+		uint32_m anchorDistance = (topRow > box->anchorLine) ? topRow - box->anchorLine : box->anchorLine - topRow;
+		if (anchorDistance >= EDITOR_BOX_ANCHOR_LINES) {
+			box->anchorLine = topRow;
+			for (uint32_m r = 0; r < box->numRows; ++r) {
+				box->rowLines[r] = 0xFFFFFFFF;
+			}
+		}
 
-			// Newline handling
-			if (chunkSlot.codepoint == 0x0D) {
-				// Set all other columns to 0
-				uint32_m nextI = ceil(((float)(i+1)) / ((float)box->textDim[0])) * box->textDim[0];
-				while (i < nextI) {
-					CySetCodepoint(box, i++, 0x20);
-				}
-				--i;
+		// Rows [keepFirst, keepLast) were in view before
+		uint32_m keepFirst = 0;
+		uint32_m keepLast = box->keptRows;
+		if (!rewrite && topRow != box->viewRow) {
+			// Scrolled down by a few rows: the rows at the top went out
+			// of view and are reused for the ones coming in at the bottom
+			if (topRow > box->viewRow && topRow - box->viewRow < box->numRows) {
+				uint32_m lines = topRow - box->viewRow;
+				box->ringTop = (box->ringTop + lines) % box->numRows;
+				keepLast = (box->keptRows > lines) ? box->keptRows - lines : 0;
+			}
+			// Scrolled up by a few rows: the other way around
+			else if (topRow < box->viewRow && box->viewRow - topRow < box->numRows) {
+				uint32_m lines = box->viewRow - topRow;
+				box->ringTop = (box->ringTop + box->numRows - lines) % box->numRows;
+				keepFirst = lines;
+				keepLast = (box->keptRows + lines < box->numRows) ? box->keptRows + lines : box->numRows;
+			}
+			else {
+				rewrite = MU_TRUE;
+			}
+		}
+		box->viewLine = box->topLine;
+		box->viewColumn = box->leftColumn;
+		box->viewSegment = box->topSegment;
+		box->viewRow = topRow;
+		// Whether or not the change has been reached
+		muBool dirty = rewrite;
+		// Whether or not any row was laid out for a new line
+		muBool moved = MU_FALSE;
+
+		// Row and column of the cursor; rows past the end if not in view
+		uint32_m cursorRow = box->numRows;
+		uint32_m cursorColumn = 0;
+
+		// The top row is seeked to straight away, without going through the
+		// columns before it, which matters for very long lines
+		CyRowLayout layout;
+		layout.lastLine = lastLine;
+		uint32_m topColumn = box->leftColumn;
+		if (box->wrap) {
+			uint32_m segment = box->topSegment;
+			topColumn = CyFindWrappedRow(box, box->topLine, 0xFFFFFFFF, &segment);
+		}
+		CySeekRowLayout(box, &layout, box->topLine, topColumn);
+
+		// Lay out each row, then update the cells of the runs that may
+		// have changed
+		for (uint32_m r = 0; r < box->numRows; ++r) {
+			// Rows that weren't in view are always compared
+			rewrite = dirty || r < keepFirst || r >= keepLast;
+			// Rows laid out for another row before have their glyphs moved
+			uint32_m ringRow = (box->ringTop + r) % box->numRows;
+			muBool rowMoved = box->rowLines[ringRow] != topRow + r;
+			if (rowMoved) {
+				CyMoveRow(box, ringRow, topRow + r);
+				moved = MU_TRUE;
+			}
+
+			CyLayOutRow(box, &layout);
+			if (cursorRow == box->numRows && layout.cursorColumn != 0xFFFFFFFF) {
+				cursorRow = r;
+				cursorColumn = layout.cursorColumn;
 			}
 
-			// Tab handling
-			else if (chunkSlot.codepoint == 0x09) {
-				if (rowI % 5 == 0) {
-					CySetCodepoint(box, i++, 0x20);
-					rowI++;
+			// Only the rows whose line number changed are drawn again in the
+			// gutter; rows a line wraps onto have none
+			if (box->gutter) {
+				uint32_m number = 0;
+				if (layout.line <= lastLine && (!box->wrap || layout.rowStart == 0)) {
+					number = layout.line + 1;
 				}
-				while (rowI % 5 != 0) {
-					CySetCodepoint(box, i++, 0x20);
-					rowI++;
+				if (rowMoved || box->gutterLines[ringRow] != number) {
+					CyDrawGutterRow(box, ringRow, number);
 				}
-				i--;
 			}
 
-			// Normal handling
-			else {
-				// Set corresponding chunked file codepoint
-				CySetCodepoint(box, i, chunkSlot.codepoint);
+			// Only runs from the change onwards need comparing, along with
+			// the ones reaching columns newly in view, unless the whole row
+			// does
+			uint32_m firstRun = layout.numRuns;
+			if (rewrite) {
+				firstRun = 0;
+			} else if (layout.changedRun != 0xFFFFFFFF) {
+				firstRun = layout.changedRun;
+			}
+			while (box->keptColumns < width && firstRun > 0 && box->runs[firstRun - 1].column + box->runs[firstRun - 1].columns > box->keptColumns) {
+				--firstRun;
+			}
+			if (layout.changedRun != 0xFFFFFFFF) {
+				dirty = MU_TRUE;
+			}
+			float top = CyGetRowTop(box, ringRow);
+			for (uint32_m u = firstRun; u < layout.numRuns; ++u) {
+				CyUpdateRun(box, ringRow, top, &box->runs[u]);
 			}
 
-			// Get next chunked file codepoint
-			moreCodepoints = CyGetNextSlotInChunkedFile(&chunkSlot);
-			// If this is where the cursor is, update accordingly
-			if (CyIsSlotAtCursor(&box->file, &chunkSlot)) {
-				CySetDefaultCursor(box, (i+1) % box->textDim[0], (i+1) / box->textDim[0]);
+			if (r + 1 < box->numRows) {
+				CyNextLayoutRow(box, &layout);
 			}
 		}
+		box->keptRows = box->numRows;
+		box->keptColumns = box->textDim[0];
+
+		// Place the cursor if it's in view
+		box->cursorVisible = (cursorRow < box->numRows && cursorColumn < box->textDim[0]);
+		if (box->cursorVisible) {
+			box->cursorCell[0] = cursorColumn;
+			box->cursorCell[1] = cursorRow;
+			CySetDefaultCursor(box, box->cursorCell[0], box->cursorCell[1]);
+		}
+
+		double uploadStart = CyGfxTime();
+
+		// Recolor every glyph if the palette changed
+		if (box->paletteChanged) {
+			for (uint32_m g = 0; g < box->numGlyphs; ++g) {
+				CyColorGlyph(box, g);
+			}
+		}
+		// Backgrounds only need gathering again if rows moved or got recolored
+		if (moved || box->paletteChanged) {
+			CyUpdateBackgrounds(box);
+		}
+		box->paletteChanged = MU_FALSE;
 
-		// Refill texture buffer
-		mu_gobjects_fill(gfx, box->textRectBuf, box->textRects);
+		// Upload whatever glyphs changed
+		CyUploadChangedGlyphs(box);
+		if (box->gutter) {
+			CyUploadGutter(box);
+		}
+		box->dirtyOffset = 0xFFFFFFFF;
+		double end = CyGfxTime();
+		box->refreshStats.seconds = end - start;
+		box->refreshStats.uploadSeconds = end - uploadStart;
+	}
+
+	// Scrolls the editor box so that the given line is at the top and the
+	// given column is at the left
+	void CySetEditorBoxView(CyEditorBox* box, uint32_m topLine, uint32_m leftColumn) {
+		box->topLine = topLine;
+		box->leftColumn = box->wrap ? 0 : leftColumn;
+		box->topSegment = 0;
+		box->scrollPixels = 0.f;
+	}
+
+	// Scrolls the editor box by an amount of pixels, downward if positive
+	muBool CyScrollEditorBox(CyEditorBox* box, float pixels) {
+		uint32_m prevLine = box->topLine;
+		uint32_m prevSegment = box->topSegment;
+		float height = box->font->pHeight;
+
+		// Whole lines scrolled, and what's left of a line
+		float scroll = box->scrollPixels + pixels;
+		float lines = floorf(scroll / height);
+		box->scrollPixels = scroll - (lines * height);
+
+		// Rows are moved through one line at a time when wrapping,
+		// stopping at the first and last row
+		if (box->wrap) {
+			muBool down = lines > 0.f;
+			uint32_m rows = (uint32_m)(down ? lines : -lines);
+			if (CyMoveEditorBoxRows(box, &box->topLine, &box->topSegment, down, rows) < rows || (box->topLine == CyGetLastLine(box) && box->topSegment == CyGetLineRows(box, box->topLine) - 1)) {
+				box->scrollPixels = 0.f;
+			}
+			return box->topLine != prevLine || box->topSegment != prevSegment;
+		}
+
+		// Stop at the first line
+		if (lines < 0.f && -lines > (float)box->topLine) {
+			box->topLine = 0;
+			box->scrollPixels = 0.f;
+		}
+		else {
+			box->topLine = (uint32_m)((int64_m)box->topLine + (int64_m)lines);
+		}
+
+		// Stop at the last line
+		CyTextStats stats;
+		CyGetChunkedFileStats(&box->file, &stats);
+		if (box->topLine >= stats.newlines) {
+			box->topLine = stats.newlines;
+			box->scrollPixels = 0.f;
+		}
+
+		return box->topLine != prevLine;
+	}
+
+	// Turns wrapping long lines onto the rows below on or off
+	muBool CySetEditorBoxWrap(CyEditorBox* box, muBool wrap) {
+		if (wrap == box->wrap) {
+			return MU_TRUE;
+		}
+
+		// Rows of each line are worked out as they're needed
+		if (wrap) {
+			uint32_m lines = CyGetLastLine(box) + 1;
+			if (!CyReserveWrapRows(box, lines)) {
+				CyLog("Failed to allocate wrapped rows\n");
+				return MU_FALSE;
+			}
+			box->numWrapLines = lines;
+			CyForgetWrapRows(box);
+		} else {
+			free(box->wrapRows);
+			box->wrapRows = 0;
+			box->numWrapLines = box->wrapCapacity = 0;
+			box->wrapScan = 0;
+		}
+		box->wrap = wrap;
+
+		// Rows are counted differently now, so every row is laid out again
+		box->leftColumn = 0;
+		box->topSegment = box->viewSegment = 0;
+		box->viewColumn = 0xFFFFFFFF;
+		box->viewRow = box->anchorLine = wrap ? EDITOR_BOX_WRAP_ROW_BASE : box->topLine;
+		for (uint32_m r = 0; r < box->numRows; ++r) {
+			box->rowLines[r] = 0xFFFFFFFF;
+		}
+		return MU_TRUE;
+	}
+
+	// Sets the columns between tab stops of the box's file
+	void CySetEditorBoxTabWidth(CyEditorBox* box, uint32_m width) {
+		CySetChunkedFileTabWidth(&box->file, width);
+		// Lines with tabs take up other columns and rows now
+		if (box->wrap) {
+			CyForgetWrapRows(box);
+		}
+		box->viewColumn = 0xFFFFFFFF;
+	}
+
+	// Turns the line-number gutter on or off
+	muBool CySetEditorBoxGutter(CyEditorBox* box, muBool gutter) {
+		if (gutter == box->gutter) {
+			return MU_TRUE;
+		}
+
+		// The gutter is fit to the last line number on the next refresh
+		if (gutter) {
+			if (!CySetGutterCapacity(box, box->rowCapacity)) {
+				CyLog("Failed to allocate gutter\n");
+				return MU_FALSE;
+			}
+			box->gutter = MU_TRUE;
+			return MU_TRUE;
+		}
+
+		// The text gets its columns back straight away
+		CyFreeEditorBoxGutter(box);
+		box->gutter = MU_FALSE;
+		box->gutterColumns = 0;
+		if (!CyResizeEditorBoxCells(box, CyGetTextColumns(box), box->textDim[1])) {
+			CyLog("Failed to widen text over gutter\n");
+		}
+		return MU_TRUE;
+	}
+
+	// Works out the rows of lines that aren't known yet, a few at a time
+	muBool CyRewrapEditorBox(CyEditorBox* box, uint32_m maxLines) {
+		if (!box->wrap || !box->wrapRows) {
+			return MU_TRUE;
+		}
+		for (; box->wrapScan < box->numWrapLines && maxLines > 0; ++box->wrapScan) {
+			if (box->wrapRows[box->wrapScan] == 0) {
+				CyGetLineRows(box, box->wrapScan);
+				--maxLines;
+			}
+		}
+		return box->wrapScan == box->numWrapLines;
+	}
+
+	// Sets a color of the editor box's palette, in RGBA
+	void CySetEditorBoxColor(CyEditorBox* box, uint8_m index, float r, float g, float b, float a) {
+		if (index >= EDITOR_BOX_PALETTE_SIZE) {
+			return;
+		}
+		CySetPaletteColor(box, index, r, g, b, a);
+		box->paletteChanged = MU_TRUE;
+	}
+
+	// Gets the slot shown at a column and row of the view
+	CyEditorBoxSlot* CyGetEditorBoxCell(CyEditorBox* box, uint32_m column, uint32_m row) {
+		return &box->slots[(((box->ringTop + row) % box->numRows) * box->textDim[0]) + column];
+	}
+
+	// Scrolls the editor box as little as possible to bring the cursor into view
+	void CyScrollEditorBoxToCursor(CyEditorBox* box) {
+		uint32_m line = CyGetLineOfOffsetInChunkedFile(&box->file, box->file.cursorOffset);
+		uint32_m column = CyGetColumnOfOffsetInChunkedFile(&box->file, box->file.cursorOffset);
+
+		// Only ever vertically when wrapping, by the row of the line that
+		// the cursor is on
+		if (box->wrap) {
+			uint32_m segment = 0xFFFFFFFF;
+			CyFindWrappedRow(box, line, box->file.cursorOffset, &segment);
+			if (line < box->topLine || (line == box->topLine && (segment < box->topSegment || (segment == box->topSegment && box->scrollPixels != 0.f)))) {
+				box->topLine = line;
+				box->topSegment = segment;
+				box->scrollPixels = 0.f;
+			}
+			else if (CyCountEditorBoxRows(box, box->topLine, box->topSegment, line, segment, box->textDim[1]) >= box->textDim[1]) {
+				box->topLine = line;
+				box->topSegment = segment;
+				CyMoveEditorBoxRows(box, &box->topLine, &box->topSegment, MU_FALSE, box->textDim[1] - 1);
+				box->scrollPixels = 0.f;
+			}
+			return;
+		}
+
+		// Vertically, lining rows back up with the top of the box
+		if (line < box->topLine || (line == box->topLine && box->scrollPixels != 0.f)) {
+			box->topLine = line;
+			box->scrollPixels = 0.f;
+		}
+		else if (line >= box->topLine + box->textDim[1]) {
+			box->topLine = line + 1 - box->textDim[1];
+			box->scrollPixels = 0.f;
+		}
+
+		// Horizontally
+		if (column < box->leftColumn) {
+			box->leftColumn = column;
+		}
+		else if (column >= box->leftColumn + box->textDim[0]) {
+			box->leftColumn = column + 1 - box->textDim[0];
+		}
 	}
 
@@ -4,46 +4,102 @@
 // Include files
 #include "core/gfx.h"
 #include "core/string.h"
+#include "core/latency.h"
+#include "core/profiler.h"
 #include "editor/visualBuffer.h"
+#include "editor/input.h"
 
 #include <inttypes.h>
+#include <math.h>
+
+// Scroll velocity added per unit of scroll wheel movement, in pixels per second
+#define SCROLL_SPEED 10.f
+// How quickly scrolling slows down; velocity is multiplied by e^(-decay) each second
+#define SCROLL_DECAY 6.f
+// File that input latencies are written to on exit
+#define LATENCY_CSV "latency.csv"
+// Most lines whose wrapped rows are worked out per idle frame
+#define REWRAP_LINES 4096
 
 CyEditorBox box;
+// Input received since the last frame
+CyInputQueue input;
+// How long input takes to show up
+CyLatency latency;
 muBool shouldUpdate = MU_FALSE;
 muBool shouldInsert = MU_FALSE;
+// Whether or not the box needs to be drawn again; the last frame stays up otherwise
+muBool shouldRender = MU_TRUE;
+// Current scroll velocity, in pixels per second; downward if positive
+float scrollVelocity = 0.f;
+// Window dimensions to resize the box to; dragging the window's edge
+// sends many of these a frame, so the box is only resized once a frame
+muBool shouldResize = MU_FALSE;
+uint32_m resizeWidth = 0;
+uint32_m resizeHeight = 0;
+
+#ifdef CY_PROFILE
+// Size of the profiler HUD, in columns and rows
+#define HUD_COLUMNS 40
+#define HUD_ROWS 3
+
+// Where each frame's time goes, and the box showing it in the top right
+CyProfiler profiler;
+CyEditorBox hud;
+
+// Shows the profiler's rolling stats in the HUD
+void updateHud(void) {
+	CyProfileFrame mean, max;
+	CyGetProfileStats(&profiler, &mean, &max);
+
+	char text[HUD_COLUMNS * HUD_ROWS];
+	snprintf(text, sizeof(text), "frame %6.2f ms (busy %5.2f, max %6.2f)\rrefresh %5.2f ms, render %5.2f ms\r%" PRIu32 " draw calls, %" PRIu32 " bytes uploaded",
+		mean.seconds * 1000.0, (mean.seconds - mean.phases[PROFILE_WAIT]) * 1000.0, max.seconds * 1000.0,
+		mean.phases[PROFILE_REFRESH] * 1000.0, mean.phases[PROFILE_RENDER] * 1000.0,
+		mean.drawCalls, mean.uploadBytes
+	);
+
+	// Replace the HUD's text
+	CyTextStats stats;
+	CyGetChunkedFileStats(&hud.file, &stats);
+	CyBeginEdit(&hud.file);
+	CyMoveToEndInChunkedFile(&hud.file);
+	for (uint32_m i = 0; i < stats.codepoints; ++i) {
+		CyBackspaceCodepointInChunkedFile(&hud.file);
+	}
+	for (char* c = text; *c != 0; ++c) {
+		CyWriteCodepointInChunkedFile(&hud.file, (uint8_m)*c);
+	}
+	CyCommitEdit(&hud.file);
+
+	CyRefreshEditorBox(&hud);
+	// (Nothing's typed into the HUD, so it has no cursor)
+	hud.cursorVisible = MU_FALSE;
+	CY_PROFILE_COUNT(&profiler, 0, hud.refreshStats.uploadBytes);
+}
+#endif
 
 void textInputCallback(muWindow win, uint8_m* data) {
 	uint32_m codepoint = 0;
 	CyUTF8CodepointDecode(&codepoint, data, 4);
-	CyLog("Received codepoint '%" PRIu32 "'\n", codepoint);
 
 	switch (codepoint) {
 		default: {
+			// Ignore codepoints that are invalid as characters
 			if (codepoint < 32 || codepoint == 127) {
-				CyLog("Codepoint is invalid as a character; ignoring.\n");
 				return;
 			}
 		} break;
 
 		case 8: {
-			CyLog("Backspace noted; writing a backspace...\n");
-			CyBackspaceCodepointInChunkedFile(&box.file);
-			shouldUpdate = MU_TRUE;
+			CyPushInput(&input, INPUT_BACKSPACE, 1);
 			return;
 		} break;
 
 		case 13: case 9: break;
 	}
 
-	if (shouldInsert) {
-		CyLog("Inserting codepoint to file...\n");
-		CyInsertCodepointInChunkedFile(&box.file, codepoint);
-	} else {
-		CyLog("Writing codepoint to file...\n");
-		CyWriteCodepointInChunkedFile(&box.file, codepoint);
-	}
-
-	shouldUpdate = MU_TRUE;
+	CyPushInput(&input, shouldInsert ? INPUT_INSERT : INPUT_WRITE, codepoint);
 }
 
 void keyInputCallback(muWindow win, muKeyboardKey key, muBool status) {
@@ -51,15 +107,33 @@ void keyInputCallback(muWindow win, muKeyboardKey key, muBool status) {
 		return;
 	}
 	
+	// Whether or not control is being held down
+	muBool control = keyboard[MU_KEYBOARD_LEFT_CONTROL] || keyboard[MU_KEYBOARD_RIGHT_CONTROL];
+
+	// Movements are queued up like text, and applied along with it
 	if (key == MU_KEYBOARD_LEFT) {
-		CyLog("Leftward movement detected; moving cursor.\n");
-		CyMoveLeftInChunkedFile(&box.file, 1);
-		shouldUpdate = MU_TRUE;
+		CyPushInput(&input, control ? INPUT_WORD_LEFT : INPUT_LEFT, 1);
 	}
 	else if (key == MU_KEYBOARD_RIGHT) {
-		CyLog("Rightward movement detected; moving cursor.\n");
-		CyMoveRightInChunkedFile(&box.file, 1);
-		shouldUpdate = MU_TRUE;
+		CyPushInput(&input, control ? INPUT_WORD_RIGHT : INPUT_RIGHT, 1);
+	}
+	else if (key == MU_KEYBOARD_UP) {
+		CyPushInput(&input, INPUT_UP, 1);
+	}
+	else if (key == MU_KEYBOARD_DOWN) {
+		CyPushInput(&input, INPUT_DOWN, 1);
+	}
+	else if (key == MU_KEYBOARD_PRIOR) {
+		CyPushInput(&input, INPUT_UP, box.textDim[1]);
+	}
+	else if (key == MU_KEYBOARD_NEXT) {
+		CyPushInput(&input, INPUT_DOWN, box.textDim[1]);
+	}
+	else if (key == MU_KEYBOARD_HOME) {
+		CyPushInput(&input, control ? INPUT_START : INPUT_LINE_START, 0);
+	}
+	else if (key == MU_KEYBOARD_END) {
+		CyPushInput(&input, control ? INPUT_END : INPUT_LINE_END, 0);
 	}
 	else if (key == MU_KEYBOARD_INSERT) {
 		shouldInsert = !shouldInsert;
@@ -69,6 +143,48 @@ void keyInputCallback(muWindow win, muKeyboardKey key, muBool status) {
 			CyLog("Insert mode OFF\n");
 		}
 	}
+	else if (key == MU_KEYBOARD_F2) {
+		if (!CySetEditorBoxWrap(&box, !box.wrap)) {
+			CyLog("Failed to turn wrapping on\n");
+		} else if (box.wrap) {
+			CyLog("Wrapping ON\n");
+		} else {
+			CyLog("Wrapping OFF\n");
+		}
+		shouldUpdate = MU_TRUE;
+	}
+	else if (key == MU_KEYBOARD_F3) {
+		// Cycles through tab widths of 1 to 8
+		CySetEditorBoxTabWidth(&box, (box.file.tabWidth % 8) + 1);
+		CyLog("Tab width %" PRIu32 "\n", box.file.tabWidth);
+		shouldUpdate = MU_TRUE;
+	}
+	else if (key == MU_KEYBOARD_F4) {
+		if (!CySetEditorBoxGutter(&box, !box.gutter)) {
+			CyLog("Failed to turn line numbers on\n");
+		} else if (box.gutter) {
+			CyLog("Line numbers ON\n");
+		} else {
+			CyLog("Line numbers OFF\n");
+		}
+		shouldUpdate = MU_TRUE;
+	}
+}
+
+void scrollCallback(muWindow win, int32_m add) {
+	// Scrolling the wheel up gives a positive amount
+	scrollVelocity -= add * SCROLL_SPEED;
+}
+
+void dimensionsCallback(muWindow win, uint32_m width, uint32_m height) {
+	// The last frame was drawn for other dimensions
+	shouldResize = MU_TRUE;
+	resizeWidth = width;
+	resizeHeight = height;
+#ifdef CY_PROFILE
+	// Keep the HUD in the top right
+	hud.origin[0] = floorf(width - (HUD_COLUMNS * textFont.pAdvanceWidth));
+#endif
 }
 
 int main(void) {
@@ -99,27 +215,163 @@ int main(void) {
 		return -1;
 	}
 
+#ifdef CY_PROFILE
+	// Create profiler HUD in the top right
+	CyLog("Creating profiler HUD\n");
+	CyInitProfiler(&profiler);
+	if (!CyInitEditorBox(&hud, &textFont, (HUD_COLUMNS + .5f) * textFont.pAdvanceWidth, (HUD_ROWS + .5f) * textFont.pHeight)) {
+		CyLog("Failed to create profiler HUD; exiting\n");
+		return -1;
+	}
+	hud.origin[0] = floorf(wininfo.width - (HUD_COLUMNS * textFont.pAdvanceWidth));
+	CySetEditorBoxColor(&hud, EDITOR_BOX_BACKGROUND_COLOR, .15f, .15f, .2f, 1.f);
+	CySetEditorBoxColor(&hud, EDITOR_BOX_TEXT_COLOR, 1.f, .85f, .3f, 1.f);
+#endif
+
+	CyInitInputQueue(&input, &box.file);
+	CyResetLatency(&latency);
 	mu_window_get_text_input(win, 400, 300, textInputCallback);
 
 	void* funPtr = (void*)keyInputCallback;
 	mu_window_set(win, MU_WINDOW_KEYBOARD_CALLBACK, &funPtr);
+	funPtr = (void*)scrollCallback;
+	mu_window_set(win, MU_WINDOW_SCROLL_CALLBACK, &funPtr);
+	funPtr = (void*)dimensionsCallback;
+	mu_window_set(win, MU_WINDOW_DIMENSIONS_CALLBACK, &funPtr);
 
-	// Main loop:
+	// Time of the last frame, and cursor and file version as of the last refresh
+	double lastTime = CyGfxTime();
+	uint32_m lastCursor = box.file.cursorOffset;
+	uint32_m lastVersion = box.file.version;
+
+	// Main loop; only draws when something changed, and otherwise just
+	// waits for events
 	while (CyGfxExists()) {
-		CyGfxClear();
+		CY_PROFILE_FRAME_BEGIN(&profiler);
+		CY_PROFILE_BEGIN(&profiler, PROFILE_INPUT);
 
+		// Apply the input received since the last frame as one edit
+		uint32_m events = CyApplyInput(&input);
+		if (events != 0) {
+			shouldUpdate = MU_TRUE;
+			// Follow it through to the screen
+			CyBeginLatency(&latency, input.receivedTime);
+			CyMarkLatency(&latency, LATENCY_APPLY, CyGfxTime());
+		}
+
+		// Fit the box to the window; only the cells newly in view are laid out
+		if (shouldResize) {
+			shouldResize = MU_FALSE;
+			if (!CyResizeEditorBox(&box, resizeWidth, resizeHeight)) {
+				CyLog("Failed to resize editor box to %" PRIu32 "x%" PRIu32 "\n", resizeWidth, resizeHeight);
+			}
+			shouldUpdate = MU_TRUE;
+		}
+
+		// Scroll smoothly, slowing down over time; only needs a refresh
+		// when a new line comes into view
+		double now = CyGfxTime();
+		float delta = (float)(now - lastTime);
+		lastTime = now;
+		if (scrollVelocity != 0.f) {
+			if (CyScrollEditorBox(&box, scrollVelocity * delta)) {
+				shouldUpdate = MU_TRUE;
+			}
+			shouldRender = MU_TRUE;
+			scrollVelocity *= expf(-SCROLL_DECAY * delta);
+			if (fabsf(scrollVelocity) < 1.f) {
+				scrollVelocity = 0.f;
+			}
+		}
+		CY_PROFILE_END(&profiler, PROFILE_INPUT);
+
+		// Whether or not the box is refreshed this frame
+		muBool updating = shouldUpdate;
 		if (shouldUpdate) {
 			shouldUpdate = MU_FALSE;
+			// Keep the cursor in view if it moved or the file changed
+			if (box.file.cursorOffset != lastCursor || box.file.version != lastVersion) {
+				lastCursor = box.file.cursorOffset;
+				lastVersion = box.file.version;
+				scrollVelocity = 0.f;
+				CyScrollEditorBoxToCursor(&box);
+			}
+			CY_PROFILE_BEGIN(&profiler, PROFILE_REFRESH);
 			CyRefreshEditorBox(&box);
+			CY_PROFILE_END(&profiler, PROFILE_REFRESH);
+			CY_PROFILE_COUNT(&profiler, 0, box.refreshStats.uploadBytes);
+			shouldRender = MU_TRUE;
+			double refreshed = CyGfxTime();
+			CyMarkLatency(&latency, LATENCY_REFRESH, refreshed - box.refreshStats.uploadSeconds);
+			CyMarkLatency(&latency, LATENCY_FILL, refreshed);
+		}
+
+		// Whether or not anything is drawn this frame
+		muBool drawing = shouldRender;
+		if (shouldRender) {
+			shouldRender = MU_FALSE;
+#ifdef CY_PROFILE
+			CY_PROFILE_BEGIN(&profiler, PROFILE_HUD);
+			updateHud();
+			CY_PROFILE_END(&profiler, PROFILE_HUD);
+#endif
+
+			CY_PROFILE_BEGIN(&profiler, PROFILE_CLEAR);
+			CyGfxClear();
+			CY_PROFILE_END(&profiler, PROFILE_CLEAR);
+
+			CY_PROFILE_BEGIN(&profiler, PROFILE_RENDER);
+			CyRenderEditorBox(&box);
+#ifdef CY_PROFILE
+			CyRenderEditorBox(&hud);
+			CY_PROFILE_COUNT(&profiler, box.drawCalls + hud.drawCalls, 0);
+#endif
+			CY_PROFILE_END(&profiler, PROFILE_RENDER);
+			CyMarkLatency(&latency, LATENCY_RENDER, CyGfxTime());
+
+			CY_PROFILE_BEGIN(&profiler, PROFILE_PRESENT);
+			CyGfxPresent();
+			CY_PROFILE_END(&profiler, PROFILE_PRESENT);
+			CyMarkLatency(&latency, LATENCY_PRESENT, CyGfxTime());
 		}
-		CyRenderEditorBox(&box);
 
-		CyGfxUpdate();
+		// Log the refresh once the frame is out, so that writing it isn't
+		// timed as part of rendering
+		if (updating) {
+			CyLog("Refreshed after %" PRIu32 " input events in %.3f ms; %" PRIu32 " cells changed, %" PRIu32 " bytes uploaded in %" PRIu32 " spans; %" PRIu32 " glyphs, %" PRIu32 " backgrounds; %" PRIu32 " draw calls\n",
+				events, box.refreshStats.seconds * 1000.0, box.refreshStats.changedCells,
+				box.refreshStats.uploadBytes, box.refreshStats.uploadSpans, box.numGlyphs, box.numBackgrounds, box.drawCalls
+			);
+		}
+
+		// Work out how lines wrap a bit at a time while nothing's happening,
+		// like after a resize, so that scrolling far doesn't have to
+		if (!drawing) {
+			CyRewrapEditorBox(&box, REWRAP_LINES);
+		}
+
+		CY_PROFILE_BEGIN(&profiler, PROFILE_WAIT);
+		CyGfxWait();
+		CY_PROFILE_END(&profiler, PROFILE_WAIT);
+		CY_PROFILE_FRAME_END(&profiler, drawing);
 	}
 
-	// Destroy editor box
+	// Report input latency
+	CyLogLatency(&latency);
+	if (CyWriteLatencyCSV(&latency, LATENCY_CSV)) {
+		CyLog("Wrote input latency to \"" LATENCY_CSV "\"\n");
+	} else {
+		CyLog("Failed to write input latency to \"" LATENCY_CSV "\"\n");
+	}
+	CyLog("\n");
+
+	// Destroy editor boxes
 	CyLog("Destroying editor box...\n");
 	CyDestroyEditorBox(&box);
+#ifdef CY_PROFILE
+	CyLog("Destroying profiler HUD...\n");
+	CyDestroyEditorBox(&hud);
+#endif
 
 	// Destroy stuff
 	CyDeloadRequiredFonts();
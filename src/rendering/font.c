@@ -12,12 +12,43 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+
+// Frees all cached glyph metrics
+void CyClearFontMetrics(CyFont* font) {
+	for (uint32_m i = 0; i < FONT_RANGE_COUNT; ++i) {
+		free(font->rangeMetrics[i]);
+		font->rangeMetrics[i] = 0;
+	}
+}
+
+// Forgets which codepoint ranges have textures
+void CyClearFontRanges(CyFont* font) {
+	for (uint32_m i = 0; i < FONT_RANGE_COUNT; ++i) {
+		font->rangeTextures[i] = FONT_NO_TEXTURE;
+	}
+}
+
+// Destroys the atlas and forgets all loaded ranges
+void CyClearFontAtlas(CyFont* font) {
+	if (font->atlas) {
+		font->atlas = CyGfxDestroyTexture(font->atlas);
+	}
+	free(font->atlasPixels);
+	font->atlasPixels = 0;
+	font->numTextures = 0;
+	CyClearFontRanges(font);
+}
 
 // Generates a CyFont based on filename
 // Returns if it failed or succeeded
 muBool CyLoadFont(CyFont* font, const char* filename) {
 	// Initialize members within font
 	font->numTextures = 0;
+	font->atlas = 0;
+	font->atlasPixels = 0;
+	CyClearFontRanges(font);
+	memset(font->rangeMetrics, 0, sizeof(font->rangeMetrics));
 
 	// Open file in binary
 	CyLog("Opening font file \"%s\"...\n", filename);
@@ -109,29 +140,26 @@ muBool CyLoadFont(CyFont* font, const char* filename) {
 void CyDestroyFont(CyFont* font) {
 	CyLog("Deloading font...\n");
 
-	// Free rglyph buffer
+	// Free rglyph buffer and cached metrics
 	free(font->rdata);
+	CyClearFontMetrics(font);
 
-	// Destroy all textures
-	for (uint16_m i = 0; i < font->numTextures; ++i) {
-		font->textures[i] = mu_gtexture_destroy(gfx, font->textures[i]);
-	}
-	font->numTextures = 0;
+	// Destroy atlas
+	CyClearFontAtlas(font);
 
 	// Deload font
 	mutt_deload(&font->font);
 }
 
 // Sets the point size of a font
-// Also deloads all font layers
+// Also deloads all font layers and clears cached glyph metrics
 void CySetFontPointSize(CyFont* font, float pointSize) {
 	// Set point size and destroy all texture layers
 	font->pointSize = pointSize;
-	// Destroy all textures
-	for (uint16_m i = 0; i < font->numTextures; ++i) {
-		font->textures[i] = mu_gtexture_destroy(gfx, font->textures[i]);
-	}
-	font->numTextures = 0;
+	// Destroy atlas
+	CyClearFontAtlas(font);
+	// Metrics depend on the point size
+	CyClearFontMetrics(font);
 
 	// Determine layer dimensions based on point size
 	font->layerDim[0] = (mutt_funits_to_punits(&font->font, font->font.head->x_max - font->font.head->x_min, pointSize, PPI)) + 2;
@@ -149,9 +177,9 @@ void CySetFontPointSize(CyFont* font, float pointSize) {
 // Should be confirmed that given codepoint doesn't already
 // have a range before calling this...
 muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint) {
-	CyLog("Loading new texture for codepoint range...\n");
+	CyLog("Loading new atlas layer for codepoint range...\n");
 
-	// Increase number of textures
+	// Increase number of layers
 	if (font->numTextures == FONT_RANGE_BUF-1) {
 		CyLog("Reached maximum amount of %i ranges per font\n", FONT_RANGE_BUF);
 		return MU_FALSE;
@@ -164,25 +192,36 @@ muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint) {
 
 	CyLog("Rasterizing codepoints within range...\n");
 
-	// Allocate pixels
-	muByte* pixels = (muByte*)malloc(font->layerDim[0] * font->layerDim[1] * FONT_LAYERS * 4);
-	if (!pixels) {
+	// Make room for another layer of pixels
+	// Each layer is a grid of glyphs, each glyph taking up layerDim
+	uint32_m layerWidth = font->layerDim[0] * FONT_ATLAS_GRID;
+	uint32_m layerHeight = font->layerDim[1] * FONT_ATLAS_GRID;
+	size_m layerSize = (size_m)layerWidth * layerHeight * 4;
+	muByte* atlasPixels = (muByte*)realloc(font->atlasPixels, layerSize * (i+1));
+	if (!atlasPixels) {
 		CyLog("Failed to allocate pixels\n");
 		font->numTextures--;
 		return MU_FALSE;
 	}
-	memset(pixels, 0, font->layerDim[0] * font->layerDim[1] * FONT_LAYERS * 4);
+	font->atlasPixels = atlasPixels;
+	muByte* pixels = &atlasPixels[layerSize * i];
+	memset(pixels, 0, layerSize);
 	// Describe bitmap
 	muttRBitmap bitmap;
 	bitmap.width = font->layerDim[0];
 	bitmap.height = font->layerDim[1];
 	bitmap.channels = MUTTR_RGBA;
-	bitmap.stride = bitmap.width*4;
+	bitmap.stride = layerWidth*4;
 	bitmap.io_color = MUTTR_BW;
-	bitmap.pixels = pixels;
 
 	// Loop through each character in codepoint range
 	for (uint32_m c = 0; c < FONT_LAYERS; ++c) {
+		// Point bitmap to the glyph's place in the grid
+		bitmap.pixels = &pixels[
+			((c / FONT_ATLAS_GRID) * bitmap.height * bitmap.stride)
+			+ ((c % FONT_ATLAS_GRID) * bitmap.width * 4)
+		];
+
 		// Get glyph ID (default on missing codepoint)
 		uint32_m thisCodepoint = font->textureStartCodes[i] + c;
 		uint16_m glyph_id = CyFontGetGlyphID(font, thisCodepoint);
@@ -192,7 +231,6 @@ muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint) {
 		muttResult mutt_res = mutt_glyph_header(&font->font, glyph_id, &header);
 		if ((mutt_result_is_fatal(mutt_res)) || (header.number_of_contours == 0)) {
 			CyLog("Codepoint %" PRIu32 "'s header failed to load (may be empty, this is normal); skipping\n", thisCodepoint);
-			bitmap.pixels += bitmap.stride * bitmap.height;
 			continue;
 		}
 
@@ -201,7 +239,6 @@ muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint) {
 		mutt_res = mutt_header_rglyph(&font->font, &header, &rglyph, font->pointSize, PPI, font->rdata, 0);
 		if (mutt_result_is_fatal(mutt_res)) {
 			CyLog("Codepoint %" PRIu32 "'s raster glyph failed to load; skipping\n", thisCodepoint);
-			bitmap.pixels += bitmap.stride * bitmap.height;
 			continue;
 		}
 
@@ -210,56 +247,63 @@ muBool CyFontLoadCodepoint(CyFont* font, uint32_m codepoint) {
 		if (mutt_result_is_fatal(mutt_res)) {
 			CyLog("Codepoint %" PRIu32 " failed to rasterize\n", thisCodepoint);
 		}
-		bitmap.pixels += bitmap.stride * bitmap.height;
 	}
 
-	// Create texture
-	CyLog("Finished rasterizing; creating texture...\n");
+	// Recreate atlas with the new layer
+	CyLog("Finished rasterizing; recreating atlas with %" PRIu32 " layers...\n", i+1);
 	mugTextureInfo texInfo;
 	texInfo.type = MUG_TEXTURE_2D_ARRAY;
 	texInfo.format = MUG_TEXTURE_U8_RGBA;
 	texInfo.wrapping[0] = texInfo.wrapping[1] = MUG_TEXTURE_CLAMP;
 	texInfo.filtering[0] = texInfo.filtering[1] = MUG_TEXTURE_NEAREST;
-	uint32_m dim[3] = { font->layerDim[0], font->layerDim[1], FONT_LAYERS };
-	font->textures[i] = mu_gtexture_create(gfx, &texInfo, dim, pixels);
-	free(pixels);
-	if (font->textures[i] == 0) {
+	uint32_m dim[3] = { layerWidth, layerHeight, i+1 };
+	mugTexture atlas = CyGfxCreateTexture(&texInfo, dim, atlasPixels);
+	if (atlas == 0) {
 		CyLog("Failed to create texture\n");
 		font->numTextures--;
 		return MU_FALSE;
 	}
+	if (font->atlas) {
+		CyGfxDestroyTexture(font->atlas);
+	}
+	font->atlas = atlas;
 
+	font->rangeTextures[font->textureStartCodes[i] / FONT_LAYERS] = i;
 	return MU_TRUE;
 }
 
 // Checks if the given codepoint has been loaded into a font
 // Sets layer if found
 muBool CyFontIsCodepointLoaded(CyFont* font, uint32_m codepoint, uint16_m* texture, uint16_m* layer) {
-	for (uint16_m i = 0; i < font->numTextures; ++i) {
-		if (codepoint >= font->textureStartCodes[i] && codepoint <= (font->textureStartCodes[i] + FONT_LAYERS)) {
-			if (texture) {
-				*texture = i;
-			}
-			if (layer) {
-				*layer = codepoint - font->textureStartCodes[i];
-			}
-			return MU_TRUE;
-		}
+	uint32_m range = codepoint / FONT_LAYERS;
+	if (range >= FONT_RANGE_COUNT || font->rangeTextures[range] == FONT_NO_TEXTURE) {
+		return MU_FALSE;
 	}
-	return MU_FALSE;
+
+	if (texture) {
+		*texture = font->rangeTextures[range];
+	}
+	if (layer) {
+		*layer = codepoint % FONT_LAYERS;
+	}
+	return MU_TRUE;
 }
 
-// Gets the texture and layer of a codepoint
+// Gets the texture and layer of a codepoint; O(1)
 // Defaults on missing character
 void CyFontGetTexture(CyFont* font, uint32_m codepoint, uint16_m* texture, uint16_m* layer) {
-	for (uint16_m i = 0; i < font->numTextures; ++i) {
-		if (codepoint >= font->textureStartCodes[i] && codepoint <= (font->textureStartCodes[i] + FONT_LAYERS)) {
-			*texture = i;
-			*layer = codepoint - font->textureStartCodes[i];
-			return;
-		}
+	if (!CyFontIsCodepointLoaded(font, codepoint, texture, layer)) {
+		CyFontIsCodepointLoaded(font, 0x25A1, texture, layer);
 	}
-	CyFontGetTexture(font, 0x25A1, texture, layer);
+}
+
+// Gets the cutout of a codepoint's glyph in the atlas, in texture
+// coordinates, given what CyFontGetTexture gave
+void CyFontGetCutout(uint16_m texture, uint16_m layer, float pos[3], float dim[2]) {
+	dim[0] = dim[1] = 1.f / FONT_ATLAS_GRID;
+	pos[0] = (layer % FONT_ATLAS_GRID) * dim[0];
+	pos[1] = (layer / FONT_ATLAS_GRID) * dim[1];
+	pos[2] = texture;
 }
 
 // Gets a codepoint from a font
@@ -272,3 +316,58 @@ uint16_m CyFontGetGlyphID(CyFont* font, uint32_m codepoint) {
 	return glyph_id;
 }
 
+// Calculates the metrics of a codepoint at the current point size
+void CyCalculateGlyphMetrics(CyFont* font, uint32_m codepoint, CyGlyphMetrics* metrics) {
+	// Center the layer within the cell by default
+	metrics->xOffset = font->layerDim[0] * 0.5f;
+	metrics->yOffset = -roundf(font->pHeight) - (font->layerDim[1] * 0.5f);
+	metrics->cached = MU_TRUE;
+	// Glyphs without a header or outline are left empty in the atlas
+	metrics->blank = MU_TRUE;
+
+	// Get glyph header
+	uint16_m glyphID = CyFontGetGlyphID(font, codepoint);
+	muttGlyphHeader header;
+	if (mutt_result_is_fatal(mutt_glyph_header(&font->font, glyphID, &header))) {
+		return;
+	}
+	metrics->blank = (header.number_of_contours == 0);
+
+	// Get rglyph metrics
+	muttRGlyph rglyph;
+	mutt_rglyph_metrics(&font->font, &header, glyphID, &rglyph, font->pointSize, PPI);
+	mutt_funits_punits_min_max(&font->font, &header, &rglyph, font->pointSize, PPI);
+
+	// Offset x-value by lsb
+	metrics->xOffset += rglyph.lsb;
+	// Offset y-value by this magic thing that works
+	metrics->yOffset += (rglyph.ascender * 2.f) - rglyph.descender;
+}
+
+// Gets the metrics of a codepoint at the current point size
+// Calculated on first use and cached from then on
+// Defaults on missing
+const CyGlyphMetrics* CyFontGetGlyphMetrics(CyFont* font, uint32_m codepoint) {
+	uint32_m range = codepoint / FONT_LAYERS;
+	if (range >= FONT_RANGE_COUNT) {
+		codepoint = 0x25A1;
+		range = codepoint / FONT_LAYERS;
+	}
+
+	// Allocate cache for range if needed
+	if (!font->rangeMetrics[range]) {
+		font->rangeMetrics[range] = (CyGlyphMetrics*)calloc(FONT_LAYERS, sizeof(CyGlyphMetrics));
+		// (If we can't, calculate them every time)
+		if (!font->rangeMetrics[range]) {
+			CyCalculateGlyphMetrics(font, codepoint, &font->uncachedMetrics);
+			return &font->uncachedMetrics;
+		}
+	}
+
+	CyGlyphMetrics* metrics = &font->rangeMetrics[range][codepoint % FONT_LAYERS];
+	if (!metrics->cached) {
+		CyCalculateGlyphMetrics(font, codepoint, metrics);
+	}
+	return metrics;
+}
+
@@ -0,0 +1,560 @@
+// raster.c
+// Rasterizes the frames recorded by the headless gfx backend into an
+// RGBA framebuffer in memory, redrawing only the tiles that changed
+
+#include "rendering/raster.h"
+#include "core/gfx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+
+// FNV-1a parameters used for hashing items and tiles
+#define RASTER_HASH_BASIS 14695981039346656037ULL
+#define RASTER_HASH_PRIME 1099511628211ULL
+
+/* Inner */
+
+	// Divides a product of two 8-bit values by 255, rounded
+	#define CY_DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
+
+	#ifdef __SSE2__
+	// Blends 4 pixels (src multiplied by col) over 4 others, each channel
+	// widened to 16 bits; src is 0 for just col
+	__m128i CyBlend4(__m128i d, const muByte* src, __m128i col) {
+		__m128i zero = _mm_setzero_si128();
+		__m128i max = _mm_set1_epi16(255);
+		__m128i one = _mm_set1_epi16(1);
+		__m128i dLo = _mm_unpacklo_epi8(d, zero);
+		__m128i dHi = _mm_unpackhi_epi8(d, zero);
+
+		// Source, multiplied by color
+		__m128i sLo = col, sHi = col;
+		if (src) {
+			__m128i s = _mm_loadu_si128((const __m128i*)src);
+			sLo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), col);
+			sHi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), col);
+			sLo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sLo, one), _mm_srli_epi16(sLo, 8)), 8);
+			sHi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sHi, one), _mm_srli_epi16(sHi, 8)), 8);
+		}
+
+		// Alpha of each pixel across its channels
+		__m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+		// src * a + dst * (255 - a), divided by 255
+		__m128i oLo = _mm_add_epi16(_mm_mullo_epi16(sLo, aLo), _mm_mullo_epi16(dLo, _mm_sub_epi16(max, aLo)));
+		__m128i oHi = _mm_add_epi16(_mm_mullo_epi16(sHi, aHi), _mm_mullo_epi16(dHi, _mm_sub_epi16(max, aHi)));
+		oLo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(oLo, one), _mm_srli_epi16(oLo, 8)), 8);
+		oHi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(oHi, one), _mm_srli_epi16(oHi, 8)), 8);
+		return _mm_packus_epi16(oLo, oHi);
+	}
+	#endif
+
+	// Blends a span of pixels over the framebuffer
+	// The span is src's texels multiplied by color, or just color if src
+	// is 0; both give the same results with or without SSE2
+	void CyBlendSpan(muByte* dst, const muByte* src, uint32_m count, const uint8_m color[4]) {
+		uint32_m i = 0;
+
+		// Opaque colors simply overwrite
+		if (!src && color[3] == 255) {
+			uint32_m pixel;
+			memcpy(&pixel, color, 4);
+		#ifdef __SSE2__
+			__m128i pixels = _mm_set1_epi32((int)pixel);
+			for (; i + 4 <= count; i += 4) {
+				_mm_storeu_si128((__m128i*)&dst[i*4], pixels);
+			}
+		#endif
+			for (; i < count; ++i) {
+				memcpy(&dst[i*4], &pixel, 4);
+			}
+			return;
+		}
+
+	#ifdef __SSE2__
+		// 4 pixels at a time
+		__m128i col = _mm_set_epi16(color[3], color[2], color[1], color[0], color[3], color[2], color[1], color[0]);
+		for (; i + 4 <= count; i += 4) {
+			__m128i d = _mm_loadu_si128((const __m128i*)&dst[i*4]);
+			_mm_storeu_si128((__m128i*)&dst[i*4], CyBlend4(d, (src) ? &src[i*4] : 0, col));
+		}
+		// The rest padded out to 4
+		if (i < count) {
+			muByte d[16], s[16];
+			memcpy(d, &dst[i*4], (count - i) * 4);
+			if (src) {
+				memcpy(s, &src[i*4], (count - i) * 4);
+			}
+			_mm_storeu_si128((__m128i*)d, CyBlend4(_mm_loadu_si128((const __m128i*)d), (src) ? s : 0, col));
+			memcpy(&dst[i*4], d, (count - i) * 4);
+			return;
+		}
+	#else
+		// One at a time
+		for (; i < count; ++i) {
+			uint32_m s[4];
+			for (uint8_m c = 0; c < 4; ++c) {
+				s[c] = (src) ? CY_DIV255((uint32_m)src[i*4+c] * color[c]) : color[c];
+			}
+			for (uint8_m c = 0; c < 4; ++c) {
+				uint32_m o = (s[c] * s[3]) + ((uint32_m)dst[i*4+c] * (255 - s[3]));
+				dst[i*4+c] = (muByte)CY_DIV255(o);
+			}
+		}
+	#endif
+	}
+
+	// Mixes a value into a hash
+	#define CY_HASH_RASTER(hash, value) (((hash) ^ (uint64_m)(value)) * RASTER_HASH_PRIME)
+
+	// Converts a color channel from 0-1 to 0-255
+	uint8_m CyRasterChannel(float channel) {
+		if (channel <= 0.f) {
+			return 0;
+		}
+		if (channel >= 1.f) {
+			return 255;
+		}
+		return (uint8_m)((channel * 255.f) + .5f);
+	}
+
+	// Works out the pixels a rect covers, [x0, x1) by [y0, y1), going by
+	// which pixel centers are inside it
+	void CyGetRasterBounds(float left, float top, float width, float height, int32_m bounds[4]) {
+		bounds[0] = (int32_m)ceilf(left - .5f);
+		bounds[1] = (int32_m)ceilf(top - .5f);
+		bounds[2] = (int32_m)ceilf(left + width - .5f);
+		bounds[3] = (int32_m)ceilf(top + height - .5f);
+	}
+
+	// Adds an item covering the given pixels at the end of the frame's
+	// items, clipped to the framebuffer
+	// Returns 0 if it covers none, or if there was no room
+	CyRasterItem* CyAddRasterItem(CyRaster* raster, int32_m bounds[4], float* col) {
+		CyRasterItem item;
+		item.x0 = bounds[0];
+		item.y0 = bounds[1];
+		item.x1 = bounds[2];
+		item.y1 = bounds[3];
+		if (item.x0 < 0) item.x0 = 0;
+		if (item.y0 < 0) item.y0 = 0;
+		if (item.x1 > (int32_m)raster->width) item.x1 = (int32_m)raster->width;
+		if (item.y1 > (int32_m)raster->height) item.y1 = (int32_m)raster->height;
+		if (item.x0 >= item.x1 || item.y0 >= item.y1) {
+			return 0;
+		}
+
+		for (uint8_m c = 0; c < 4; ++c) {
+			item.color[c] = CyRasterChannel(col[c]);
+		}
+		item.pixels = 0;
+		item.texWidth = item.texHeight = 0;
+		item.u = item.v = item.du = item.dv = 0;
+		item.hash = 0;
+
+		if (raster->numItems == raster->itemCapacity) {
+			uint32_m capacity = (raster->itemCapacity == 0) ? 1024 : raster->itemCapacity * 2;
+			CyRasterItem* items = (CyRasterItem*)realloc(raster->items, capacity * sizeof(CyRasterItem));
+			if (!items) {
+				return 0;
+			}
+			raster->items = items;
+			raster->itemCapacity = capacity;
+		}
+		raster->items[raster->numItems] = item;
+		return &raster->items[raster->numItems++];
+	}
+
+	// Trims the pixels of a texture cutout sampled 1:1 down to the ones
+	// whose texels aren't fully transparent, moving the first texel along
+	// A glyph's cutout is mostly empty, so this saves most of its blending
+	// Returns false if every texel is transparent
+	muBool CyTrimRasterItem(CyRaster* raster, CyGfxTexture* texture, uint32_m layer, int32_m bounds[4], int32_m texel[2]) {
+		// Cutouts reaching outside the texture are left alone
+		int32_m tx = texel[0] >> 16, ty = texel[1] >> 16;
+		int32_m width = bounds[2] - bounds[0], height = bounds[3] - bounds[1];
+		if (tx < 0 || ty < 0 || width <= 0 || height <= 0 || tx + width > (int32_m)texture->dim[0] || ty + height > (int32_m)texture->dim[1]) {
+			return MU_TRUE;
+		}
+
+		// Look for the cutout in the cache
+		uint64_m hash = RASTER_HASH_BASIS;
+		hash = CY_HASH_RASTER(hash, texture->id);
+		hash = CY_HASH_RASTER(hash, layer);
+		hash = CY_HASH_RASTER(hash, tx);
+		hash = CY_HASH_RASTER(hash, ty);
+		hash = CY_HASH_RASTER(hash, width);
+		hash = CY_HASH_RASTER(hash, height);
+		uint32_m index = (uint32_m)(hash ^ (hash >> 32)) & (RASTER_TRIM_CACHE - 1);
+		CyRasterTrim* trim = &raster->trims[index];
+		while (trim->used) {
+			if (trim->textureId == texture->id && trim->layer == layer && trim->texel[0] == tx && trim->texel[1] == ty && trim->dim[0] == width && trim->dim[1] == height) {
+				break;
+			}
+			index = (index + 1) & (RASTER_TRIM_CACHE - 1);
+			trim = &raster->trims[index];
+		}
+
+		// Find the opaque part of the cutout if it isn't cached
+		if (!trim->used) {
+			// (Start over once the cache gets crowded)
+			if (raster->numTrims >= (RASTER_TRIM_CACHE / 4) * 3) {
+				memset(raster->trims, 0, RASTER_TRIM_CACHE * sizeof(CyRasterTrim));
+				raster->numTrims = 0;
+				return CyTrimRasterItem(raster, texture, layer, bounds, texel);
+			}
+			++raster->numTrims;
+			trim->used = MU_TRUE;
+			trim->textureId = texture->id;
+			trim->layer = layer;
+			trim->texel[0] = tx;
+			trim->texel[1] = ty;
+			trim->dim[0] = width;
+			trim->dim[1] = height;
+			trim->ink[0] = width;
+			trim->ink[1] = height;
+			trim->ink[2] = trim->ink[3] = 0;
+
+			const muByte* pixels = &texture->pixels[(size_m)layer * texture->dim[0] * texture->dim[1] * 4];
+			for (int32_m y = 0; y < height; ++y) {
+				const muByte* row = &pixels[(((size_m)(ty + y) * texture->dim[0]) + tx) * 4];
+				for (int32_m x = 0; x < width; ++x) {
+					if (row[(x * 4) + 3] != 0) {
+						if (x < trim->ink[0]) trim->ink[0] = x;
+						if (y < trim->ink[1]) trim->ink[1] = y;
+						if (x >= trim->ink[2]) trim->ink[2] = x + 1;
+						if (y >= trim->ink[3]) trim->ink[3] = y + 1;
+					}
+				}
+			}
+		}
+
+		if (trim->ink[0] >= trim->ink[2]) {
+			return MU_FALSE;
+		}
+		texel[0] += trim->ink[0] << 16;
+		texel[1] += trim->ink[1] << 16;
+		bounds[2] = bounds[0] + trim->ink[2];
+		bounds[3] = bounds[1] + trim->ink[3];
+		bounds[0] += trim->ink[0];
+		bounds[1] += trim->ink[1];
+		return MU_TRUE;
+	}
+
+	// Adds an item sampling a texture layer over a rect, given the texture
+	// cutout
+	void CyAddTextureRasterItem(CyRaster* raster, CyGfxTexture* texture, uint32_m layer, float left, float top, float width, float height, float* col, float* texPos, float* texDim) {
+		int32_m bounds[4];
+		CyGetRasterBounds(left, top, width, height, bounds);
+
+		// Texel coordinates of the first pixel's center, and per pixel
+		double du = ((double)texDim[0] * texture->dim[0]) / width;
+		double dv = ((double)texDim[1] * texture->dim[1]) / height;
+		double u = ((double)texPos[0] * texture->dim[0]) + ((((double)bounds[0] + .5) - left) * du);
+		double v = ((double)texPos[1] * texture->dim[1]) + ((((double)bounds[1] + .5) - top) * dv);
+		int32_m texel[2] = { (int32_m)floor((u * 65536.0) + .5), (int32_m)floor((v * 65536.0) + .5) };
+		int32_m step[2] = { (int32_m)floor((du * 65536.0) + .5), (int32_m)floor((dv * 65536.0) + .5) };
+
+		if (step[0] == 65536 && step[1] == 65536 && !CyTrimRasterItem(raster, texture, layer, bounds, texel)) {
+			return;
+		}
+
+		CyRasterItem* item = CyAddRasterItem(raster, bounds, col);
+		if (!item) {
+			return;
+		}
+		item->texWidth = texture->dim[0];
+		item->texHeight = texture->dim[1];
+		item->pixels = &texture->pixels[(size_m)layer * texture->dim[0] * texture->dim[1] * 4];
+		// (Move the first texel along with the clipping)
+		item->u = texel[0] + ((item->x0 - bounds[0]) * step[0]);
+		item->v = texel[1] + ((item->y0 - bounds[1]) * step[1]);
+		item->du = step[0];
+		item->dv = step[1];
+	}
+
+	// Flattens the objects of a render command into items
+	void CyFlattenRasterCommand(CyRaster* raster, CyGfxCommand* command) {
+		CyGfxObjects* objects = command->objects;
+		if (!objects) {
+			return;
+		}
+		float* shift = command->shift;
+		CyGfxTexture* texture = command->texture;
+
+		for (uint32_m o = command->offset; o < command->offset + command->count; ++o) {
+			muByte* object = &objects->objects[o * objects->objectSize];
+
+			switch (objects->type) {
+				// Skip what can't be rasterized
+				default: ++raster->skippedObjects; break;
+
+				case MUG_OBJECT_RECT: {
+					mugRect* rect = (mugRect*)object;
+					int32_m bounds[4];
+					CyGetRasterBounds(
+						rect->center.pos[0] + shift[0] - (rect->dim[0] / 2.f), rect->center.pos[1] + shift[1] - (rect->dim[1] / 2.f),
+						rect->dim[0], rect->dim[1], bounds
+					);
+					CyAddRasterItem(raster, bounds, rect->center.col);
+				} break;
+
+				case MUG_OBJECT_TEXTURE_2D: case MUG_OBJECT_TEXTURE_2D_ARRAY: {
+					// Only RGBA textures of the right type are sampled
+					mugTextureType textureType = (objects->type == MUG_OBJECT_TEXTURE_2D) ? MUG_TEXTURE_2D : MUG_TEXTURE_2D_ARRAY;
+					if (!texture || texture->info.type != textureType || texture->info.format != MUG_TEXTURE_U8_RGBA) {
+						++raster->skippedObjects;
+						break;
+					}
+
+					// (Both texture rects start out the same)
+					mug2DTextureRect* rect = (mug2DTextureRect*)object;
+					uint32_m layer = 0;
+					float* texDim = rect->tex_dim;
+					if (objects->type == MUG_OBJECT_TEXTURE_2D_ARRAY) {
+						mug2DTextureArrayRect* arrayRect = (mug2DTextureArrayRect*)object;
+						if (arrayRect->tex_pos[2] < 0.f || arrayRect->tex_pos[2] + .5f >= (float)texture->dim[2]) {
+							break;
+						}
+						layer = (uint32_m)(arrayRect->tex_pos[2] + .5f);
+						texDim = arrayRect->tex_dim;
+					}
+
+					CyAddTextureRasterItem(raster, texture, layer,
+						rect->center.pos[0] + shift[0] - (rect->dim[0] / 2.f), rect->center.pos[1] + shift[1] - (rect->dim[1] / 2.f),
+						rect->dim[0], rect->dim[1], rect->center.col, rect->tex_pos, texDim
+					);
+				} break;
+			}
+		}
+	}
+
+	// Hashes everything about an item that affects what's drawn
+	void CyHashRasterItem(CyRasterItem* item, CyGfxTexture* texture) {
+		uint64_m hash = RASTER_HASH_BASIS;
+		hash = CY_HASH_RASTER(hash, (uint32_m)item->x0 | ((uint64_m)(uint32_m)item->y0 << 32));
+		hash = CY_HASH_RASTER(hash, (uint32_m)item->x1 | ((uint64_m)(uint32_m)item->y1 << 32));
+		hash = CY_HASH_RASTER(hash, (uint32_m)item->color[0] | ((uint32_m)item->color[1] << 8) | ((uint32_m)item->color[2] << 16) | ((uint32_m)item->color[3] << 24));
+		if (item->pixels) {
+			// The texture's number and layer offset stand in for its pixels
+			hash = CY_HASH_RASTER(hash, texture->id);
+			hash = CY_HASH_RASTER(hash, (size_m)(item->pixels - texture->pixels));
+			hash = CY_HASH_RASTER(hash, (uint32_m)item->u | ((uint64_m)(uint32_m)item->v << 32));
+			hash = CY_HASH_RASTER(hash, (uint32_m)item->du | ((uint64_m)(uint32_m)item->dv << 32));
+		}
+		item->hash = hash;
+	}
+
+	// Sorts the frame's items into the tiles they cover, keeping their order
+	// Returns false if there was no room
+	muBool CyBinRasterItems(CyRaster* raster) {
+		uint32_m numTiles = raster->tilesX * raster->tilesY;
+		memset(raster->binStarts, 0, (numTiles + 1) * sizeof(uint32_m));
+
+		// Count the items over each tile
+		uint32_m total = 0;
+		for (uint32_m i = 0; i < raster->numItems; ++i) {
+			CyRasterItem* item = &raster->items[i];
+			for (int32_m ty = item->y0 / RASTER_TILE_SIZE; ty <= (item->y1 - 1) / RASTER_TILE_SIZE; ++ty) {
+				for (int32_m tx = item->x0 / RASTER_TILE_SIZE; tx <= (item->x1 - 1) / RASTER_TILE_SIZE; ++tx) {
+					++raster->binStarts[(ty * raster->tilesX) + tx + 1];
+					++total;
+				}
+			}
+		}
+		if (total > raster->binCapacity) {
+			uint32_m* bins = (uint32_m*)realloc(raster->bins, total * sizeof(uint32_m));
+			if (!bins) {
+				return MU_FALSE;
+			}
+			raster->bins = bins;
+			raster->binCapacity = total;
+		}
+
+		// Turn the counts into where each tile's bin starts, then fill the
+		// bins, moving each start along to where the bin ends
+		for (uint32_m t = 1; t <= numTiles; ++t) {
+			raster->binStarts[t] += raster->binStarts[t - 1];
+		}
+		for (uint32_m i = 0; i < raster->numItems; ++i) {
+			CyRasterItem* item = &raster->items[i];
+			for (int32_m ty = item->y0 / RASTER_TILE_SIZE; ty <= (item->y1 - 1) / RASTER_TILE_SIZE; ++ty) {
+				for (int32_m tx = item->x0 / RASTER_TILE_SIZE; tx <= (item->x1 - 1) / RASTER_TILE_SIZE; ++tx) {
+					raster->bins[raster->binStarts[(ty * raster->tilesX) + tx]++] = i;
+				}
+			}
+		}
+		// (Each start is now where the next bin starts, so shift them back)
+		for (uint32_m t = numTiles; t > 0; --t) {
+			raster->binStarts[t] = raster->binStarts[t - 1];
+		}
+		raster->binStarts[0] = 0;
+		return MU_TRUE;
+	}
+
+	// Draws an item's pixels within a tile
+	void CyDrawRasterItem(CyRaster* raster, CyRasterItem* item, int32_m tileX0, int32_m tileY0, int32_m tileX1, int32_m tileY1) {
+		int32_m x0 = (item->x0 > tileX0) ? item->x0 : tileX0;
+		int32_m y0 = (item->y0 > tileY0) ? item->y0 : tileY0;
+		int32_m x1 = (item->x1 < tileX1) ? item->x1 : tileX1;
+		int32_m y1 = (item->y1 < tileY1) ? item->y1 : tileY1;
+		uint32_m count = (uint32_m)(x1 - x0);
+
+		for (int32_m y = y0; y < y1; ++y) {
+			muByte* dst = &raster->pixels[(((size_m)y * raster->width) + x0) * 4];
+			if (!item->pixels) {
+				CyBlendSpan(dst, 0, count, item->color);
+				continue;
+			}
+
+			// Row of texels, clamped into the texture
+			int32_m ty = (int32_m)((item->v + ((int64_m)(y - item->y0) * item->dv)) >> 16);
+			ty = (ty < 0) ? 0 : ((ty >= (int32_m)item->texHeight) ? (int32_m)item->texHeight - 1 : ty);
+			const muByte* row = &item->pixels[(size_m)ty * item->texWidth * 4];
+
+			// Blend straight from the texture if it's sampled 1:1 and in
+			// range, which a glyph usually is; otherwise gather the texels
+			int64_m u = item->u + ((int64_m)(x0 - item->x0) * item->du);
+			int32_m tx = (int32_m)(u >> 16);
+			if (item->du == 65536 && tx >= 0 && tx + (int32_m)count <= (int32_m)item->texWidth) {
+				CyBlendSpan(dst, &row[tx * 4], count, item->color);
+				continue;
+			}
+			muByte texels[RASTER_TILE_SIZE * 4];
+			for (uint32_m x = 0; x < count; ++x, u += item->du) {
+				tx = (int32_m)(u >> 16);
+				tx = (tx < 0) ? 0 : ((tx >= (int32_m)item->texWidth) ? (int32_m)item->texWidth - 1 : tx);
+				memcpy(&texels[x * 4], &row[tx * 4], 4);
+			}
+			CyBlendSpan(dst, texels, count, item->color);
+		}
+	}
+
+	// Redraws a tile: clears it, then draws the items over it in order
+	void CyDrawRasterTile(CyRaster* raster, uint32_m t, const uint8_m clear[4]) {
+		int32_m x0 = (int32_m)((t % raster->tilesX) * RASTER_TILE_SIZE);
+		int32_m y0 = (int32_m)((t / raster->tilesX) * RASTER_TILE_SIZE);
+		int32_m x1 = (x0 + RASTER_TILE_SIZE < (int32_m)raster->width) ? x0 + RASTER_TILE_SIZE : (int32_m)raster->width;
+		int32_m y1 = (y0 + RASTER_TILE_SIZE < (int32_m)raster->height) ? y0 + RASTER_TILE_SIZE : (int32_m)raster->height;
+
+		for (int32_m y = y0; y < y1; ++y) {
+			CyBlendSpan(&raster->pixels[(((size_m)y * raster->width) + x0) * 4], 0, (uint32_m)(x1 - x0), clear);
+		}
+		for (uint32_m b = raster->binStarts[t]; b < raster->binStarts[t + 1]; ++b) {
+			CyDrawRasterItem(raster, &raster->items[raster->bins[b]], x0, y0, x1, y1);
+		}
+		raster->drawnItems += raster->binStarts[t + 1] - raster->binStarts[t];
+	}
+
+/* Outer */
+
+	// Initializes a rasterizer with a framebuffer of the given size
+	muBool CyInitRaster(CyRaster* raster, uint32_m width, uint32_m height) {
+		memset(raster, 0, sizeof(CyRaster));
+		raster->width = width;
+		raster->height = height;
+		raster->tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+		raster->tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+		uint32_m numTiles = raster->tilesX * raster->tilesY;
+
+		raster->pixels = (muByte*)malloc(((size_m)width * height * 4) + 1);
+		raster->tileHashes = (uint64_m*)malloc((numTiles + 1) * sizeof(uint64_m));
+		raster->binStarts = (uint32_m*)malloc((numTiles + 1) * sizeof(uint32_m));
+		raster->trims = (CyRasterTrim*)calloc(RASTER_TRIM_CACHE, sizeof(CyRasterTrim));
+		if (!raster->pixels || !raster->tileHashes || !raster->binStarts || !raster->trims) {
+			CyDestroyRaster(raster);
+			return MU_FALSE;
+		}
+		return MU_TRUE;
+	}
+
+	// Destroys a rasterizer
+	void CyDestroyRaster(CyRaster* raster) {
+		free(raster->pixels);
+		free(raster->tileHashes);
+		free(raster->binStarts);
+		free(raster->bins);
+		free(raster->items);
+		free(raster->trims);
+		memset(raster, 0, sizeof(CyRaster));
+	}
+
+	// Makes every tile be redrawn next frame
+	void CyInvalidateRaster(CyRaster* raster) {
+		raster->drawn = MU_FALSE;
+	}
+
+	// Rasterizes the frame recorded by the headless backend since its last
+	// clear, redrawing only the tiles whose items changed since last frame
+	void CyRasterizeFrame(CyRaster* raster) {
+		double start = CyGfxTime();
+		raster->numItems = 0;
+		raster->dirtyTiles = 0;
+		raster->drawnItems = 0;
+		raster->skippedObjects = 0;
+
+		// Flatten everything rendered into items
+		for (uint32_m c = 0; c < gfx_record.numCommands; ++c) {
+			CyGfxCommand* command = &gfx_record.commands[c];
+			if (command->type == GFX_COMMAND_RENDER_OBJECTS) {
+				uint32_m first = raster->numItems;
+				CyFlattenRasterCommand(raster, command);
+				for (uint32_m i = first; i < raster->numItems; ++i) {
+					CyHashRasterItem(&raster->items[i], command->texture);
+				}
+			}
+		}
+		if (!CyBinRasterItems(raster)) {
+			raster->seconds = CyGfxTime() - start;
+			return;
+		}
+
+		// Redraw each tile whose items aren't the ones drawn over it last time
+		float clearColor[4] = { GFX_CLEAR_COLOR, 1.f };
+		uint8_m clear[4];
+		for (uint8_m c = 0; c < 4; ++c) {
+			clear[c] = CyRasterChannel(clearColor[c]);
+		}
+		uint32_m numTiles = raster->tilesX * raster->tilesY;
+		for (uint32_m t = 0; t < numTiles; ++t) {
+			uint64_m hash = RASTER_HASH_BASIS;
+			for (uint32_m b = raster->binStarts[t]; b < raster->binStarts[t + 1]; ++b) {
+				hash = CY_HASH_RASTER(hash, raster->items[raster->bins[b]].hash);
+			}
+			if (raster->drawn && raster->tileHashes[t] == hash) {
+				continue;
+			}
+			raster->tileHashes[t] = hash;
+			CyDrawRasterTile(raster, t, clear);
+			++raster->dirtyTiles;
+		}
+
+		raster->drawn = MU_TRUE;
+		raster->seconds = CyGfxTime() - start;
+	}
+
+	// Writes the framebuffer to a binary PPM file, dropping alpha
+	muBool CyWriteRasterPPM(CyRaster* raster, const char* filename) {
+		FILE* fptr = fopen(filename, "wb");
+		if (!fptr) {
+			return MU_FALSE;
+		}
+
+		fprintf(fptr, "P6\n%u %u\n255\n", (unsigned)raster->width, (unsigned)raster->height);
+		size_m numPixels = (size_m)raster->width * raster->height;
+		for (size_m p = 0; p < numPixels; ++p) {
+			fwrite(&raster->pixels[p * 4], 1, 3, fptr);
+		}
+
+		muBool success = !ferror(fptr);
+		fclose(fptr);
+		return success;
+	}
+
@@ -0,0 +1,821 @@
+// tty.c
+// Draws an editor box's cells to a terminal instead of a window, only
+// writing the cells that changed since the last frame, and turns the
+// terminal's key sequences into input events
+
+#include "rendering/tty.h"
+#include "editor/visualBuffer.h"
+#include "editor/input.h"
+#include "core/string.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Codepoint written in place of ones the terminal would take as controls
+#define TTY_CONTROL_CODEPOINT 0x3F
+
+/* Inner */
+
+	// Writes the buffered bytes to the stream
+	void CyFlushTty(CyTty* tty) {
+		if (tty->bufferLength == 0) {
+			return;
+		}
+		fwrite(tty->buffer, 1, tty->bufferLength, tty->out);
+		tty->frameBytes += tty->bufferLength;
+		tty->bufferLength = 0;
+	}
+
+	// Buffers bytes to be written
+	void CyTtyPut(CyTty* tty, const char* bytes, size_m length) {
+		if (tty->bufferLength + length > TTY_BUFFER_SIZE) {
+			CyFlushTty(tty);
+		}
+		memcpy(&tty->buffer[tty->bufferLength], bytes, length);
+		tty->bufferLength += length;
+	}
+
+	// Gets the amount of decimal digits in a number
+	uint32_m CyTtyDigits(uint32_m n) {
+		uint32_m digits = 1;
+		while (n >= 10) {
+			n /= 10;
+			++digits;
+		}
+		return digits;
+	}
+
+	// Buffers a number in decimal
+	void CyTtyPutNumber(CyTty* tty, uint32_m n) {
+		char digits[10];
+		uint32_m length = CyTtyDigits(n);
+		for (uint32_m i = length; i > 0; --i) {
+			digits[i-1] = (char)('0' + (n % 10));
+			n /= 10;
+		}
+		CyTtyPut(tty, digits, length);
+	}
+
+	// Buffers a control sequence with one parameter, left out if it's 1
+	// since that's what terminals take by default
+	void CyTtyPutSequence(CyTty* tty, uint32_m n, char final) {
+		CyTtyPut(tty, "\x1b[", 2);
+		if (n != 1) {
+			CyTtyPutNumber(tty, n);
+		}
+		CyTtyPut(tty, &final, 1);
+	}
+
+	// Gets the length of a control sequence with one parameter
+	uint32_m CyTtySequenceLength(uint32_m n) {
+		return (n == 1) ? 3 : 3 + CyTtyDigits(n);
+	}
+
+	// Gets the codepoint written to the terminal for a cell's codepoint
+	uint32_m CyTtyCodepoint(uint32_m codepoint) {
+		if (codepoint < 0x20 || (codepoint >= 0x7F && codepoint < 0xA0) || codepoint == TTY_UNKNOWN_CELL) {
+			return TTY_CONTROL_CODEPOINT;
+		}
+		return codepoint;
+	}
+
+	// Gets the amount of bytes it'd take to write a known cell again, or 0
+	// if it can't be (its colors aren't the ones set, or where the cursor
+	// ends up after writing it isn't certain)
+	uint32_m CyTtyRewriteLength(CyTty* tty, CyTtyCell* cell) {
+		if (cell->codepoint == TTY_UNKNOWN_CELL || cell->mark != 0 || !tty->colorsKnown || cell->colors != tty->colors) {
+			return 0;
+		}
+		uint32_m codepoint = CyTtyCodepoint(cell->codepoint);
+		return (codepoint < 0x80) ? 1 : 0;
+	}
+
+	// Gets the amount of bytes it'd take to move the cursor right along row
+	// y from x0 to x1, and whether or not to do it by writing the cells
+	// in between again
+	uint32_m CyTtyForwardLength(CyTty* tty, uint32_m y, uint32_m x0, uint32_m x1, muBool* rewrite) {
+		uint32_m length = CyTtySequenceLength(x1 - x0);
+		*rewrite = MU_FALSE;
+		// Writing the cells again only beats short jumps
+		if (x1 - x0 < length) {
+			CyTtyCell* row = &tty->screen[y * tty->columns];
+			uint32_m rewriteLength = 0;
+			for (uint32_m x = x0; x < x1; ++x) {
+				uint32_m cellLength = CyTtyRewriteLength(tty, &row[x]);
+				if (cellLength == 0) {
+					return length;
+				}
+				rewriteLength += cellLength;
+			}
+			if (rewriteLength < length) {
+				*rewrite = MU_TRUE;
+				return rewriteLength;
+			}
+		}
+		return length;
+	}
+
+	// Gets the amount of bytes it'd take to move the cursor along row y
+	// from x0 to x1, and how to do it; 0 for a jump, 1 for writing the
+	// cells in between again, 2 for a backspace
+	uint32_m CyTtyHorizontalLength(CyTty* tty, uint32_m y, uint32_m x0, uint32_m x1, uint8_m* how) {
+		*how = 0;
+		if (x1 == x0) {
+			return 0;
+		}
+		if (x1 > x0) {
+			muBool rewrite;
+			uint32_m length = CyTtyForwardLength(tty, y, x0, x1, &rewrite);
+			*how = rewrite ? 1 : 0;
+			return length;
+		}
+		if (x0 - x1 == 1) {
+			*how = 2;
+			return 1;
+		}
+		return CyTtySequenceLength(x0 - x1);
+	}
+
+	// Moves the cursor along its row to x, the way CyTtyHorizontalLength
+	// said to
+	void CyTtyMoveHorizontally(CyTty* tty, uint32_m x, uint8_m how) {
+		if (x == tty->cursorX) {
+			return;
+		}
+		if (how == 1) {
+			CyTtyCell* row = &tty->screen[tty->cursorY * tty->columns];
+			for (uint32_m c = tty->cursorX; c < x; ++c) {
+				char byte = (char)CyTtyCodepoint(row[c].codepoint);
+				CyTtyPut(tty, &byte, 1);
+			}
+		} else if (how == 2) {
+			CyTtyPut(tty, "\b", 1);
+		} else if (x > tty->cursorX) {
+			CyTtyPutSequence(tty, x - tty->cursorX, 'C');
+		} else {
+			CyTtyPutSequence(tty, tty->cursorX - x, 'D');
+		}
+		tty->cursorX = x;
+	}
+
+	// Moves the cursor to a cell the cheapest way it can
+	void CyTtyMove(CyTty* tty, uint32_m x, uint32_m y) {
+		if (tty->cursorKnown && tty->cursorX == x && tty->cursorY == y) {
+			return;
+		}
+
+		// Absolute position (CUP); either number is left out if it's 1
+		uint32_m bestLength = 3 + ((y > 0) ? CyTtyDigits(y + 1) : 0) + ((x > 0) ? 1 + CyTtyDigits(x + 1) : 0);
+		// 0 for an absolute position, 1 for moving from where the cursor is,
+		// 2 for a carriage return first, 3 for carriage return line feeds
+		uint8_m best = 0;
+		uint8_m how = 0;
+
+		if (tty->cursorKnown) {
+			// Vertical part; line feeds aren't used on their own, since
+			// the terminal may turn them into carriage return line feeds
+			uint32_m vertical = 0;
+			if (y != tty->cursorY) {
+				vertical = CyTtySequenceLength((y > tty->cursorY) ? y - tty->cursorY : tty->cursorY - y);
+			}
+
+			// From where the cursor is
+			uint8_m h;
+			uint32_m length = vertical + CyTtyHorizontalLength(tty, y, tty->cursorX, x, &h);
+			if (length < bestLength) {
+				bestLength = length;
+				best = 1;
+				how = h;
+			}
+			// From the start of the row
+			length = 1 + vertical + CyTtyHorizontalLength(tty, y, 0, x, &h);
+			if (length < bestLength) {
+				bestLength = length;
+				best = 2;
+				how = h;
+			}
+			// From the start of a row below
+			if (y > tty->cursorY) {
+				length = 2 * (y - tty->cursorY) + CyTtyHorizontalLength(tty, y, 0, x, &h);
+				if (length < bestLength) {
+					bestLength = length;
+					best = 3;
+					how = h;
+				}
+			}
+		}
+
+		if (best == 0) {
+			CyTtyPut(tty, "\x1b[", 2);
+			if (y > 0) {
+				CyTtyPutNumber(tty, y + 1);
+			}
+			if (x > 0) {
+				CyTtyPut(tty, ";", 1);
+				CyTtyPutNumber(tty, x + 1);
+			}
+			CyTtyPut(tty, "H", 1);
+			tty->cursorKnown = MU_TRUE;
+			tty->cursorX = x;
+			tty->cursorY = y;
+			return;
+		}
+
+		if (best == 3) {
+			for (uint32_m r = tty->cursorY; r < y; ++r) {
+				CyTtyPut(tty, "\r\n", 2);
+			}
+			tty->cursorX = 0;
+			tty->cursorY = y;
+		} else {
+			if (best == 2) {
+				CyTtyPut(tty, "\r", 1);
+				tty->cursorX = 0;
+			}
+			if (y > tty->cursorY) {
+				CyTtyPutSequence(tty, y - tty->cursorY, 'B');
+			} else if (y < tty->cursorY) {
+				CyTtyPutSequence(tty, tty->cursorY - y, 'A');
+			}
+			tty->cursorY = y;
+		}
+		CyTtyMoveHorizontally(tty, x, how);
+	}
+
+	// Buffers the parameters that set one of the colors
+	void CyTtyPutColor(CyTty* tty, CyEditorBox* box, uint8_m index, muBool background, uint8_m defaultIndex) {
+		if (index == defaultIndex) {
+			CyTtyPut(tty, background ? "49" : "39", 2);
+			return;
+		}
+		CyTtyPut(tty, background ? "48;2" : "38;2", 4);
+		for (uint8_m i = 0; i < 3; ++i) {
+			float channel = box->palette[index][i];
+			channel = (channel < 0.f) ? 0.f : ((channel > 1.f) ? 1.f : channel);
+			CyTtyPut(tty, ";", 1);
+			CyTtyPutNumber(tty, (uint32_m)((channel * 255.f) + .5f));
+		}
+	}
+
+	// Sets the colors that cells are written with
+	// The default text and background palette indices are left to the
+	// terminal's own colors; the rest are set as true color
+	void CyTtySetColors(CyTty* tty, CyEditorBox* box, uint8_m colors) {
+		if (tty->colorsKnown && tty->colors == colors) {
+			return;
+		}
+
+		uint8_m text = EDITOR_BOX_TEXT(colors);
+		uint8_m background = EDITOR_BOX_BACKGROUND(colors);
+		if (colors == EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR)) {
+			CyTtyPut(tty, "\x1b[m", 3);
+		} else {
+			// Only set what changed
+			muBool setText = !tty->colorsKnown || EDITOR_BOX_TEXT(tty->colors) != text;
+			muBool setBackground = !tty->colorsKnown || EDITOR_BOX_BACKGROUND(tty->colors) != background;
+			CyTtyPut(tty, "\x1b[", 2);
+			if (setText) {
+				CyTtyPutColor(tty, box, text, MU_FALSE, EDITOR_BOX_TEXT_COLOR);
+			}
+			if (setBackground) {
+				if (setText) {
+					CyTtyPut(tty, ";", 1);
+				}
+				CyTtyPutColor(tty, box, background, MU_TRUE, EDITOR_BOX_BACKGROUND_COLOR);
+			}
+			CyTtyPut(tty, "m", 1);
+		}
+		tty->colorsKnown = MU_TRUE;
+		tty->colors = colors;
+	}
+
+	// Writes a codepoint at the cursor
+	void CyTtyPutCodepoint(CyTty* tty, uint32_m codepoint) {
+		muByte bytes[4];
+		uint8_m length = CyCodepointUTF8Encode(CyTtyCodepoint(codepoint), bytes);
+		if (length == 0) {
+			bytes[0] = TTY_CONTROL_CODEPOINT;
+			length = 1;
+		}
+		CyTtyPut(tty, (const char*)bytes, length);
+	}
+
+	// Writes a cell's codepoint at the cursor, followed by its mark, which
+	// the terminal combines with it
+	void CyTtyPutCell(CyTty* tty, CyTtyCell* cell) {
+		CyTtyPutCodepoint(tty, cell->codepoint);
+		if (cell->mark != 0) {
+			CyTtyPutCodepoint(tty, cell->mark);
+		}
+	}
+
+	// Notes that the cursor moved right past written cells
+	// Past the last column, the terminal waits to wrap, and since
+	// terminals don't agree on how moves work from there, the cursor is
+	// taken as unknown; same after anything past ASCII, since terminals
+	// don't agree on how wide it is either
+	void CyTtyAdvance(CyTty* tty, uint32_m x, muBool ascii) {
+		tty->cursorX = x;
+		if (x >= tty->columns || !ascii) {
+			tty->cursorKnown = MU_FALSE;
+		}
+	}
+
+	// Gets the cell that should be shown at a column and row
+	// Cells outside of the box are blank
+	CyTtyCell CyTtyBoxCell(CyEditorBox* box, uint32_m x, uint32_m y) {
+		CyTtyCell cell;
+		if (x < box->textDim[0] && y < box->textDim[1]) {
+			CyEditorBoxSlot* slot = CyGetEditorBoxCell(box, x, y);
+			cell.codepoint = slot->codepoint;
+			cell.mark = slot->mark;
+			cell.colors = slot->colors;
+		} else {
+			cell.codepoint = 0x20;
+			cell.mark = 0;
+			cell.colors = EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR);
+		}
+		return cell;
+	}
+
+	// Returns whether or not two cells show the same thing
+	muBool CyTtyCellsEqual(CyTtyCell a, CyTtyCell b) {
+		return a.codepoint == b.codepoint && a.mark == b.mark && a.colors == b.colors;
+	}
+
+	// Gets a blank cell of the default colors, which is what the terminal
+	// fills cells with when it clears, scrolls or shifts them
+	CyTtyCell CyTtyBlankCell(void) {
+		CyTtyCell cell;
+		cell.codepoint = 0x20;
+		cell.mark = 0;
+		cell.colors = EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR);
+		return cell;
+	}
+
+	// Scrolls the terminal by however many lines the box scrolled since the
+	// last frame, so that the rows still in view don't need writing again
+	// The bottom row is scrolled up with line feeds, and the top row down
+	// with reverse indexes, since every terminal has those
+	void CyScrollTty(CyTty* tty, CyEditorBox* box) {
+		if (!tty->viewKnown || box->leftColumn != tty->leftColumn || box->viewRow == tty->topRow) {
+			return;
+		}
+		muBool down = box->viewRow > tty->topRow;
+		uint32_m lines = down ? box->viewRow - tty->topRow : tty->topRow - box->viewRow;
+		if (lines >= tty->rows) {
+			return;
+		}
+
+		// Scrolled in lines are blanked with the current background
+		CyTtySetColors(tty, box, EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR));
+		uint32_m kept = (tty->rows - lines) * tty->columns;
+		uint32_m blanked = lines * tty->columns;
+		if (down) {
+			CyTtyMove(tty, 0, tty->rows - 1);
+			for (uint32_m l = 0; l < lines; ++l) {
+				CyTtyPut(tty, "\n", 1);
+			}
+			memmove(tty->screen, &tty->screen[blanked], sizeof(CyTtyCell) * kept);
+			for (uint32_m i = kept; i < kept + blanked; ++i) {
+				tty->screen[i] = CyTtyBlankCell();
+			}
+		} else {
+			CyTtyMove(tty, 0, 0);
+			for (uint32_m l = 0; l < lines; ++l) {
+				CyTtyPut(tty, "\x1bM", 2);
+			}
+			memmove(&tty->screen[blanked], tty->screen, sizeof(CyTtyCell) * kept);
+			for (uint32_m i = 0; i < blanked; ++i) {
+				tty->screen[i] = CyTtyBlankCell();
+			}
+		}
+	}
+
+	// Returns whether or not row y of the box is what row from of the
+	// terminal shows
+	muBool CyTtyRowEqual(CyTty* tty, CyEditorBox* box, uint32_m y, uint32_m from) {
+		CyTtyCell* row = &tty->screen[from * tty->columns];
+		for (uint32_m x = 0; x < tty->columns; ++x) {
+			if (!CyTtyCellsEqual(row[x], CyTtyBoxCell(box, x, y))) {
+				return MU_FALSE;
+			}
+		}
+		return MU_TRUE;
+	}
+
+	// Shifts rows down or up, if lines were inserted or deleted in view
+	// Only shifts of up to TTY_SHIFT_MAX lines are looked for, below the
+	// first changed row; the rows shifted in are written after
+	void CyShiftTtyLines(CyTty* tty, CyEditorBox* box) {
+		uint32_m first = 0;
+		while (first < tty->rows && CyTtyRowEqual(tty, box, first, first)) {
+			++first;
+		}
+
+		for (uint32_m shift = 1; shift <= TTY_SHIFT_MAX && first + shift < tty->rows; ++shift) {
+			// Lines inserted; rows [top, rows) were shown shift rows higher
+			uint32_m top = tty->rows;
+			while (top > first + shift && CyTtyRowEqual(tty, box, top - 1, top - 1 - shift)) {
+				--top;
+			}
+			// Rows that are the same either way, like blank ones, don't count
+			uint32_m saved = 0;
+			for (uint32_m y = top; y < tty->rows; ++y) {
+				saved += !CyTtyRowEqual(tty, box, y, y);
+			}
+			muBool insert = MU_TRUE;
+			uint32_m at = top - shift;
+
+			if (saved < TTY_SHIFT_LINES_MIN) {
+				// Lines deleted; rows [top, rows - shift) were shown shift
+				// rows lower
+				top = tty->rows - shift;
+				while (top > first && CyTtyRowEqual(tty, box, top - 1, top - 1 + shift)) {
+					--top;
+				}
+				saved = 0;
+				for (uint32_m y = top; y < tty->rows - shift; ++y) {
+					saved += !CyTtyRowEqual(tty, box, y, y);
+				}
+				if (saved < TTY_SHIFT_LINES_MIN) {
+					continue;
+				}
+				insert = MU_FALSE;
+				at = top;
+			}
+
+			// Rows are shifted in blank with the current background, and the
+			// cursor is taken to the start of the row, as some terminals do
+			CyTtyMove(tty, 0, at);
+			CyTtySetColors(tty, box, EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR));
+			CyTtyPutSequence(tty, shift, insert ? 'L' : 'M');
+			uint32_m moved = (tty->rows - at - shift) * tty->columns;
+			uint32_m blanked = shift * tty->columns;
+			CyTtyCell* from = &tty->screen[at * tty->columns];
+			if (insert) {
+				memmove(&from[blanked], from, sizeof(CyTtyCell) * moved);
+				for (uint32_m i = 0; i < blanked; ++i) {
+					from[i] = CyTtyBlankCell();
+				}
+			} else {
+				memmove(from, &from[blanked], sizeof(CyTtyCell) * moved);
+				for (uint32_m i = moved; i < moved + blanked; ++i) {
+					from[i] = CyTtyBlankCell();
+				}
+			}
+			return;
+		}
+	}
+
+	// Shifts what row y shows along, if that's what changed about it
+	// Only shifts of up to TTY_SHIFT_MAX cells are looked for, starting at
+	// the first changed cell; the cells shifted in are written after
+	void CyShiftTtyRow(CyTty* tty, CyEditorBox* box, uint32_m y) {
+		CyTtyCell* row = &tty->screen[y * tty->columns];
+		uint32_m first = 0;
+		while (first < tty->columns && CyTtyCellsEqual(row[first], CyTtyBoxCell(box, first, y))) {
+			++first;
+		}
+		uint32_m changed = 0;
+		for (uint32_m x = first; x < tty->columns; ++x) {
+			if (!CyTtyCellsEqual(row[x], CyTtyBoxCell(box, x, y))) {
+				++changed;
+			}
+		}
+		if (changed < TTY_SHIFT_MIN) {
+			return;
+		}
+
+		for (uint32_m shift = 1; shift <= TTY_SHIFT_MAX && first + shift < tty->columns; ++shift) {
+			// Cells inserted; everything after them moved right
+			uint32_m x = first + shift;
+			while (x < tty->columns && CyTtyCellsEqual(row[x - shift], CyTtyBoxCell(box, x, y))) {
+				++x;
+			}
+			muBool insert = (x == tty->columns);
+			if (!insert) {
+				// Cells deleted; everything after them moved left
+				x = first;
+				while (x < tty->columns - shift && CyTtyCellsEqual(row[x + shift], CyTtyBoxCell(box, x, y))) {
+					++x;
+				}
+				if (x < tty->columns - shift) {
+					continue;
+				}
+			}
+
+			// Cells are shifted in blank with the current background
+			CyTtyMove(tty, first, y);
+			CyTtySetColors(tty, box, EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR));
+			CyTtyPutSequence(tty, shift, insert ? '@' : 'P');
+			uint32_m moved = tty->columns - first - shift;
+			if (insert) {
+				memmove(&row[first + shift], &row[first], sizeof(CyTtyCell) * moved);
+				for (uint32_m c = first; c < first + shift; ++c) {
+					row[c] = CyTtyBlankCell();
+				}
+			} else {
+				memmove(&row[first], &row[first + shift], sizeof(CyTtyCell) * moved);
+				for (uint32_m c = tty->columns - shift; c < tty->columns; ++c) {
+					row[c] = CyTtyBlankCell();
+				}
+			}
+			return;
+		}
+	}
+
+	// Writes the cells of row y that changed
+	void CyDrawTtyRow(CyTty* tty, CyEditorBox* box, uint32_m y) {
+		CyShiftTtyRow(tty, box, y);
+		CyTtyCell* row = &tty->screen[y * tty->columns];
+		CyTtyCell blank = CyTtyBlankCell();
+
+		// Find where the row turns blank, and how many cells from there on
+		// changed
+		uint32_m blankFrom = tty->columns;
+		while (blankFrom > 0 && CyTtyCellsEqual(CyTtyBoxCell(box, blankFrom - 1, y), blank)) {
+			--blankFrom;
+		}
+		uint32_m changedBlanks = 0;
+		uint32_m firstChangedBlank = tty->columns;
+		for (uint32_m x = blankFrom; x < tty->columns; ++x) {
+			if (!CyTtyCellsEqual(row[x], blank)) {
+				if (changedBlanks == 0) {
+					firstChangedBlank = x;
+				}
+				++changedBlanks;
+			}
+		}
+		// If enough did, they're erased all at once at the end
+		uint32_m end = (changedBlanks >= TTY_CLEAR_MIN) ? blankFrom : tty->columns;
+
+		uint32_m x = 0;
+		while (x < end) {
+			CyTtyCell cell = CyTtyBoxCell(box, x, y);
+			// (Covered cells were written along with the wide codepoint
+			// before them)
+			if (CyTtyCellsEqual(row[x], cell) || cell.codepoint == EDITOR_BOX_COVERED_CELL) {
+				row[x] = cell;
+				++x;
+				continue;
+			}
+
+			CyTtyMove(tty, x, y);
+			CyTtySetColors(tty, box, cell.colors);
+			CyTtyPutCell(tty, &cell);
+			row[x] = cell;
+			uint32_m codepoint = CyTtyCodepoint(cell.codepoint);
+			muBool ascii = codepoint < 0x80 && cell.mark == 0;
+
+			// Repeat the cell over the rest of its run if it's long enough
+			uint32_m run = x + 1;
+			if (TTY_REPEAT_MIN > 0 && ascii) {
+				while (run < end && CyTtyCellsEqual(CyTtyBoxCell(box, run, y), cell)) {
+					++run;
+				}
+				if (run - x >= TTY_REPEAT_MIN) {
+					CyTtyPutSequence(tty, run - x - 1, 'b');
+					for (uint32_m r = x + 1; r < run; ++r) {
+						row[r] = cell;
+					}
+				} else {
+					run = x + 1;
+				}
+			}
+
+			CyTtyAdvance(tty, run, ascii);
+			x = run;
+		}
+
+		// Erase the changed blank end of the row
+		if (end < tty->columns) {
+			CyTtyMove(tty, firstChangedBlank, y);
+			CyTtySetColors(tty, box, blank.colors);
+			CyTtyPut(tty, "\x1b[K", 3);
+			for (uint32_m c = firstChangedBlank; c < tty->columns; ++c) {
+				row[c] = blank;
+			}
+		}
+	}
+
+	// Pushes the input event of a control sequence's final byte, with its
+	// first and second parameter (0 if left out)
+	void CyTtySequenceInput(CyTty* tty, CyInputQueue* queue, muByte final, uint32_m first, uint32_m second) {
+		// The second parameter is 1 plus a bitmask of modifiers; 4 is ctrl
+		muBool ctrl = (second > 1) && (((second - 1) & 4) != 0);
+		switch (final) {
+			default: break;
+			case 'A': CyPushInput(queue, INPUT_UP, 1); break;
+			case 'B': CyPushInput(queue, INPUT_DOWN, 1); break;
+			case 'C': CyPushInput(queue, ctrl ? INPUT_WORD_RIGHT : INPUT_RIGHT, 1); break;
+			case 'D': CyPushInput(queue, ctrl ? INPUT_WORD_LEFT : INPUT_LEFT, 1); break;
+			case 'H': CyPushInput(queue, ctrl ? INPUT_START : INPUT_LINE_START, 1); break;
+			case 'F': CyPushInput(queue, ctrl ? INPUT_END : INPUT_LINE_END, 1); break;
+			case '~': {
+				switch (first) {
+					default: break;
+					case 1: case 7: CyPushInput(queue, ctrl ? INPUT_START : INPUT_LINE_START, 1); break;
+					case 4: case 8: CyPushInput(queue, ctrl ? INPUT_END : INPUT_LINE_END, 1); break;
+					case 5: CyPushInput(queue, INPUT_UP, tty->rows); break;
+					case 6: CyPushInput(queue, INPUT_DOWN, tty->rows); break;
+				}
+			} break;
+		}
+	}
+
+	// Turns the key at the start of data into input events
+	// Returns how many bytes it took up; 0 if the key is cut off
+	uint32_m CyReadTtyKey(CyTty* tty, CyInputQueue* queue, const muByte* data, uint32_m length) {
+		muByte byte = data[0];
+
+		// Escape sequences
+		if (byte == 0x1B) {
+			if (length < 2) {
+				return 0;
+			}
+			// SS3; a single final byte
+			if (data[1] == 'O') {
+				if (length < 3) {
+					return 0;
+				}
+				CyTtySequenceInput(tty, queue, data[2], 0, 0);
+				return 3;
+			}
+			// Anything but CSI is an alt-modified key, which is read as
+			// just the key
+			if (data[1] != '[') {
+				return 1;
+			}
+			// CSI; parameters, then a final byte
+			uint32_m params[2] = { 0, 0 };
+			uint32_m param = 0;
+			for (uint32_m i = 2; i < length; ++i) {
+				if (data[i] >= '0' && data[i] <= '9') {
+					if (param < 2) {
+						params[param] = (params[param] * 10) + (data[i] - '0');
+					}
+				} else if (data[i] == ';') {
+					++param;
+				} else if (data[i] >= 0x40 && data[i] <= 0x7E) {
+					CyTtySequenceInput(tty, queue, data[i], params[0], params[1]);
+					return i + 1;
+				} else if (data[i] < 0x20 || data[i] > 0x3F) {
+					// Not a sequence after all
+					return i;
+				}
+			}
+			// Sequences too long to be kept are dropped
+			return (length < TTY_PENDING_SIZE) ? 0 : length;
+		}
+
+		// Backspace and delete both backspace
+		if (byte == 0x7F || byte == 0x08) {
+			CyPushInput(queue, INPUT_BACKSPACE, 1);
+			return 1;
+		}
+		// Enter sends a carriage return, or a line feed in some modes
+		if (byte == 0x0D || byte == 0x0A) {
+			CyPushInput(queue, INPUT_WRITE, 13);
+			return 1;
+		}
+		if (byte == 0x09) {
+			CyPushInput(queue, INPUT_WRITE, 9);
+			return 1;
+		}
+		// Other controls are ignored
+		if (byte < 0x20) {
+			return 1;
+		}
+		if (byte < 0x80) {
+			CyPushInput(queue, INPUT_WRITE, byte);
+			return 1;
+		}
+
+		// UTF-8; wait for every byte of the codepoint
+		uint32_m needed = (byte >= 0xF0) ? 4 : ((byte >= 0xE0) ? 3 : 2);
+		if (length < needed) {
+			return 0;
+		}
+		uint32_m codepoint = 0;
+		uint8_m decoded = CyUTF8CodepointDecode(&codepoint, (muByte*)data, needed);
+		if (decoded == 0) {
+			return 1;
+		}
+		CyPushInput(queue, INPUT_WRITE, codepoint);
+		return decoded;
+	}
+
+/* Outer */
+
+	// Initializes a terminal
+	muBool CyInitTty(CyTty* tty, FILE* out, uint32_m columns, uint32_m rows) {
+		tty->out = out;
+		tty->columns = columns;
+		tty->rows = rows;
+		tty->screen = (CyTtyCell*)malloc(sizeof(CyTtyCell) * columns * rows);
+		if (!tty->screen) {
+			return MU_FALSE;
+		}
+		tty->cursorShown = MU_TRUE;
+		tty->bufferLength = 0;
+		tty->numPending = 0;
+		tty->frameBytes = 0;
+		tty->totalBytes = 0;
+		tty->frames = 0;
+		CyInvalidateTty(tty);
+		return MU_TRUE;
+	}
+
+	// Destroys a terminal
+	void CyDestroyTty(CyTty* tty) {
+		CyTtyPut(tty, "\x1b[m", 3);
+		if (!tty->cursorShown) {
+			CyTtyPut(tty, "\x1b[?25h", 6);
+		}
+		CyFlushTty(tty);
+		fflush(tty->out);
+		free(tty->screen);
+		tty->screen = 0;
+	}
+
+	// Forgets what's on the terminal
+	void CyInvalidateTty(CyTty* tty) {
+		for (uint32_m i = 0; i < tty->columns * tty->rows; ++i) {
+			tty->screen[i].codepoint = TTY_UNKNOWN_CELL;
+			tty->screen[i].mark = 0;
+		}
+		tty->cursorKnown = MU_FALSE;
+		tty->colorsKnown = MU_FALSE;
+		tty->viewKnown = MU_FALSE;
+	}
+
+	// Writes the cells of an editor box that changed
+	void CyDrawTty(CyTty* tty, CyEditorBox* box) {
+		tty->frameBytes = 0;
+
+		// Start from a clear screen if nothing on it is known
+		if (tty->columns * tty->rows > 0 && tty->screen[0].codepoint == TTY_UNKNOWN_CELL) {
+			CyTtyPut(tty, "\x1b[m\x1b[H\x1b[2J", 10);
+			for (uint32_m i = 0; i < tty->columns * tty->rows; ++i) {
+				tty->screen[i].codepoint = 0x20;
+				tty->screen[i].mark = 0;
+				tty->screen[i].colors = EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR);
+			}
+			tty->cursorKnown = MU_TRUE;
+			tty->cursorX = tty->cursorY = 0;
+			tty->colorsKnown = MU_TRUE;
+			tty->colors = EDITOR_BOX_COLORS(EDITOR_BOX_TEXT_COLOR, EDITOR_BOX_BACKGROUND_COLOR);
+		}
+
+		CyScrollTty(tty, box);
+		CyShiftTtyLines(tty, box);
+		for (uint32_m y = 0; y < tty->rows; ++y) {
+			CyDrawTtyRow(tty, box, y);
+		}
+		tty->viewKnown = MU_TRUE;
+		tty->topRow = box->viewRow;
+		tty->leftColumn = box->leftColumn;
+
+		// Put the cursor where the box's is, hiding it if it's not in view
+		muBool shown = box->cursorVisible && box->cursorCell[0] < tty->columns && box->cursorCell[1] < tty->rows;
+		if (shown) {
+			CyTtyMove(tty, box->cursorCell[0], box->cursorCell[1]);
+		}
+		if (shown != tty->cursorShown) {
+			CyTtyPut(tty, shown ? "\x1b[?25h" : "\x1b[?25l", 6);
+			tty->cursorShown = shown;
+		}
+
+		CyFlushTty(tty);
+		fflush(tty->out);
+		tty->totalBytes += tty->frameBytes;
+		++tty->frames;
+	}
+
+	// Turns bytes read from the terminal into input events
+	void CyReadTtyInput(CyTty* tty, CyInputQueue* queue, const muByte* data, uint32_m length) {
+		uint32_m i = 0;
+
+		// Finish the key left over from last time, a byte at a time
+		while (tty->numPending > 0 && i < length) {
+			tty->pending[tty->numPending++] = data[i++];
+			uint32_m read;
+			while (tty->numPending > 0 && (read = CyReadTtyKey(tty, queue, tty->pending, tty->numPending)) > 0) {
+				tty->numPending -= read;
+				memmove(tty->pending, &tty->pending[read], tty->numPending);
+			}
+		}
+
+		while (i < length) {
+			uint32_m read = CyReadTtyKey(tty, queue, &data[i], length - i);
+			if (read == 0) {
+				// Keep what's cut off for next time
+				tty->numPending = length - i;
+				memcpy(tty->pending, &data[i], tty->numPending);
+				return;
+			}
+			i += read;
+		}
+	}
+
@@ -0,0 +1,413 @@
+// chunkedFile.c
+// Checks a chunked file against a plain array of the same codepoints
+// through random edits, nested transactions and cursor movement, along with
+// the changes passed to listeners, the statistics kept in the chunk index
+// tree and lookups of lines, columns and ranges
+
+// Include files
+#include "editor/textBuffer.h"
+#include "core/string.h"
+#include "core/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+// Amount of random transactions
+#define FUZZ_TRANSACTIONS 5000
+// Most codepoints the file is let grow to
+#define FUZZ_CODEPOINTS 3000
+// Most edits and moves within a transaction
+#define FUZZ_OPERATIONS 24
+// Amount of random lookups checked after each transaction
+#define FUZZ_LOOKUPS 16
+
+CyChunkedFile file;
+// Amount of checks that failed
+uint32_m failures;
+
+// What the file should hold, and where its cursor should be
+uint32_m text[FUZZ_CODEPOINTS + FUZZ_OPERATIONS];
+uint32_m length;
+uint32_m cursor;
+// Text before the current transaction
+uint32_m before[FUZZ_CODEPOINTS + FUZZ_OPERATIONS];
+uint32_m beforeLength;
+
+// Changes passed to the listener since the last check
+uint32_m notifications;
+CyEditRange notified;
+
+// Columns between tab stops
+uint32_m tabWidth = 4;
+
+// Codepoints edits are made with: words, spaces, newlines, tabs,
+// non-ASCII, wide codepoints and marks
+const uint32_m codepoints[] = { 'a', 'Z', '7', '_', ' ', '.', 13, 13, 9, 0xE9, 0x4E00, 0x0301, 0x1F600 };
+
+/* Random */
+
+	uint32_m randomState = 2463534242u;
+
+	// Gets a random number below n (xorshift)
+	uint32_m randomBelow(uint32_m n) {
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState % n;
+	}
+
+/* Checks */
+
+	// Counts a failed check, logging what it was
+	void fail(const char* what, uint32_m transaction, uint32_m got, uint32_m expected) {
+		if (failures < 20) {
+			CyLog("FAILED %s after transaction %" PRIu32 ": got %" PRIu32 ", expected %" PRIu32 "\n", what, transaction, got, expected);
+		}
+		++failures;
+	}
+
+	// Checks that two numbers match
+	void expect(const char* what, uint32_m transaction, uint32_m got, uint32_m expected) {
+		if (got != expected) {
+			fail(what, transaction, got, expected);
+		}
+	}
+
+	// Listener counting the changes committed
+	void onChange(CyChunkedFile* changed, CyEditRange* range, void* data) {
+		++notifications;
+		notified = *range;
+		expect("depth when notified", 0, changed->editDepth, 0);
+	}
+
+	// Whether or not a codepoint at an offset of the array starts a word
+	muBool startsWord(uint32_m offset, uint32_m start) {
+		return CyIsWordCodepoint(text[offset]) && (offset == start || !CyIsWordCodepoint(text[offset-1]));
+	}
+
+	// Gets the column a codepoint of the array starting at the given one ends at
+	uint32_m advanceColumn(uint32_m column, uint32_m codepoint) {
+		if (codepoint == 13) {
+			return 0;
+		}
+		if (codepoint == 9) {
+			return (column / tabWidth + 1) * tabWidth;
+		}
+		return column + CyGetCodepointCells(codepoint);
+	}
+
+	// Checks a chunk's subtree of the index tree, returning its statistics
+	// as counted from its chunks and moving chunk on through the list
+	void checkIndex(CyFileChunk* node, CyFileChunk* parent, CyFileChunk** chunk, uint32_m* prev, CyTextStats* stats, uint32_m transaction) {
+		memset(stats, 0, sizeof(CyTextStats));
+		if (!node) {
+			return;
+		}
+		expect("index parent", transaction, node->parent == parent, 1);
+		expect("index priority", transaction, parent == 0 || node->priority <= parent->priority, 1);
+
+		CyTextStats left, right;
+		checkIndex(node->left, node, chunk, prev, &left, transaction);
+
+		// In order, the tree goes through the chunks as listed
+		expect("index order", transaction, node == *chunk, 1);
+		*chunk = node->next;
+
+		// Chunk's own statistics, with words counted where they start
+		CyTextStats own;
+		memset(&own, 0, sizeof(CyTextStats));
+		for (uint32_m i = 0; i < FILE_CHUNK_CODEPOINTS; ++i) {
+			uint32_m c = node->data[i];
+			if (c == 0) {
+				continue;
+			}
+			++own.codepoints;
+			own.newlines += (c == 13);
+			own.nonASCII += (c > 127);
+			own.words += CyIsWordCodepoint(c) && (*prev == 0 || !CyIsWordCodepoint(*prev));
+			*prev = c;
+		}
+		expect("chunk codepoints", transaction, node->stats.codepoints, own.codepoints);
+		expect("chunk newlines", transaction, node->stats.newlines, own.newlines);
+		expect("chunk words", transaction, node->stats.words, own.words);
+		expect("chunk non-ASCII", transaction, node->stats.nonASCII, own.nonASCII);
+
+		checkIndex(node->right, node, chunk, prev, &right, transaction);
+
+		// Subtree is everything under it
+		stats->codepoints = left.codepoints + own.codepoints + right.codepoints;
+		stats->newlines = left.newlines + own.newlines + right.newlines;
+		stats->words = left.words + own.words + right.words;
+		stats->nonASCII = left.nonASCII + own.nonASCII + right.nonASCII;
+		expect("subtree codepoints", transaction, node->subtree.codepoints, stats->codepoints);
+		expect("subtree newlines", transaction, node->subtree.newlines, stats->newlines);
+		expect("subtree words", transaction, node->subtree.words, stats->words);
+		expect("subtree non-ASCII", transaction, node->subtree.nonASCII, stats->nonASCII);
+	}
+
+	// Checks everything about the file against the array
+	void checkFile(uint32_m transaction) {
+		// Text and cursor
+		uint32_m offset = 0;
+		CyChunkSlot slot;
+		muBool more = CyGetFirstSlotInChunkedFile(&file, &slot);
+		while (more && offset < length) {
+			if (slot.codepoint != text[offset]) {
+				fail("codepoint", transaction, slot.codepoint, text[offset]);
+				break;
+			}
+			++offset;
+			more = CyGetNextSlotInChunkedFile(&slot);
+		}
+		expect("text ends", transaction, more ? offset + 1 : offset, length);
+		expect("cursor", transaction, file.cursorOffset, cursor);
+
+		// Index tree
+		CyFileChunk* chunk = file.chunks;
+		uint32_m prev = 0;
+		CyTextStats subtree;
+		checkIndex(file.root, 0, &chunk, &prev, &subtree, transaction);
+		expect("index covers every chunk", transaction, chunk == 0, 1);
+
+		// Statistics of the whole file, and of its last line's columns
+		CyTextStats stats;
+		memset(&stats, 0, sizeof(CyTextStats));
+		uint32_m column = 0;
+		for (uint32_m i = 0; i < length; ++i) {
+			stats.newlines += (text[i] == 13);
+			stats.nonASCII += (text[i] > 127);
+			stats.words += startsWord(i, 0);
+			column = advanceColumn(column, text[i]);
+		}
+		CyTextStats got;
+		CyGetChunkedFileStats(&file, &got);
+		expect("codepoints", transaction, got.codepoints, length);
+		expect("newlines", transaction, got.newlines, stats.newlines);
+		expect("words", transaction, got.words, stats.words);
+		expect("non-ASCII", transaction, got.nonASCII, stats.nonASCII);
+		expect("column of the end", transaction, CyGetColumnOfOffsetInChunkedFile(&file, length), column);
+
+		// Random lookups
+		for (uint32_m l = 0; l < FUZZ_LOOKUPS; ++l) {
+			// Range statistics
+			uint32_m start = randomBelow(length + 1);
+			uint32_m end = start + randomBelow(length - start + 1);
+			memset(&stats, 0, sizeof(CyTextStats));
+			for (uint32_m i = start; i < end; ++i) {
+				stats.newlines += (text[i] == 13);
+				stats.nonASCII += (text[i] > 127);
+				stats.words += startsWord(i, start);
+			}
+			CyGetChunkedFileRangeStats(&file, start, end, &got);
+			expect("range codepoints", transaction, got.codepoints, end - start);
+			expect("range newlines", transaction, got.newlines, stats.newlines);
+			expect("range words", transaction, got.words, stats.words);
+			expect("range non-ASCII", transaction, got.nonASCII, stats.nonASCII);
+
+			// Line and column of an offset
+			uint32_m line = 0;
+			uint32_m lineStart = 0;
+			column = 0;
+			for (uint32_m i = 0; i < start; ++i) {
+				if (text[i] == 13) {
+					++line;
+					lineStart = i + 1;
+				}
+				column = advanceColumn(column, text[i]);
+			}
+			expect("line of offset", transaction, CyGetLineOfOffsetInChunkedFile(&file, start), line);
+			expect("column of offset", transaction, CyGetColumnOfOffsetInChunkedFile(&file, start), column);
+			expect("line start", transaction, CyGetLineStartInChunkedFile(&file, line), lineStart);
+			uint32_m lineEnd = start;
+			while (lineEnd < length && text[lineEnd] != 13) {
+				++lineEnd;
+			}
+			expect("line end", transaction, CyGetLineEndInChunkedFile(&file, line), lineEnd);
+
+			// Slot at an offset
+			if (start < length) {
+				expect("slot at offset", transaction, CyGetSlotAtOffsetInChunkedFile(&file, start, &slot) ? slot.codepoint : 0, text[start]);
+			}
+		}
+
+		// Lines past the last clamp to it
+		expect("line end past the last", transaction, CyGetLineEndInChunkedFile(&file, 0xFFFFFFFF), length);
+		uint32_m lastStart = length;
+		while (lastStart > 0 && text[lastStart-1] != 13) {
+			--lastStart;
+		}
+		expect("line start past the last", transaction, CyGetLineStartInChunkedFile(&file, 0xFFFFFFFF), lastStart);
+	}
+
+	// Checks the change passed for a committed transaction, which should
+	// turn the text before it into the text after it
+	void checkChange(uint32_m transaction) {
+		CyEditRange* range = &notified;
+		if (range->offset + range->removed > beforeLength || range->offset + range->inserted > length
+			|| beforeLength - range->removed != length - range->inserted
+		) {
+			fail("change range", transaction, range->offset, beforeLength);
+			return;
+		}
+		uint32_m after = beforeLength - range->offset - range->removed;
+		expect("change prefix", transaction, memcmp(before, text, range->offset * sizeof(uint32_m)) == 0, 1);
+		expect("change suffix", transaction, memcmp(
+			before + range->offset + range->removed, text + range->offset + range->inserted, after * sizeof(uint32_m)
+		) == 0, 1);
+	}
+
+/* Operations */
+
+	// Makes a random edit or move, applying it to the array too
+	// Returns whether or not the text changed
+	muBool randomOperation(void) {
+		switch (randomBelow(10)) {
+			// Writes a codepoint
+			default: {
+				if (length >= FUZZ_CODEPOINTS) {
+					return MU_FALSE;
+				}
+				uint32_m codepoint = codepoints[randomBelow(sizeof(codepoints) / sizeof(uint32_m))];
+				CyWriteCodepointInChunkedFile(&file, codepoint);
+				memmove(text + cursor + 1, text + cursor, (length - cursor) * sizeof(uint32_m));
+				text[cursor++] = codepoint;
+				++length;
+				return MU_TRUE;
+			}
+
+			// Inserts (overwrites) a codepoint; it's only written in front of
+			// newlines, for newlines and tabs, and at empty slots
+			case 0: {
+				if (length >= FUZZ_CODEPOINTS) {
+					return MU_FALSE;
+				}
+				uint32_m codepoint = codepoints[randomBelow(sizeof(codepoints) / sizeof(uint32_m))];
+				uint32_m at = file.cursorChunk->data[file.cursorIndex];
+				CyInsertCodepointInChunkedFile(&file, codepoint);
+				if (at != 0 && at != 13 && codepoint != 13 && codepoint != 9) {
+					text[cursor++] = codepoint;
+				} else {
+					memmove(text + cursor + 1, text + cursor, (length - cursor) * sizeof(uint32_m));
+					text[cursor++] = codepoint;
+					++length;
+				}
+				return MU_TRUE;
+			}
+
+			// Backspaces a few codepoints
+			case 1: case 2: {
+				muBool changed = MU_FALSE;
+				for (uint32_m n = randomBelow(4); n > 0; --n) {
+					CyBackspaceCodepointInChunkedFile(&file);
+					if (cursor > 0) {
+						memmove(text + cursor - 1, text + cursor, (length - cursor) * sizeof(uint32_m));
+						--cursor;
+						--length;
+						changed = MU_TRUE;
+					}
+				}
+				return changed;
+			}
+
+			// Moves the cursor somewhere
+			case 3: {
+				cursor = randomBelow(length + 1);
+				CySetCursorInChunkedFile(&file, cursor);
+				return MU_FALSE;
+			}
+			case 4: {
+				uint32_m n = randomBelow(20);
+				CyMoveLeftInChunkedFile(&file, n);
+				cursor = (cursor > n) ? cursor - n : 0;
+				return MU_FALSE;
+			}
+			case 5: {
+				uint32_m n = randomBelow(20);
+				CyMoveRightInChunkedFile(&file, n);
+				cursor = (length - cursor > n) ? cursor + n : length;
+				return MU_FALSE;
+			}
+		}
+	}
+
+	// Runs a random transaction, nesting more within it
+	// Returns whether or not the text changed
+	muBool randomTransaction(uint32_m depth, muBool cursorOnly, uint32_m transaction) {
+		muBool changed = MU_FALSE;
+		CyBeginEdit(&file);
+		for (uint32_m o = randomBelow(FUZZ_OPERATIONS); o > 0; --o) {
+			if (depth < 4 && randomBelow(8) == 0) {
+				changed |= randomTransaction(depth + 1, cursorOnly, transaction);
+			}
+			else if (cursorOnly) {
+				cursor = randomBelow(length + 1);
+				CySetCursorInChunkedFile(&file, cursor);
+			}
+			else {
+				changed |= randomOperation();
+			}
+		}
+		CyCommitEdit(&file);
+
+		// Nothing's notified until the outermost commit
+		if (depth != 0) {
+			expect("notifications within a transaction", transaction, notifications, 0);
+		}
+		return changed;
+	}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (chunkedFile.c) ==\n\n");
+
+	if (!CyCreateEmptyChunkedFile(&file)) {
+		CyLog("Failed to allocate chunked file; exiting\n");
+		return -1;
+	}
+	CySetChunkedFileTabWidth(&file, tabWidth);
+	CyAddChunkedFileListener(&file, onChange, 0);
+
+	for (uint32_m t = 0; t < FUZZ_TRANSACTIONS && failures == 0; ++t) {
+		memcpy(before, text, length * sizeof(uint32_m));
+		beforeLength = length;
+		uint32_m version = file.version;
+		notifications = 0;
+
+		// Every so often, only move the cursor, or change the tab width
+		if (randomBelow(50) == 0) {
+			tabWidth = 1 + randomBelow(8);
+			CySetChunkedFileTabWidth(&file, tabWidth);
+		}
+		muBool cursorOnly = randomBelow(5) == 0;
+		muBool changed = randomTransaction(0, cursorOnly, t);
+
+		// Committed changes are notified once, and cursor moves never
+		expect("notifications", t, notifications, changed ? 1 : 0);
+		expect("version", t, file.version, version + notifications);
+		if (notifications == 1) {
+			checkChange(t);
+		}
+		checkFile(t);
+
+		// Edits made outside of a transaction are notified on their own
+		if (length < FUZZ_CODEPOINTS && randomBelow(10) == 0) {
+			notifications = 0;
+			memcpy(before, text, length * sizeof(uint32_m));
+			beforeLength = length;
+			CyWriteCodepointInChunkedFile(&file, 'q');
+			memmove(text + cursor + 1, text + cursor, (length - cursor) * sizeof(uint32_m));
+			text[cursor++] = 'q';
+			++length;
+			expect("notifications outside of a transaction", t, notifications, 1);
+			checkChange(t);
+		}
+	}
+
+	CyDestroyChunkedFile(&file);
+	if (failures != 0) {
+		CyLog("%" PRIu32 " checks failed\n", failures);
+		return -1;
+	}
+	CyLog("Successful\n");
+	return 0;
+}
+
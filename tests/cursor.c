@@ -0,0 +1,103 @@
+// cursor.c
+// Tests moving the cursor up and down through lines with tabs, wide
+// codepoints and combining marks, checking that it keeps the column as
+// shown and never lands within a grapheme cluster
+
+// Include files
+#include "editor/textBuffer.h"
+#include "core/log.h"
+
+#include <inttypes.h>
+
+CyChunkedFile file;
+// Amount of checks that failed
+uint32_m failures;
+
+// Replaces the file's text with the given codepoints, ending at 0
+void setText(const uint32_m* codepoints) {
+	CyBeginEdit(&file);
+	CyMoveToEndInChunkedFile(&file);
+	while (file.cursorOffset > 0) {
+		CyBackspaceCodepointInChunkedFile(&file);
+	}
+	for (uint32_m c = 0; codepoints[c] != 0; ++c) {
+		CyWriteCodepointInChunkedFile(&file, codepoints[c]);
+	}
+	CyCommitEdit(&file);
+}
+
+// Checks that the cursor is at an offset
+void expectCursor(const char* name, uint32_m offset) {
+	if (file.cursorOffset != offset) {
+		CyLog("FAILED %s: cursor at %" PRIu32 ", expected %" PRIu32 "\n", name, file.cursorOffset, offset);
+		++failures;
+	}
+}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (cursor.c) ==\n\n");
+
+	if (!CyCreateEmptyChunkedFile(&file)) {
+		CyLog("Failed to allocate chunked file; exiting\n");
+		return -1;
+	}
+
+	// Onto a combining mark: column 1 is after the whole cluster
+	const uint32_m marks[] = { 'a', 'b', 'c', 13, 'e', 0x0301, 'x', 13, 'a', 'b', 'c', 0 };
+	setText(marks);
+	CySetCursorInChunkedFile(&file, 1);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down onto a mark", 6);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down off of a mark", 9);
+
+	// A flag is a cluster of two narrow codepoints, so column 1 is within it
+	const uint32_m flags[] = { 'a', 'b', 'c', 13, 0x1F1EF, 0x1F1F5, 'x', 0 };
+	setText(flags);
+	CySetCursorInChunkedFile(&file, 1);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down within a flag", 4);
+
+	// Tabs are expanded, and landing within one lands before it
+	CySetChunkedFileTabWidth(&file, 4);
+	const uint32_m tabs[] = { 0x09, 'X', 13, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 13, 'a', 0x09, 'Y', 0 };
+	setText(tabs);
+	CySetCursorInChunkedFile(&file, 2);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down past a tab", 8);
+	CySetCursorInChunkedFile(&file, 5);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down within a tab", 12);
+	CyMoveUpInChunkedFile(&file, 2);
+	expectCursor("up within a tab, keeping the column", 0);
+
+	// Wide codepoints take up two columns
+	const uint32_m wide[] = { 0x4E00, 0x4E01, 13, 'a', 'b', 'c', 'd', 'e', 13, 0x4E02, 0x4E03, 0x4E04, 0 };
+	setText(wide);
+	CySetCursorInChunkedFile(&file, 2);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down past wide codepoints", 7);
+	CySetCursorInChunkedFile(&file, 6);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down within a wide codepoint", 10);
+
+	// The column sticks through shorter lines
+	const uint32_m sticky[] = { 'a', 'b', 'c', 'd', 'e', 'f', 13, 0x4E00, 13, 0x09, 'a', 'b', 0 };
+	setText(sticky);
+	CySetCursorInChunkedFile(&file, 5);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down onto a short line", 8);
+	CyMoveDownInChunkedFile(&file, 1);
+	expectCursor("down back to the sticky column", 11);
+	CyMoveUpInChunkedFile(&file, 2);
+	expectCursor("up back to the sticky column", 5);
+
+	CyDestroyChunkedFile(&file);
+	if (failures != 0) {
+		CyLog("%" PRIu32 " checks failed\n", failures);
+		return -1;
+	}
+	CyLog("Successful\n");
+	return 0;
+}
+
@@ -0,0 +1,325 @@
+// headless.c
+// Benchmarks refreshing and rendering an editor box on the headless gfx
+// backend, so it runs without a display
+
+// Include files
+#include "core/gfx.h"
+#include "core/string.h"
+#include "editor/visualBuffer.h"
+
+#include <inttypes.h>
+
+// Size of the imaginary window
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+// Amount of lines in the benchmarked file
+#define BENCH_LINES 20000
+// Amount of frames each benchmark runs for
+#define BENCH_FRAMES 2000
+// Codepoints of the single very long line benchmarked
+#define BENCH_LONG_LINE 2000000
+// Amount of lines of wide and combining text
+#define BENCH_WIDE_LINES 1000
+
+CyEditorBox box;
+
+// Time spent refreshing and rendering over a benchmark, in seconds
+double refreshSeconds;
+double renderSeconds;
+
+// Refreshes the box, timing it
+void refreshBox(void) {
+	double start = CyGfxTime();
+	CyRefreshEditorBox(&box);
+	refreshSeconds += CyGfxTime() - start;
+}
+
+// Resizes the box, timing it along with refreshing
+void resizeBox(float width, float height) {
+	double start = CyGfxTime();
+	CyResizeEditorBox(&box, width, height);
+	refreshSeconds += CyGfxTime() - start;
+}
+
+// Draws a frame of the box, timing it
+void renderBox(void) {
+	double start = CyGfxTime();
+	CyGfxClear();
+	CyRenderEditorBox(&box);
+	CyGfxPresent();
+	renderSeconds += CyGfxTime() - start;
+}
+
+// Starts a benchmark
+void beginBenchmark(void) {
+	refreshSeconds = renderSeconds = 0.0;
+	CyGfxResetRecord();
+}
+
+// Logs what a benchmark did, per frame
+void endBenchmark(const char* name) {
+	double frames = (double)BENCH_FRAMES;
+	CyLog("%s (%d frames):\n", name, BENCH_FRAMES);
+	CyLog("  refresh %8.4f ms, render %8.4f ms\n", (refreshSeconds * 1000.0) / frames, (renderSeconds * 1000.0) / frames);
+	CyLog("  fills %8.2f, renders %8.2f, shifts %8.2f, buffers created %8.4f\n",
+		(double)gfx_record.counts[GFX_COMMAND_FILL_OBJECTS] / frames,
+		(double)gfx_record.counts[GFX_COMMAND_RENDER_OBJECTS] / frames,
+		(double)gfx_record.counts[GFX_COMMAND_SHIFT_OBJECTS] / frames,
+		(double)gfx_record.counts[GFX_COMMAND_CREATE_OBJECTS] / frames
+	);
+	CyLog("  bytes uploaded %10.1f, objects rendered %10.1f\n",
+		(double)gfx_record.uploadBytes / frames, (double)gfx_record.renderedObjects / frames
+	);
+	CyLog("\n");
+}
+
+// Checks that a wide codepoint cut off by the end of a wrapped row goes
+// on the next row, with a space left at the end of the one before it
+// Returns false if it doesn't
+muBool checkWrappedWide(void) {
+	CyEditorBox narrow;
+	if (!CyInitEditorBox(&narrow, &textFont, (17.f * textFont.pAdvanceWidth) + .5f, (4.f * textFont.pHeight) + .5f)) {
+		return MU_FALSE;
+	}
+	CySetEditorBoxWrap(&narrow, MU_TRUE);
+
+	// 16 narrow codepoints leave one column for a wide one
+	CyBeginEdit(&narrow.file);
+	for (uint32_m c = 0; c < 16; ++c) {
+		CyWriteCodepointInChunkedFile(&narrow.file, 'a');
+	}
+	CyWriteCodepointInChunkedFile(&narrow.file, 0x4E2D);
+	CyWriteCodepointInChunkedFile(&narrow.file, 'b');
+	CySetCursorInChunkedFile(&narrow.file, 16);
+	CyCommitEdit(&narrow.file);
+	CyRefreshEditorBox(&narrow);
+
+	muBool laidOut = narrow.textDim[0] == 17
+		&& CyGetEditorBoxCell(&narrow, 15, 0)->codepoint == 'a'
+		&& CyGetEditorBoxCell(&narrow, 16, 0)->codepoint == 0x20
+		&& CyGetEditorBoxCell(&narrow, 0, 1)->codepoint == 0x4E2D
+		&& CyGetEditorBoxCell(&narrow, 1, 1)->codepoint == EDITOR_BOX_COVERED_CELL
+		&& CyGetEditorBoxCell(&narrow, 2, 1)->codepoint == 'b'
+		&& narrow.cursorVisible && narrow.cursorCell[0] == 0 && narrow.cursorCell[1] == 1;
+	CyDestroyEditorBox(&narrow);
+	return laidOut;
+}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (headless.c) ==\n\n");
+
+	// Init. stuff
+	CyGfxInitHeadless(BENCH_WIDTH, BENCH_HEIGHT);
+	CyLoadRequiredFonts();
+
+	CyLog("Initializing point size to 16...\n");
+	CySetFontPointSize(&textFont, 16.f);
+
+	CyLog("Getting basic codepoints...\n");
+	if (!CyFontLoadCodepoint(&textFont, 0x20)) {
+		CyLog("Failed to get space codepoint; exiting\n");
+		return -1;
+	}
+	if (!CyFontLoadCodepoint(&textFont, 0x25A1)) {
+		CyLog("Failed to get missing codepoint; exiting\n");
+		return -1;
+	}
+	CyLog("\n");
+
+	// Create editor box
+	CyLog("Creating editor box\n");
+	if (!CyInitEditorBox(&box, &textFont, wininfo.width, wininfo.height)) {
+		CyLog("Failed to create editor box; exiting\n");
+		return -1;
+	}
+
+	// Fill the file with lines of varying length
+	CyLog("Writing %d lines...\n", BENCH_LINES);
+	const char* words = "the quick brown fox jumps over the lazy dog while minCy keeps up ";
+	CyBeginEdit(&box.file);
+	for (uint32_m l = 0; l < BENCH_LINES; ++l) {
+		uint32_m length = (l * 7) % 90;
+		for (uint32_m c = 0; c < length; ++c) {
+			CyWriteCodepointInChunkedFile(&box.file, (uint8_m)words[(l + c) % 65]);
+		}
+		CyWriteCodepointInChunkedFile(&box.file, 13);
+	}
+	CyMoveToStartInChunkedFile(&box.file);
+	CyCommitEdit(&box.file);
+	refreshBox();
+	CyLog("\n");
+
+	// Scroll smoothly through the file, a third of a line per frame
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		if (CyScrollEditorBox(&box, textFont.pHeight / 3.f)) {
+			refreshBox();
+		}
+		renderBox();
+	}
+	endBenchmark("Smooth scrolling");
+
+	// Jump a page down each frame
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		CySetEditorBoxView(&box, (f * box.textDim[1]) % BENCH_LINES, 0);
+		refreshBox();
+		renderBox();
+	}
+	endBenchmark("Paging");
+
+	// Type at the top of the view, one codepoint per frame
+	CySetEditorBoxView(&box, 0, 0);
+	CyMoveToStartInChunkedFile(&box.file);
+	refreshBox();
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		CyBeginEdit(&box.file);
+		if (f % 40 == 39) {
+			CyInsertCodepointInChunkedFile(&box.file, 13);
+		} else {
+			CyInsertCodepointInChunkedFile(&box.file, (uint8_m)words[f % 65]);
+		}
+		CyCommitEdit(&box.file);
+		refreshBox();
+		renderBox();
+	}
+	endBenchmark("Typing");
+
+	// Drag the window's corner in and out, a few pixels per frame
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		uint32_m step = f % 400;
+		float inward = (float)((step < 200) ? step : 400 - step);
+		resizeBox(BENCH_WIDTH - (inward * 6.f), BENCH_HEIGHT - (inward * 4.f));
+		refreshBox();
+		renderBox();
+	}
+	endBenchmark("Resizing");
+
+	// Scroll smoothly through the file again with line numbers; only the
+	// gutter rows scrolled into view are drawn
+	CySetEditorBoxGutter(&box, MU_TRUE);
+	CySetEditorBoxView(&box, 0, 0);
+	refreshBox();
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		if (CyScrollEditorBox(&box, textFont.pHeight / 3.f)) {
+			refreshBox();
+		}
+		renderBox();
+	}
+	endBenchmark("Smooth scrolling, line numbers");
+	CySetEditorBoxGutter(&box, MU_FALSE);
+
+	// Scroll smoothly through the file again with lines wrapped in a box
+	// too narrow for them; the rows of each line are worked out as they
+	// come into view
+	CySetEditorBoxWrap(&box, MU_TRUE);
+	CySetEditorBoxView(&box, 0, 0);
+	resizeBox(BENCH_WIDTH / 4, BENCH_HEIGHT);
+	refreshBox();
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		if (CyScrollEditorBox(&box, textFont.pHeight / 3.f)) {
+			refreshBox();
+		}
+		renderBox();
+	}
+	endBenchmark("Smooth scrolling, wrapped");
+
+	// Rewrap every line at a new width, like when idle after a resize
+	resizeBox(BENCH_WIDTH / 3, BENCH_HEIGHT);
+	double start = CyGfxTime();
+	uint32_m passes = 1;
+	while (!CyRewrapEditorBox(&box, 4096)) {
+		++passes;
+	}
+	CyLog("Rewrapping %d lines: %8.4f ms over %" PRIu32 " passes\n\n", BENCH_LINES, (CyGfxTime() - start) * 1000.0, passes);
+
+	// Put a very long line, like minified JSON, at the top of the file
+	CyLog("Writing a line of %d codepoints...\n\n", BENCH_LONG_LINE);
+	CySetEditorBoxWrap(&box, MU_FALSE);
+	resizeBox(BENCH_WIDTH, BENCH_HEIGHT);
+	CyBeginEdit(&box.file);
+	CyMoveToStartInChunkedFile(&box.file);
+	for (uint32_m c = 0; c < BENCH_LONG_LINE; ++c) {
+		CyInsertCodepointInChunkedFile(&box.file, (c % 50 == 49) ? 0x09 : (uint8_m)words[c % 65]);
+	}
+	CyInsertCodepointInChunkedFile(&box.file, 13);
+	CyCommitEdit(&box.file);
+
+	// Scroll sideways through the middle of it, a few columns per frame;
+	// only the columns in view are laid out
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		CySetEditorBoxView(&box, 0, (BENCH_LONG_LINE / 2) + (f * 3));
+		refreshBox();
+		renderBox();
+	}
+	endBenchmark("Scrolling sideways through a long line");
+
+	// Type in the middle of it
+	CySetCursorInChunkedFile(&box.file, BENCH_LONG_LINE / 2);
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		CyBeginEdit(&box.file);
+		CyInsertCodepointInChunkedFile(&box.file, (uint8_m)words[f % 65]);
+		CyCommitEdit(&box.file);
+		CyScrollEditorBoxToCursor(&box);
+		refreshBox();
+		renderBox();
+	}
+	endBenchmark("Typing in a long line");
+
+	// Put lines of CJK and accented text at the top of the file; wide
+	// codepoints take up two cells, and marks combine with the cell before
+	CyLog("Writing %d lines of wide and combining text...\n\n", BENCH_WIDE_LINES);
+	CySetEditorBoxView(&box, 0, 0);
+	CyBeginEdit(&box.file);
+	CyMoveToStartInChunkedFile(&box.file);
+	for (uint32_m l = 0; l < BENCH_WIDE_LINES; ++l) {
+		uint32_m length = (l * 7) % 90;
+		for (uint32_m c = 0; c < length; ++c) {
+			if (c % 3 == 0) {
+				CyInsertCodepointInChunkedFile(&box.file, 0x4E00 + ((l + c) % 512));
+				continue;
+			}
+			CyInsertCodepointInChunkedFile(&box.file, (uint8_m)words[(l + c) % 65]);
+			if (c % 5 == 1) {
+				CyInsertCodepointInChunkedFile(&box.file, 0x0301);
+			}
+		}
+		CyInsertCodepointInChunkedFile(&box.file, 13);
+	}
+	CyCommitEdit(&box.file);
+
+	// Scroll smoothly through them
+	beginBenchmark();
+	for (uint32_m f = 0; f < BENCH_FRAMES; ++f) {
+		if (CyScrollEditorBox(&box, textFont.pHeight / 3.f)) {
+			refreshBox();
+		}
+		renderBox();
+	}
+	endBenchmark("Smooth scrolling, wide and combining text");
+
+	// Wide codepoints at the end of a wrapped row
+	if (!checkWrappedWide()) {
+		CyLog("Wide codepoint at the end of a wrapped row wasn't moved to the next; exiting\n");
+		return -1;
+	}
+	CyLog("Wide codepoint at the end of a wrapped row moved to the next\n\n");
+
+	// Destroy editor box
+	CyLog("Destroying editor box...\n");
+	CyDestroyEditorBox(&box);
+
+	// Destroy stuff
+	CyDeloadRequiredFonts();
+	CyGfxTerm();
+
+	CyLog("Successful\n");
+	return 0;
+}
+
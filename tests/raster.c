@@ -0,0 +1,236 @@
+// raster.c
+// Tests the software rasterizer by drawing a full screen of text on the
+// headless gfx backend, timing it, and writing it to a PPM file
+// Fails if typing redraws tiles away from what it changed, if a combining
+// mark isn't drawn over the codepoint before it, if an unchanged frame
+// redraws anything, or if redrawing only some tiles comes out any
+// different from redrawing all of them
+
+// Include files
+#include "core/gfx.h"
+#include "editor/visualBuffer.h"
+#include "rendering/raster.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the framebuffer
+#define RASTER_WIDTH 1920
+#define RASTER_HEIGHT 1080
+// Amount of times each benchmark is run
+#define RASTER_FRAMES 200
+// File that the last frame is written to
+#define RASTER_PPM "raster.ppm"
+// Amount of tiles in the framebuffer
+#define RASTER_TILES (((RASTER_WIDTH + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE) * ((RASTER_HEIGHT + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE))
+
+CyEditorBox box;
+CyRaster raster;
+// Rasterizer redrawing every tile of every frame checked, to compare with
+CyRaster reference;
+// Amount of checks that failed
+uint32_m failures;
+
+// Draws a frame of the box on the headless backend and rasterizes it
+void drawFrame(void) {
+	CyGfxClear();
+	CyRenderEditorBox(&box);
+	CyGfxPresent();
+	CyRasterizeFrame(&raster);
+}
+
+// Checks that the last frame drawn matches drawing it from scratch
+void checkFrame(const char* name) {
+	CyInvalidateRaster(&reference);
+	CyRasterizeFrame(&reference);
+	if (memcmp(raster.pixels, reference.pixels, RASTER_WIDTH * RASTER_HEIGHT * 4) != 0) {
+		CyLog("FAILED %s: frame differs from redrawing every tile\n", name);
+		++failures;
+	}
+}
+
+// Checks that the tiles redrawn last frame are all within the given tile
+// rows and from the given tile column on, given what was drawn over each
+// tile the frame before
+void checkDirtyTiles(const char* name, uint64_m* lastHashes, uint32_m firstColumn, uint32_m firstRow, uint32_m lastRow) {
+	uint32_m changed = 0;
+	for (uint32_m t = 0; t < raster.tilesX * raster.tilesY; ++t) {
+		if (raster.tileHashes[t] == lastHashes[t]) {
+			continue;
+		}
+		++changed;
+		uint32_m x = t % raster.tilesX;
+		uint32_m y = t / raster.tilesX;
+		if (x < firstColumn || y < firstRow || y > lastRow) {
+			CyLog("FAILED %s: tile (%" PRIu32 ", %" PRIu32 ") was redrawn\n", name, x, y);
+			++failures;
+			return;
+		}
+	}
+	uint32_m expected = (raster.tilesX - firstColumn) * (lastRow - firstRow + 1);
+	if (raster.dirtyTiles != changed || raster.dirtyTiles > expected) {
+		CyLog("FAILED %s: %" PRIu32 " tiles redrawn, %" PRIu32 " changed, expected at most %" PRIu32 "\n", name, raster.dirtyTiles, changed, expected);
+		++failures;
+	}
+}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (raster.c) ==\n\n");
+
+	// Init. stuff
+	CyGfxInitHeadless(RASTER_WIDTH, RASTER_HEIGHT);
+	CyLoadRequiredFonts();
+
+	CyLog("Initializing point size to 16...\n");
+	CySetFontPointSize(&textFont, 16.f);
+
+	CyLog("Getting basic codepoints...\n");
+	if (!CyFontLoadCodepoint(&textFont, 0x20)) {
+		CyLog("Failed to get space codepoint; exiting\n");
+		return -1;
+	}
+	if (!CyFontLoadCodepoint(&textFont, 0x25A1)) {
+		CyLog("Failed to get missing codepoint; exiting\n");
+		return -1;
+	}
+	CyLog("\n");
+
+	// Create editor box and rasterizer
+	CyLog("Creating editor box\n");
+	if (!CyInitEditorBox(&box, &textFont, wininfo.width, wininfo.height)) {
+		CyLog("Failed to create editor box; exiting\n");
+		return -1;
+	}
+	CyLog("Creating %dx%d rasterizer\n", RASTER_WIDTH, RASTER_HEIGHT);
+	if (!CyInitRaster(&raster, RASTER_WIDTH, RASTER_HEIGHT) || !CyInitRaster(&reference, RASTER_WIDTH, RASTER_HEIGHT)) {
+		CyLog("Failed to create rasterizer; exiting\n");
+		return -1;
+	}
+
+	// Fill every cell of the screen with text
+	CyLog("Filling the screen (%" PRIu32 "x%" PRIu32 " cells)...\n", box.textDim[0], box.textDim[1]);
+	CyBeginEdit(&box.file);
+	for (uint32_m r = 0; r < box.textDim[1]; ++r) {
+		for (uint32_m c = 0; c < box.textDim[0]; ++c) {
+			CyWriteCodepointInChunkedFile(&box.file, 0x21 + ((r + c) % 94));
+		}
+		CyWriteCodepointInChunkedFile(&box.file, 13);
+	}
+	CyMoveToStartInChunkedFile(&box.file);
+	CyCommitEdit(&box.file);
+	CyRefreshEditorBox(&box);
+	CyLog("\n");
+
+	// Redraw the entire screen each frame
+	double seconds = 0.0;
+	for (uint32_m f = 0; f < RASTER_FRAMES; ++f) {
+		CyInvalidateRaster(&raster);
+		drawFrame();
+		seconds += raster.seconds;
+	}
+	CyLog("Full screen: %8.4f ms per frame (%" PRIu32 " tiles, %" PRIu32 " items drawn, %" PRIu32 " skipped)\n",
+		(seconds * 1000.0) / RASTER_FRAMES, raster.dirtyTiles, raster.drawnItems, raster.skippedObjects
+	);
+
+	// Type at the cursor each frame, only redrawing what changed
+	// Typing shifts the rest of the cursor's line over and moves the cursor,
+	// so nothing should be redrawn before where the cursor was or outside of
+	// its row (the box is at the top left, unscrolled)
+	seconds = 0.0;
+	uint64_m dirtyTiles = 0;
+	uint64_m lastHashes[RASTER_TILES];
+	for (uint32_m f = 0; f < RASTER_FRAMES; ++f) {
+		float left = (float)box.cursorCell[0] * textFont.pAdvanceWidth;
+		float top = (float)box.cursorCell[1] * textFont.pHeight;
+		memcpy(lastHashes, raster.tileHashes, sizeof(lastHashes));
+
+		CyBeginEdit(&box.file);
+		CyWriteCodepointInChunkedFile(&box.file, 0x41 + (f % 26));
+		CyCommitEdit(&box.file);
+		CyRefreshEditorBox(&box);
+		drawFrame();
+		seconds += raster.seconds;
+		dirtyTiles += raster.dirtyTiles;
+
+		checkDirtyTiles("typing", lastHashes, (uint32_m)left / RASTER_TILE_SIZE,
+			(uint32_m)top / RASTER_TILE_SIZE, (uint32_m)(top + textFont.pHeight) / RASTER_TILE_SIZE
+		);
+		checkFrame("typing");
+	}
+	CyLog("Typing:      %8.4f ms per frame (%8.2f tiles per frame)\n",
+		(seconds * 1000.0) / RASTER_FRAMES, (double)dirtyTiles / RASTER_FRAMES
+	);
+
+	// Typing a combining mark gives the codepoint before the cursor a second
+	// glyph, which should change the pixels of its cell
+	// (The cursor is moved back into view first, after the first codepoint)
+	CySetCursorInChunkedFile(&box.file, 1);
+	CyRefreshEditorBox(&box);
+	drawFrame();
+	uint32_m glyphs = box.numGlyphs;
+	uint32_m markLeft = (uint32_m)((float)(box.cursorCell[0] - 1) * textFont.pAdvanceWidth);
+	uint32_m markTop = (uint32_m)((float)box.cursorCell[1] * textFont.pHeight);
+	uint32_m markWidth = (uint32_m)textFont.pAdvanceWidth;
+	uint32_m markHeight = (uint32_m)textFont.pHeight;
+	muByte* lastPixels = (muByte*)malloc(RASTER_WIDTH * RASTER_HEIGHT * 4);
+	if (!lastPixels) {
+		CyLog("Failed to allocate the last frame; exiting\n");
+		return -1;
+	}
+	memcpy(lastPixels, raster.pixels, RASTER_WIDTH * RASTER_HEIGHT * 4);
+
+	CyBeginEdit(&box.file);
+	CyWriteCodepointInChunkedFile(&box.file, 0x0301);
+	CyCommitEdit(&box.file);
+	CyRefreshEditorBox(&box);
+	drawFrame();
+
+	muBool marked = MU_FALSE;
+	for (uint32_m y = markTop; y < markTop + markHeight && !marked; ++y) {
+		size_m row = (((size_m)y * RASTER_WIDTH) + markLeft) * 4;
+		marked = memcmp(&lastPixels[row], &raster.pixels[row], markWidth * 4) != 0;
+	}
+	free(lastPixels);
+	CyLog("Mark:        %" PRIu32 " glyphs drawn, %" PRIu32 " before\n", box.numGlyphs, glyphs);
+	if (box.numGlyphs != glyphs + 1 || !marked) {
+		CyLog("FAILED mark: the mark's glyph wasn't drawn over its cell\n");
+		++failures;
+	}
+	checkFrame("mark");
+
+	// Nothing changed, so nothing should be redrawn
+	drawFrame();
+	CyLog("Unchanged:   %8.4f ms (%" PRIu32 " tiles)\n", raster.seconds * 1000.0, raster.dirtyTiles);
+	if (raster.dirtyTiles != 0) {
+		CyLog("FAILED unchanged: %" PRIu32 " tiles redrawn\n", raster.dirtyTiles);
+		++failures;
+	}
+	checkFrame("unchanged");
+
+	if (CyWriteRasterPPM(&raster, RASTER_PPM)) {
+		CyLog("Wrote the last frame to \"" RASTER_PPM "\"\n");
+	} else {
+		CyLog("Failed to write the last frame to \"" RASTER_PPM "\"\n");
+	}
+	CyLog("\n");
+
+	// Destroy rasterizer and editor box
+	CyLog("Destroying rasterizer...\n");
+	CyDestroyRaster(&raster);
+	CyDestroyRaster(&reference);
+	CyLog("Destroying editor box...\n");
+	CyDestroyEditorBox(&box);
+
+	// Destroy stuff
+	CyDeloadRequiredFonts();
+	CyGfxTerm();
+
+	if (failures != 0) {
+		CyLog("%" PRIu32 " checks failed\n", failures);
+		return -1;
+	}
+	CyLog("Successful\n");
+	return 0;
+}
+
@@ -0,0 +1,352 @@
+// segmentation.c
+// Checks Unicode segmentation against the official break tests, from every
+// starting offset, then benchmarks it, comparing the generated two-stage
+// property tables against a naive binary search over property ranges
+
+#include "editor/textBuffer.h"
+#include "core/log.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+
+// Amount of codepoints of text to benchmark with
+#define BENCH_CODEPOINTS 4000000
+// Amount of times to go over the text
+#define BENCH_PASSES 5
+// Official break tests, relative to the root of the repository; the
+// files from the UCD's auxiliary directory can be dropped in as they are
+#define GRAPHEME_BREAK_TEST "tests/data/GraphemeBreakTest.txt"
+#define WORD_BREAK_TEST "tests/data/WordBreakTest.txt"
+// Most codepoints of a single break test
+#define BREAK_TEST_CODEPOINTS 64
+
+/* Naive lookup */
+
+	// A range of codepoints with the same properties
+	struct NaiveRange {
+		uint32_m first;
+		uint16_m properties;
+	};
+	typedef struct NaiveRange NaiveRange;
+
+	NaiveRange* naiveRanges = 0;
+	uint32_m naiveRangeCount = 0;
+
+	// Builds the ranges from the tables, as they'd otherwise be written out
+	muBool buildNaiveRanges(void) {
+		naiveRanges = (NaiveRange*)malloc(sizeof(NaiveRange) * 0x110000);
+		if (!naiveRanges) {
+			return MU_FALSE;
+		}
+
+		for (uint32_m c = 0; c < 0x110000; ++c) {
+			uint16_m properties = CyGetUnicodeProperties(c);
+			if (naiveRangeCount == 0 || naiveRanges[naiveRangeCount-1].properties != properties) {
+				naiveRanges[naiveRangeCount].first = c;
+				naiveRanges[naiveRangeCount].properties = properties;
+				++naiveRangeCount;
+			}
+		}
+		return MU_TRUE;
+	}
+
+	// Looks up properties by binary searching the ranges
+	uint16_m naiveProperties(uint32_m codepoint) {
+		uint32_m low = 0, high = naiveRangeCount;
+		while (high - low > 1) {
+			uint32_m mid = (low + high) / 2;
+			if (naiveRanges[mid].first <= codepoint) {
+				low = mid;
+			} else {
+				high = mid;
+			}
+		}
+		return naiveRanges[low].properties;
+	}
+
+/* Break tests */
+
+	// Parses a line of a break test into its codepoints, and whether or not
+	// there's a break before each one and at the end
+	// Returns the amount of codepoints; 0 if the line isn't a test
+	uint32_m parseBreakTest(const char* line, uint32_m* codepoints, muBool* breaks) {
+		uint32_m count = 0;
+		const unsigned char* c = (const unsigned char*)line;
+		while (*c != 0 && *c != '#') {
+			// U+00F7 (÷) is a break, and U+00D7 (×) isn't
+			if (c[0] == 0xC3 && (c[1] == 0xB7 || c[1] == 0x97)) {
+				breaks[count] = c[1] == 0xB7;
+				c += 2;
+				continue;
+			}
+			if (!isxdigit(*c)) {
+				++c;
+				continue;
+			}
+			if (count == BREAK_TEST_CODEPOINTS) {
+				return 0;
+			}
+			char* end;
+			codepoints[count++] = (uint32_m)strtoul((const char*)c, &end, 16);
+			c = (const unsigned char*)end;
+		}
+		return count;
+	}
+
+	// Checks the boundaries found in a file of a test's codepoints against
+	// its breaks, starting from each offset; iterating from anywhere should
+	// start at the last break at or before it, then find the same ones
+	muBool checkBreakTest(const uint32_m* codepoints, const muBool* breaks, uint32_m count, muBool words) {
+		CyChunkedFile test;
+		if (!CyCreateEmptyChunkedFile(&test)) {
+			return MU_FALSE;
+		}
+		CyBeginEdit(&test);
+		for (uint32_m i = 0; i < count; ++i) {
+			CyWriteCodepointInChunkedFile(&test, codepoints[i]);
+		}
+		CyCommitEdit(&test);
+
+		muBool passed = MU_TRUE;
+		for (uint32_m start = 0; start <= count && passed; ++start) {
+			CySegmentIterator iter;
+			if (words) {
+				CyBeginWordsInChunkedFile(&test, start, &iter);
+			} else {
+				CyBeginGraphemesInChunkedFile(&test, start, &iter);
+			}
+			uint32_m expected = start;
+			while (expected > 0 && !breaks[expected]) {
+				--expected;
+			}
+			passed = iter.offset == expected;
+
+			while (passed && (words ? CyGetNextWordInChunkedFile(&iter) : CyGetNextGraphemeInChunkedFile(&iter))) {
+				do {
+					++expected;
+				} while (expected < count && !breaks[expected]);
+				passed = iter.offset == expected;
+			}
+			passed = passed && expected == count;
+		}
+
+		CyDestroyChunkedFile(&test);
+		return passed;
+	}
+
+	// Runs each test of a break test file, logging the ones that fail
+	// Returns the amount that failed, or 0xFFFFFFFF if it couldn't be read
+	uint32_m runBreakTests(const char* path, muBool words) {
+		FILE* f = fopen(path, "r");
+		if (!f) {
+			CyLog("Failed to open \"%s\"; run this from the root of the repository\n", path);
+			return 0xFFFFFFFF;
+		}
+
+		char line[1024];
+		uint32_m codepoints[BREAK_TEST_CODEPOINTS];
+		muBool breaks[BREAK_TEST_CODEPOINTS + 1];
+		uint32_m tests = 0, failures = 0;
+		while (fgets(line, sizeof(line), f)) {
+			uint32_m count = parseBreakTest(line, codepoints, breaks);
+			if (count == 0) {
+				continue;
+			}
+			++tests;
+			if (!checkBreakTest(codepoints, breaks, count, words)) {
+				CyLog("FAILED %s", line);
+				++failures;
+			}
+		}
+		fclose(f);
+
+		CyLog("%-34s %" PRIu32 " of %" PRIu32 " tests failed\n", path, failures, tests);
+		return (tests == 0) ? 0xFFFFFFFF : failures;
+	}
+
+/* Text */
+
+	uint32_m* text = 0;
+
+	// Pieces of text to build the benchmark text out of, zero-terminated
+	const uint32_m pieces[][8] = {
+		{ 'T', 'h', 'e', ' ', 0 },
+		{ 'q', 'u', 'i', 'c', 'k', ',', ' ', 0 },
+		{ 'd', 'o', 'n', '\'', 't', ' ', 0 },
+		{ '3', '.', '1', '4', ' ', 0 },
+		{ 'e', 0x301, 't', 'e', 0x301, ' ', 0 },
+		{ 0x41F, 0x440, 0x438, 0x432, 0x435, 0x442, ' ', 0 },
+		{ 0x65E5, 0x672C, 0x8A9E, 0x3002, 0 },
+		{ 0x30AB, 0x30BF, 0x30AB, 0x30CA, ' ', 0 },
+		{ 0x915, 0x94D, 0x937, 0x93F, ' ', 0 },
+		{ 0x1F468, 0x200D, 0x1F469, 0x200D, 0x1F467, ' ', 0 },
+		{ 0x1F1EF, 0x1F1F5, ' ', 0 },
+		{ 0xD55C, 0x1100, 0x1161, 0x11A8, ' ', 0 },
+		{ 13, 0 },
+	};
+
+	// Fills the text with random pieces
+	muBool buildText(void) {
+		text = (uint32_m*)malloc(sizeof(uint32_m) * BENCH_CODEPOINTS);
+		if (!text) {
+			return MU_FALSE;
+		}
+
+		srand(1);
+		uint32_m i = 0;
+		while (i < BENCH_CODEPOINTS) {
+			const uint32_m* piece = pieces[rand() % (sizeof(pieces) / sizeof(pieces[0]))];
+			for (uint32_m p = 0; piece[p] != 0 && i < BENCH_CODEPOINTS; ++p) {
+				text[i++] = piece[p];
+			}
+		}
+		return MU_TRUE;
+	}
+
+/* Benchmarks */
+
+	double secondsSince(clock_t start) {
+		return (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+	}
+
+	void report(const char* name, double seconds, uint32_m result) {
+		double rate = ((double)BENCH_CODEPOINTS * BENCH_PASSES) / seconds / 1000000.0;
+		CyLog("%-34s %8.3f s  %8.1f M codepoints/s  (%" PRIu32 ")\n", name, seconds, rate, result);
+	}
+
+	// Sums properties so the lookups can't be optimized out
+	uint32_m lookupTable(void) {
+		uint32_m sum = 0;
+		for (uint32_m i = 0; i < BENCH_CODEPOINTS; ++i) {
+			sum += CyGetUnicodeProperties(text[i]);
+		}
+		return sum;
+	}
+	uint32_m lookupNaive(void) {
+		uint32_m sum = 0;
+		for (uint32_m i = 0; i < BENCH_CODEPOINTS; ++i) {
+			sum += naiveProperties(text[i]);
+		}
+		return sum;
+	}
+
+	// Counts grapheme clusters of the flat text
+	uint32_m countGraphemes(uint16_m (*lookup)(uint32_m)) {
+		CyGraphemeState state;
+		CyResetGraphemeState(&state);
+		uint32_m count = 1;
+		for (uint32_m i = 0; i < BENCH_CODEPOINTS; ++i) {
+			count += CyGraphemeBreakBefore(&state, lookup(text[i]));
+		}
+		return count;
+	}
+
+	// Counts words of the flat text
+	uint32_m countWords(uint16_m (*lookup)(uint32_m)) {
+		CyWordState state;
+		CyResetWordState(&state);
+		uint32_m count = 1;
+		for (uint32_m i = 0; i < BENCH_CODEPOINTS; ++i) {
+			uint16_m properties = lookup(text[i]);
+			uint8_m next = WORD_BREAK_OTHER;
+			if (CyWordBreakNeedsNext(UNICODE_WORD_BREAK(properties))) {
+				for (uint32_m j = i+1; j < BENCH_CODEPOINTS; ++j) {
+					next = UNICODE_WORD_BREAK(lookup(text[j]));
+					if (next != WORD_BREAK_EXTEND && next != WORD_BREAK_FORMAT && next != WORD_BREAK_ZWJ) {
+						break;
+					}
+				}
+			}
+			count += CyWordBreakBefore(&state, properties, next);
+		}
+		return count;
+	}
+
+	CyChunkedFile file;
+
+	// Counts grapheme clusters of the chunked file through its iterator
+	uint32_m countFileGraphemes(void) {
+		CySegmentIterator iter;
+		CyBeginGraphemesInChunkedFile(&file, 0, &iter);
+		uint32_m count = 0;
+		while (CyGetNextGraphemeInChunkedFile(&iter)) {
+			++count;
+		}
+		return count;
+	}
+
+	// Counts words of the chunked file through its iterator
+	uint32_m countFileWords(void) {
+		CySegmentIterator iter;
+		CyBeginWordsInChunkedFile(&file, 0, &iter);
+		uint32_m count = 0;
+		while (CyGetNextWordInChunkedFile(&iter)) {
+			++count;
+		}
+		return count;
+	}
+
+	// Runs a benchmark BENCH_PASSES times
+	#define BENCH(name, expression) { \
+		uint32_m result = 0; \
+		clock_t start = clock(); \
+		for (uint32_m pass = 0; pass < BENCH_PASSES; ++pass) { \
+			result = (expression); \
+		} \
+		report(name, secondsSince(start), result); \
+	}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (segmentation.c) ==\n\n");
+
+	// Every break of the official tests should be found
+	uint32_m graphemeFailures = runBreakTests(GRAPHEME_BREAK_TEST, MU_FALSE);
+	uint32_m wordFailures = runBreakTests(WORD_BREAK_TEST, MU_TRUE);
+	if (graphemeFailures != 0 || wordFailures != 0) {
+		CyLog("Segmentation doesn't pass the break tests; exiting\n");
+		return -1;
+	}
+	CyLog("\n");
+
+	if (!buildNaiveRanges() || !buildText()) {
+		CyLog("Failed to allocate; exiting\n");
+		return -1;
+	}
+	CyLog("%" PRIu32 " property ranges for the naive lookup\n", naiveRangeCount);
+	CyLog("%d codepoints of text, %d passes each\n\n", BENCH_CODEPOINTS, BENCH_PASSES);
+
+	// Property lookups alone
+	BENCH("Property lookup (table)", lookupTable());
+	BENCH("Property lookup (naive)", lookupNaive());
+
+	// Segmenting flat text; the counts should be the same either way
+	BENCH("Grapheme clusters (table)", countGraphemes(CyGetUnicodeProperties));
+	BENCH("Grapheme clusters (naive)", countGraphemes(naiveProperties));
+	BENCH("Words (table)", countWords(CyGetUnicodeProperties));
+	BENCH("Words (naive)", countWords(naiveProperties));
+
+	// Segmenting a chunked file through its iterator
+	if (!CyCreateEmptyChunkedFile(&file)) {
+		CyLog("Failed to create chunked file; exiting\n");
+		return -1;
+	}
+	CyBeginEdit(&file);
+	for (uint32_m i = 0; i < BENCH_CODEPOINTS; ++i) {
+		CyWriteCodepointInChunkedFile(&file, text[i]);
+	}
+	CyCommitEdit(&file);
+
+	BENCH("Grapheme clusters (chunked file)", countFileGraphemes());
+	BENCH("Words (chunked file)", countFileWords());
+
+	CyDestroyChunkedFile(&file);
+	free(text);
+	free(naiveRanges);
+
+	CyLog("\nSuccessful\n");
+	return 0;
+}
+
@@ -98,6 +98,13 @@ void printFileInfo(void) {
 	}
 
 	CyLog("\n\n");
+
+	// Print statistics
+	CyTextStats stats;
+	CyGetChunkedFileStats(&file, &stats);
+	CyLog("Codepoints: %" PRIu32 ", lines: %" PRIu32 ", words: %" PRIu32 ", non-ASCII: %" PRIu32 "\n\n",
+		stats.codepoints, stats.newlines+1, stats.words, stats.nonASCII
+	);
 }
 
 void textInputCallback(muWindow win, uint8_m* data) {
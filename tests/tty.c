@@ -0,0 +1,454 @@
+// tty.c
+// Tests the terminal frontend against a pseudo-terminal: keys are typed
+// into it, the frames written back are played on a small terminal
+// emulator, and what it shows is compared to the editor box
+
+// For posix_openpt and friends
+#define _XOPEN_SOURCE 600
+
+// Include files
+#include "core/gfx.h"
+#include "core/string.h"
+#include "editor/visualBuffer.h"
+#include "editor/input.h"
+#include "rendering/tty.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Size of the terminal, in cells
+#define TEST_COLUMNS 80
+#define TEST_ROWS 24
+// Amount of lines in the file
+#define TEST_LINES 2000
+
+CyEditorBox box;
+CyInputQueue queue;
+CyTty tty;
+
+// Both ends of the pseudo-terminal
+int master;
+int slave;
+
+// What the emulated terminal shows
+uint32_m screen[TEST_ROWS][TEST_COLUMNS];
+// Its cursor, and whether the cursor is waiting to wrap
+uint32_m cursorX;
+uint32_m cursorY;
+muBool wrapping;
+// Last codepoint written, for REP
+uint32_m lastCodepoint;
+// Sequences and bytes the emulator didn't understand
+uint32_m unknownSequences;
+
+// Clamps the emulator's cursor to the screen
+void clampCursor(void) {
+	wrapping = MU_FALSE;
+	if ((int32_m)cursorX < 0) cursorX = 0;
+	if ((int32_m)cursorY < 0) cursorY = 0;
+	if (cursorX >= TEST_COLUMNS) cursorX = TEST_COLUMNS - 1;
+	if (cursorY >= TEST_ROWS) cursorY = TEST_ROWS - 1;
+}
+
+// Scrolls the emulated terminal up a line, or down if up is false
+void emulateScroll(muBool up) {
+	if (up) {
+		memmove(screen[0], screen[1], sizeof(screen[0]) * (TEST_ROWS - 1));
+	} else {
+		memmove(screen[1], screen[0], sizeof(screen[0]) * (TEST_ROWS - 1));
+	}
+	uint32_m y = up ? TEST_ROWS - 1 : 0;
+	for (uint32_m x = 0; x < TEST_COLUMNS; ++x) {
+		screen[y][x] = 0x20;
+	}
+}
+
+// Writes a codepoint at the emulator's cursor
+void emulateCodepoint(uint32_m codepoint) {
+	if (wrapping) {
+		cursorX = 0;
+		// Writing past the bottom right would scroll, which the
+		// frontend should never do
+		if (++cursorY == TEST_ROWS) {
+			++unknownSequences;
+			cursorY = TEST_ROWS - 1;
+		}
+		wrapping = MU_FALSE;
+	}
+	screen[cursorY][cursorX] = codepoint;
+	lastCodepoint = codepoint;
+	if (cursorX == TEST_COLUMNS - 1) {
+		wrapping = MU_TRUE;
+	} else {
+		++cursorX;
+	}
+}
+
+// Plays a control sequence's final byte with its parameters
+void emulateSequence(muByte final, uint32_m* params, uint32_m numParams, muBool private) {
+	uint32_m n = (numParams > 0 && params[0] > 0) ? params[0] : 1;
+	if (private) {
+		// Showing and hiding the cursor
+		if (final != 'h' && final != 'l') {
+			++unknownSequences;
+		}
+		return;
+	}
+	switch (final) {
+		default: ++unknownSequences; break;
+		case 'm': break;
+		case 'H': {
+			cursorY = n - 1;
+			cursorX = (numParams > 1 && params[1] > 0) ? params[1] - 1 : 0;
+			clampCursor();
+		} break;
+		case 'A': cursorY -= n; clampCursor(); break;
+		case 'B': cursorY += n; clampCursor(); break;
+		case 'C': cursorX += n; clampCursor(); break;
+		case 'D': cursorX -= n; clampCursor(); break;
+		case '@': {
+			for (uint32_m x = TEST_COLUMNS; x-- > cursorX;) {
+				screen[cursorY][x] = (x >= cursorX + n) ? screen[cursorY][x - n] : 0x20;
+			}
+			wrapping = MU_FALSE;
+		} break;
+		case 'P': {
+			for (uint32_m x = cursorX; x < TEST_COLUMNS; ++x) {
+				screen[cursorY][x] = (x + n < TEST_COLUMNS) ? screen[cursorY][x + n] : 0x20;
+			}
+			wrapping = MU_FALSE;
+		} break;
+		case 'L': case 'M': {
+			// Inserting or deleting lines shifts the rows below
+			for (uint32_m i = 0; i < n; ++i) {
+				uint32_m y = cursorY;
+				if (final == 'L') {
+					memmove(screen[y + 1], screen[y], sizeof(screen[0]) * (TEST_ROWS - 1 - y));
+				} else {
+					memmove(screen[y], screen[y + 1], sizeof(screen[0]) * (TEST_ROWS - 1 - y));
+					y = TEST_ROWS - 1;
+				}
+				for (uint32_m x = 0; x < TEST_COLUMNS; ++x) {
+					screen[y][x] = 0x20;
+				}
+			}
+			cursorX = 0;
+			wrapping = MU_FALSE;
+		} break;
+		case 'K': {
+			for (uint32_m x = cursorX; x < TEST_COLUMNS; ++x) {
+				screen[cursorY][x] = 0x20;
+			}
+			wrapping = MU_FALSE;
+		} break;
+		case 'J': {
+			for (uint32_m y = 0; y < TEST_ROWS; ++y) {
+				for (uint32_m x = 0; x < TEST_COLUMNS; ++x) {
+					screen[y][x] = 0x20;
+				}
+			}
+		} break;
+		case 'b': {
+			for (uint32_m i = 0; i < n; ++i) {
+				emulateCodepoint(lastCodepoint);
+			}
+		} break;
+	}
+}
+
+// Plays bytes written to the terminal
+// Sequences are assumed to never be split between calls, since each
+// frame is written at once
+void emulate(const muByte* data, uint32_m length) {
+	uint32_m i = 0;
+	while (i < length) {
+		muByte byte = data[i];
+		if (byte == 0x1B && i + 1 < length && data[i+1] == '[') {
+			uint32_m params[4] = { 0, 0, 0, 0 };
+			uint32_m numParams = 0;
+			muBool private = MU_FALSE;
+			i += 2;
+			while (i < length && data[i] >= 0x30 && data[i] <= 0x3F) {
+				if (data[i] == '?') {
+					private = MU_TRUE;
+				} else if (data[i] == ';') {
+					++numParams;
+				} else if (numParams < 4) {
+					params[numParams] = (params[numParams] * 10) + (data[i] - '0');
+				}
+				++i;
+			}
+			if (i == length) {
+				++unknownSequences;
+				return;
+			}
+			// A parameter was read if anything came before the final
+			if (data[i-1] != '[') {
+				++numParams;
+			}
+			emulateSequence(data[i++], params, numParams, private);
+		} else if (byte == 0x1B && i + 1 < length && data[i+1] == 'M') {
+			// Reverse index
+			if (cursorY == 0) {
+				emulateScroll(MU_FALSE);
+			} else {
+				--cursorY;
+			}
+			wrapping = MU_FALSE;
+			i += 2;
+		} else if (byte == '\r') {
+			cursorX = 0;
+			wrapping = MU_FALSE;
+			++i;
+		} else if (byte == '\n') {
+			if (cursorY == TEST_ROWS - 1) {
+				emulateScroll(MU_TRUE);
+			} else {
+				++cursorY;
+			}
+			wrapping = MU_FALSE;
+			++i;
+		} else if (byte == '\b') {
+			--cursorX;
+			clampCursor();
+			++i;
+		} else if (byte < 0x20) {
+			++unknownSequences;
+			++i;
+		} else {
+			uint32_m codepoint = 0;
+			uint8_m read = CyUTF8CodepointDecode(&codepoint, (muByte*)&data[i], length - i);
+			if (read == 0) {
+				++unknownSequences;
+				read = 1;
+			}
+			emulateCodepoint(codepoint);
+			i += read;
+		}
+	}
+}
+
+// Reads what the frontend wrote to the terminal and plays it
+// Returns the amount of bytes read
+uint32_m readTerminal(void) {
+	muByte data[4096];
+	uint32_m total = 0;
+	ssize_t length;
+	while ((length = read(master, data, sizeof(data))) > 0) {
+		emulate(data, (uint32_m)length);
+		total += (uint32_m)length;
+	}
+	return total;
+}
+
+// Counts the cells the emulated terminal shows differently than the box,
+// plus 1 if the cursor is elsewhere
+uint32_m countMismatches(void) {
+	uint32_m mismatches = 0;
+	for (uint32_m y = 0; y < TEST_ROWS; ++y) {
+		for (uint32_m x = 0; x < TEST_COLUMNS; ++x) {
+			uint32_m codepoint = CyGetEditorBoxCell(&box, x, y)->codepoint;
+			if (screen[y][x] != codepoint) {
+				++mismatches;
+			}
+		}
+	}
+	if (box.cursorVisible && (cursorX != box.cursorCell[0] || cursorY != box.cursorCell[1])) {
+		++mismatches;
+	}
+	return mismatches;
+}
+
+// Keys typed, in order, as the terminal sends them
+const char* keys[] = {
+	"\x1b[6~", "\x1b[6~", "\x1b[B", "\x1b[B", "\x1b[H",
+	"h", "e", "l", "l", "o", " ", "w", "o", "r", "l", "d",
+	"\x7f", "\x7f", "\x7f", "\x7f", "\x7f",
+	"\x1b[H", "\x1b[1;5C", "\x1b[1;5C", "x", "y", "z",
+	"\r", "\x1b[A", "\x1bOF", "\t", "\xc3\xa9", "\xe2\x82\xac", "!",
+	"\x1b[D", "\x1b[D", "\x1b[D", "\x1b[C",
+	"\x1b[5~", "\x1b[B", "\x1b[B", "\x1b[1;5D",
+	"\r", "\r", "\x7f", "\x7f",
+	"\x1b[1;5F", "\x1b[1;5H",
+};
+#define NUM_KEYS (sizeof(keys) / sizeof(keys[0]))
+
+// Opens the pseudo-terminal, in raw mode, with the master end not
+// blocking so that it can be read until it's empty
+muBool openTerminal(void) {
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+		return MU_FALSE;
+	}
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if (slave < 0) {
+		return MU_FALSE;
+	}
+
+	struct termios mode;
+	tcgetattr(slave, &mode);
+	mode.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+	mode.c_oflag &= ~OPOST;
+	mode.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	mode.c_cflag &= ~(CSIZE | PARENB);
+	mode.c_cflag |= CS8;
+	mode.c_cc[VMIN] = 0;
+	mode.c_cc[VTIME] = 0;
+	tcsetattr(slave, TCSANOW, &mode);
+
+	fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+	return MU_TRUE;
+}
+
+// Types a key into the terminal and reads it back as input
+void typeKey(const char* key) {
+	if (write(master, key, strlen(key)) < 0) {
+		return;
+	}
+	// The terminal passes the bytes on right away in raw mode, but they
+	// may arrive in pieces
+	muByte data[64];
+	uint32_m total = 0;
+	while (total < strlen(key)) {
+		ssize_t length = read(slave, data, sizeof(data));
+		if (length > 0) {
+			CyReadTtyInput(&tty, &queue, data, (uint32_m)length);
+			total += (uint32_m)length;
+		}
+	}
+}
+
+// Draws the box to the terminal and checks what it shows
+// Returns the amount of mismatched cells
+uint32_m drawFrame(void) {
+	CyRefreshEditorBox(&box);
+	CyDrawTty(&tty, &box);
+	readTerminal();
+	return countMismatches();
+}
+
+int main(void) {
+	CyLog("\n== minCy v1.0.0 (tty.c) ==\n\n");
+
+	// Init. stuff
+	CyGfxInitHeadless(1920, 1080);
+	CyLoadRequiredFonts();
+
+	CyLog("Initializing point size to 16...\n");
+	CySetFontPointSize(&textFont, 16.f);
+
+	CyLog("Getting basic codepoints...\n");
+	if (!CyFontLoadCodepoint(&textFont, 0x20)) {
+		CyLog("Failed to get space codepoint; exiting\n");
+		return -1;
+	}
+	if (!CyFontLoadCodepoint(&textFont, 0x25A1)) {
+		CyLog("Failed to get missing codepoint; exiting\n");
+		return -1;
+	}
+	CyLog("\n");
+
+	// Create an editor box of exactly the terminal's size
+	CyLog("Creating %dx%d editor box\n", TEST_COLUMNS, TEST_ROWS);
+	if (!CyInitEditorBox(&box, &textFont, (TEST_COLUMNS + .5f) * textFont.pAdvanceWidth, (TEST_ROWS + .5f) * textFont.pHeight)) {
+		CyLog("Failed to create editor box; exiting\n");
+		return -1;
+	}
+	if (box.textDim[0] != TEST_COLUMNS || box.textDim[1] != TEST_ROWS) {
+		CyLog("Editor box is %" PRIu32 "x%" PRIu32 "; exiting\n", box.textDim[0], box.textDim[1]);
+		return -1;
+	}
+	CyInitInputQueue(&queue, &box.file);
+
+	// Open the terminal
+	CyLog("Opening pseudo-terminal\n");
+	if (!openTerminal()) {
+		CyLog("Failed to open pseudo-terminal; exiting\n");
+		return -1;
+	}
+	FILE* out = fdopen(slave, "w");
+	if (!out || !CyInitTty(&tty, out, TEST_COLUMNS, TEST_ROWS)) {
+		CyLog("Failed to create terminal; exiting\n");
+		return -1;
+	}
+
+	// Fill the file with lines of varying length
+	CyLog("Writing %d lines...\n", TEST_LINES);
+	const char* words = "the quick brown fox jumps over the lazy dog while minCy keeps up ";
+	CyBeginEdit(&box.file);
+	for (uint32_m l = 0; l < TEST_LINES; ++l) {
+		uint32_m length = (l * 7) % 90;
+		for (uint32_m c = 0; c < length; ++c) {
+			CyWriteCodepointInChunkedFile(&box.file, (uint8_m)words[(l + c) % 65]);
+		}
+		CyWriteCodepointInChunkedFile(&box.file, 13);
+	}
+	CyMoveToStartInChunkedFile(&box.file);
+	CyCommitEdit(&box.file);
+	CyLog("\n");
+
+	// First frame writes everything
+	uint32_m mismatches = drawFrame();
+	CyLog("First frame: %zu bytes, %" PRIu32 " mismatched cells\n", (size_t)tty.frameBytes, mismatches);
+
+	// Type each key, drawing a frame after each
+	size_m maxBytes = 0;
+	uint64_m keyBytes = 0;
+	for (uint32_m k = 0; k < NUM_KEYS; ++k) {
+		typeKey(keys[k]);
+		CyApplyInput(&queue);
+		CyScrollEditorBoxToCursor(&box);
+		uint32_m keyMismatches = drawFrame();
+		if (keyMismatches > 0) {
+			CyLog("Key %" PRIu32 ": %" PRIu32 " mismatched cells\n", k, keyMismatches);
+		}
+		mismatches += keyMismatches;
+		keyBytes += tty.frameBytes;
+		if (tty.frameBytes > maxBytes) {
+			maxBytes = tty.frameBytes;
+		}
+	}
+	CyLog("Keys: %d, bytes per key %8.2f (at most %zu)\n", (int)NUM_KEYS, (double)keyBytes / NUM_KEYS, (size_t)maxBytes);
+
+	// Move down a line at a time past the bottom of the view, scrolling it
+	uint64_m scrollBytes = 0;
+	for (uint32_m l = 0; l < TEST_ROWS * 2; ++l) {
+		typeKey("\x1b[B");
+		CyApplyInput(&queue);
+		CyScrollEditorBoxToCursor(&box);
+		mismatches += drawFrame();
+		scrollBytes += tty.frameBytes;
+	}
+	CyLog("Scrolling: bytes per line %8.2f\n", (double)scrollBytes / (TEST_ROWS * 2));
+
+	// Compare with writing the whole screen again
+	CyInvalidateTty(&tty);
+	mismatches += drawFrame();
+	CyLog("Full redraw: %zu bytes\n", (size_t)tty.frameBytes);
+	CyLog("Mismatched cells: %" PRIu32 ", unknown sequences: %" PRIu32 "\n", mismatches, unknownSequences);
+	CyLog("\n");
+
+	// Destroy terminal and editor box
+	CyLog("Destroying terminal...\n");
+	CyDestroyTty(&tty);
+	fclose(out);
+	close(master);
+	CyLog("Destroying editor box...\n");
+	CyDestroyEditorBox(&box);
+
+	// Destroy stuff
+	CyDeloadRequiredFonts();
+	CyGfxTerm();
+
+	if (mismatches > 0 || unknownSequences > 0) {
+		CyLog("Failed\n");
+		return -1;
+	}
+	CyLog("Successful\n");
+	return 0;
+}
+
@@ -0,0 +1,192 @@
+# unicodeTables.py
+# Generates src/core/unicodeTables.c from the Unicode Character Database
+#
+# Usage: python3 tools/unicodeTables.py <ucd directory> [output file]
+#
+# The UCD directory is expected to be laid out like
+# https://www.unicode.org/Public/<version>/ucd/, and needs:
+#   auxiliary/GraphemeBreakProperty.txt
+#   auxiliary/WordBreakProperty.txt
+#   emoji/emoji-data.txt
+#   DerivedCoreProperties.txt
+#   EastAsianWidth.txt
+#   extracted/DerivedGeneralCategory.txt
+
+import os
+import sys
+
+MAX_CODEPOINT = 0x110000
+
+# Values have to match the ones in include/core/unicode.h
+GRAPHEME_BREAK = [
+	"Other", "CR", "LF", "Control", "Extend", "ZWJ", "Regional_Indicator", "Prepend",
+	"SpacingMark", "L", "V", "T", "LV", "LVT", "Extended_Pictographic",
+]
+INCB = ["None", "Consonant", "Linker", "Extend"]
+WORD_BREAK = [
+	"Other", "CR", "LF", "Newline", "Extend", "ZWJ", "Regional_Indicator", "Format",
+	"Katakana", "Hebrew_Letter", "ALetter", "Single_Quote", "Double_Quote", "MidNumLet",
+	"MidLetter", "MidNum", "Numeric", "ExtendNumLet", "WSegSpace",
+]
+# Cells taken up when displayed, in the order packed; one cell is the default
+WIDTH_NARROW = 0
+WIDTH_WIDE = 1
+WIDTH_ZERO = 2
+
+# Reads a UCD property file, calling fn(first, last, fields) for each entry
+def readProperty(path, fn):
+	with open(path, encoding="utf-8") as f:
+		for line in f:
+			line = line.split("#", 1)[0].strip()
+			if not line:
+				continue
+			fields = [field.strip() for field in line.split(";")]
+			codepoints = fields[0].split("..")
+			first = int(codepoints[0], 16)
+			last = int(codepoints[-1], 16)
+			fn(first, last, fields[1:])
+
+# Sets a range of a property array to a value, only where it's still the default
+def setRange(values, first, last, value, name):
+	for codepoint in range(first, last+1):
+		if values[codepoint] != 0 and values[codepoint] != value:
+			sys.exit("U+%04X has conflicting %s values" % (codepoint, name))
+		values[codepoint] = value
+
+def main():
+	if len(sys.argv) < 2:
+		sys.exit("usage: unicodeTables.py <ucd directory> [output file]")
+	ucd = sys.argv[1]
+	output = sys.argv[2] if len(sys.argv) > 2 else os.path.join(os.path.dirname(__file__), "..", "src", "core", "unicodeTables.c")
+
+	grapheme = [0] * MAX_CODEPOINT
+	incb = [0] * MAX_CODEPOINT
+	word = [0] * MAX_CODEPOINT
+	alnum = [0] * MAX_CODEPOINT
+	width = [WIDTH_NARROW] * MAX_CODEPOINT
+
+	def onGrapheme(first, last, fields):
+		setRange(grapheme, first, last, GRAPHEME_BREAK.index(fields[0]), "grapheme break")
+	readProperty(os.path.join(ucd, "auxiliary", "GraphemeBreakProperty.txt"), onGrapheme)
+
+	# Extended_Pictographic is folded into the grapheme break property, which
+	# works since every such codepoint is Other there
+	def onEmoji(first, last, fields):
+		if fields[0] == "Extended_Pictographic":
+			setRange(grapheme, first, last, GRAPHEME_BREAK.index("Extended_Pictographic"), "grapheme break")
+	readProperty(os.path.join(ucd, "emoji", "emoji-data.txt"), onEmoji)
+
+	def onWord(first, last, fields):
+		setRange(word, first, last, WORD_BREAK.index(fields[0]), "word break")
+	readProperty(os.path.join(ucd, "auxiliary", "WordBreakProperty.txt"), onWord)
+
+	def onDerived(first, last, fields):
+		if fields[0] == "InCB":
+			setRange(incb, first, last, INCB.index(fields[1]), "InCB")
+		elif fields[0] == "Alphabetic":
+			setRange(alnum, first, last, 1, "alphanumeric")
+	readProperty(os.path.join(ucd, "DerivedCoreProperties.txt"), onDerived)
+
+	# Wide and fullwidth codepoints take up two cells
+	def onWidth(first, last, fields):
+		if fields[0] in ("W", "F"):
+			setRange(width, first, last, WIDTH_WIDE, "width")
+	readProperty(os.path.join(ucd, "EastAsianWidth.txt"), onWidth)
+
+	# Marks and formatting codepoints take up none, combining with the
+	# codepoint before them, even if they're wide (except the soft hyphen,
+	# which is shown); so do the Hangul vowels and final consonants that
+	# make up a syllable with the jamo before them
+	def onCategory(first, last, fields):
+		if fields[0].startswith("N"):
+			setRange(alnum, first, last, 1, "alphanumeric")
+		elif fields[0] in ("Mn", "Me", "Cf"):
+			for codepoint in range(first, last+1):
+				if codepoint != 0xAD:
+					width[codepoint] = WIDTH_ZERO
+	readProperty(os.path.join(ucd, "extracted", "DerivedGeneralCategory.txt"), onCategory)
+	for codepoint in range(MAX_CODEPOINT):
+		if grapheme[codepoint] in (GRAPHEME_BREAK.index("V"), GRAPHEME_BREAK.index("T")):
+			width[codepoint] = WIDTH_ZERO
+
+	# Pack properties (see include/core/unicode.h) and give each distinct
+	# combination a class; class 0 is the default
+	classes = [0]
+	classOf = {0: 0}
+	codepointClasses = bytearray(MAX_CODEPOINT)
+	for codepoint in range(MAX_CODEPOINT):
+		packed = grapheme[codepoint] | (incb[codepoint] << 4) | (word[codepoint] << 6) | (alnum[codepoint] << 11) | (width[codepoint] << 12)
+		if packed not in classOf:
+			classOf[packed] = len(classes)
+			classes.append(packed)
+		codepointClasses[codepoint] = classOf[packed]
+	if len(classes) > 256:
+		sys.exit("too many property classes (%d)" % len(classes))
+
+	# Split into blocks, trying each block size to find the smallest tables
+	best = None
+	for shift in range(4, 11):
+		size = 1 << shift
+		blocks = []
+		blockOf = {}
+		stage1 = []
+		for start in range(0, MAX_CODEPOINT, size):
+			block = bytes(codepointClasses[start:start+size])
+			if block not in blockOf:
+				blockOf[block] = len(blocks)
+				blocks.append(block)
+			stage1.append(blockOf[block])
+		# Trailing blocks of default codepoints are left out
+		empty = blockOf.get(bytes(size))
+		while stage1 and stage1[-1] == empty:
+			stage1.pop()
+		stage1Width = 1 if len(blocks) <= 256 else 2
+		total = len(stage1) * stage1Width + len(blocks) * size
+		if best is None or total < best[0]:
+			best = (total, shift, stage1, blocks, stage1Width)
+	total, shift, stage1, blocks, stage1Width = best
+
+	with open(output, "w", newline="\r\n") as f:
+		f.write("// unicodeTables.c\n")
+		f.write("// Unicode property lookup tables\n")
+		f.write("// Generated by tools/unicodeTables.py; do not edit directly\n\n")
+		f.write("#include \"core/unicode.h\"\n\n")
+		f.write("// Codepoints are looked up in blocks of %d; %d bytes in total\n" % (1 << shift, total + len(classes) * 2))
+		f.write("#define UNICODE_BLOCK_SHIFT %d\n" % shift)
+		f.write("#define UNICODE_BLOCK_COUNT %d\n\n" % len(stage1))
+
+		f.write("// Packed properties of each class\n")
+		f.write("static const uint16_m CyUnicodeClasses[%d] = {" % len(classes))
+		for i, packed in enumerate(classes):
+			f.write(("\n\t" if i % 12 == 0 else " ") + "0x%04X," % packed)
+		f.write("\n};\n\n")
+
+		f.write("// Block of each range of codepoints\n")
+		f.write("static const %s CyUnicodeStage1[%d] = {" % ("uint8_m" if stage1Width == 1 else "uint16_m", len(stage1)))
+		for i, block in enumerate(stage1):
+			f.write(("\n\t" if i % 16 == 0 else " ") + "%d," % block)
+		f.write("\n};\n\n")
+
+		f.write("// Class of each codepoint within each block\n")
+		f.write("static const uint8_m CyUnicodeStage2[%d] = {" % (len(blocks) << shift))
+		i = 0
+		for block in blocks:
+			for value in block:
+				f.write(("\n\t" if i % 24 == 0 else " ") + "%d," % value)
+				i += 1
+		f.write("\n};\n\n")
+
+		f.write("// Gets the packed Unicode properties of a codepoint; O(1)\n")
+		f.write("uint16_m CyGetUnicodeProperties(uint32_m codepoint) {\n")
+		f.write("\tuint32_m block = codepoint >> UNICODE_BLOCK_SHIFT;\n")
+		f.write("\tif (block >= UNICODE_BLOCK_COUNT) {\n")
+		f.write("\t\treturn CyUnicodeClasses[0];\n")
+		f.write("\t}\n")
+		f.write("\tuint32_m index = ((uint32_m)CyUnicodeStage1[block] << UNICODE_BLOCK_SHIFT) | (codepoint & ((1 << UNICODE_BLOCK_SHIFT) - 1));\n")
+		f.write("\treturn CyUnicodeClasses[CyUnicodeStage2[index]];\n")
+		f.write("}\n\n")
+
+	print("%d classes, %d-codepoint blocks, %d blocks, %d bytes" % (len(classes), 1 << shift, len(blocks), total + len(classes) * 2))
+
+if __name__ == "__main__":
+	main()